@@ -0,0 +1,87 @@
+#include "alsa_sink.hpp"
+
+#if CHIP8_HAS_ALSA
+#include <alsa/asoundlib.h>
+#endif
+
+namespace emulator::audio
+{
+    AlsaSink::AlsaSink(std::string device) : device_(std::move(device))
+    {
+    }
+
+#if CHIP8_HAS_ALSA
+    namespace
+    {
+        // about 5 ms at common rates
+        constexpr snd_pcm_uframes_t RESTART_SILENCE = 256;
+    } // namespace
+
+    AlsaSink::~AlsaSink()
+    {
+        if (pcm_)
+        {
+            snd_pcm_t *pcm = static_cast<snd_pcm_t *>(pcm_);
+            snd_pcm_drain(pcm);
+            snd_pcm_close(pcm);
+        }
+    }
+
+    utils::Result AlsaSink::open(const std::uint32_t sample_rate)
+    {
+        snd_pcm_t *pcm = nullptr;
+        if (snd_pcm_open(&pcm, device_.c_str(), SND_PCM_STREAM_PLAYBACK, 0) < 0)
+        {
+            return utils::Result::Failure;
+        }
+        // let ALSA resample if the device does not do the rate natively
+        if (snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16, SND_PCM_ACCESS_RW_INTERLEAVED, 1, sample_rate, 1, DEVICE_LATENCY_US) < 0)
+        {
+            snd_pcm_close(pcm);
+            return utils::Result::Failure;
+        }
+        pcm_ = pcm;
+        return utils::Result::Success;
+    }
+
+    void AlsaSink::write(const std::int16_t *samples, const std::size_t count)
+    {
+        snd_pcm_t *pcm = static_cast<snd_pcm_t *>(pcm_);
+        std::size_t done = 0;
+        while (done < count)
+        {
+            const snd_pcm_sframes_t written = snd_pcm_writei(pcm, samples + done, count - done);
+            if (written < 0)
+            {
+                // an underrun or a suspend, start over and give up on these samples if that fails too
+                if (snd_pcm_recover(pcm, static_cast<int>(written), 1) < 0)
+                {
+                    return;
+                }
+                // restart with a little silence so the device does not run dry again straight away
+                const std::int16_t silence[RESTART_SILENCE] = {};
+                snd_pcm_writei(pcm, silence, RESTART_SILENCE);
+                continue;
+            }
+            done += static_cast<std::size_t>(written);
+        }
+    }
+#else
+    AlsaSink::~AlsaSink() = default;
+
+    utils::Result AlsaSink::open(const std::uint32_t)
+    {
+        return utils::Result::Failure;
+    }
+
+    void AlsaSink::write(const std::int16_t *, const std::size_t)
+    {
+    }
+#endif
+
+    bool AlsaSink::realtime() const
+    {
+        return true;
+    }
+
+} // namespace emulator::audio
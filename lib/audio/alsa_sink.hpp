@@ -0,0 +1,36 @@
+#pragma once
+
+#include "audio_sink.hpp"
+
+#include <string>
+
+#ifndef CHIP8_HAS_ALSA
+#define CHIP8_HAS_ALSA 0
+#endif
+
+namespace emulator::audio
+{
+    static constexpr bool ALSA_AVAILABLE = CHIP8_HAS_ALSA != 0;
+
+    // plays the samples on an ALSA playback device with a short device buffer
+    // without the ALSA development package the sink still exists but never opens
+    class AlsaSink : public AudioSink
+    {
+    public:
+        // how much audio the device itself buffers, the rest of the latency budget is the PCM ring
+        static constexpr unsigned DEVICE_LATENCY_US = 10000;
+
+        explicit AlsaSink(std::string device);
+        ~AlsaSink() override;
+
+        utils::Result open(const std::uint32_t sample_rate) override;
+        void write(const std::int16_t *samples, const std::size_t count) override;
+        bool realtime() const override;
+
+    private:
+        std::string device_;
+        // snd_pcm_t, kept opaque so the ALSA headers stay out of everything including this one
+        void *pcm_ = nullptr;
+    };
+
+} // namespace emulator::audio
@@ -0,0 +1,102 @@
+#include "audio_output.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace emulator::audio
+{
+    namespace
+    {
+        // the audio thread hands the sink this many milliseconds at a time, and checks a recording sink's ring this often
+        constexpr std::uint32_t CHUNK_MS = 5;
+    } // namespace
+
+    AudioOutput::AudioOutput(std::unique_ptr<AudioSink> sink, const Buzzer &buzzer)
+        : sink_(std::move(sink)), buzzer_(buzzer), realtime_(sink_->realtime()), block_(buzzer_.maxBlockSize()),
+          chunk_(buzzer_.sampleRate() * CHUNK_MS / 1000),
+          // a real time ring only needs room for a tick on top of the backlog, anything more would be skipped anyway
+          ring_(realtime_ ? 2 * (block_.size() + chunk_.size()) : RECORDING_RING_SIZE),
+          max_backlog_(block_.size() + buzzer_.sampleRate() * MAX_BACKLOG_MS / 1000)
+    {
+    }
+
+    AudioOutput::~AudioOutput()
+    {
+        stop();
+    }
+
+    void AudioOutput::start()
+    {
+        stop_.store(false, std::memory_order_relaxed);
+        thread_ = std::thread(&AudioOutput::loop, this);
+    }
+
+    void AudioOutput::stop()
+    {
+        stop_.store(true, std::memory_order_relaxed);
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    void AudioOutput::pushTick(const bool on, const std::uint8_t *pattern, const std::uint8_t pitch)
+    {
+        const std::size_t count = buzzer_.render(on, block_.data(), pattern, pitch);
+        const std::size_t pushed = ring_.push(block_.data(), count);
+        if (pushed < count)
+        {
+            dropped_.fetch_add(count - pushed, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t AudioOutput::droppedSamples() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t AudioOutput::skippedSamples() const
+    {
+        return skipped_.load(std::memory_order_relaxed);
+    }
+
+    void AudioOutput::loop()
+    {
+        if (realtime_)
+        {
+            // ticks arrive exactly as fast as the device plays them, a chunk of silence up front
+            // leaves the device that much margin when the next tick is a little late
+            std::fill(chunk_.begin(), chunk_.end(), std::int16_t{0});
+            sink_->write(chunk_.data(), chunk_.size());
+        }
+        while (!stop_.load(std::memory_order_relaxed))
+        {
+            if (realtime_ && ring_.size() > max_backlog_)
+            {
+                // the emulator ran ahead (unthrottled or catching up), keep the newest tick and skip the rest
+                skipped_.fetch_add(ring_.discard(ring_.size() - block_.size()), std::memory_order_relaxed);
+            }
+            const std::size_t count = ring_.pop(chunk_.data(), chunk_.size());
+            if (count > 0)
+            {
+                sink_->write(chunk_.data(), count);
+            }
+            else
+            {
+                // a device has a few milliseconds buffered, check back well before it runs dry
+                std::this_thread::sleep_for(realtime_ ? std::chrono::milliseconds(1) : std::chrono::milliseconds(CHUNK_MS));
+            }
+        }
+        // a recording gets everything the emulator made, a device has nothing left to catch up with
+        while (!realtime_)
+        {
+            const std::size_t count = ring_.pop(chunk_.data(), chunk_.size());
+            if (count == 0)
+            {
+                break;
+            }
+            sink_->write(chunk_.data(), count);
+        }
+    }
+
+} // namespace emulator::audio
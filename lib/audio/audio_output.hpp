@@ -0,0 +1,83 @@
+#pragma once
+
+#include "audio_sink.hpp"
+#include "buzzer.hpp"
+#include "spsc_ring.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace emulator::audio
+{
+    // turns sound timer ticks into buzzer samples and plays them on a sink from its own thread
+    // the emulation thread renders a block per tick into a preallocated buffer and pushes it into a lock-free ring,
+    // it never allocates, locks or waits; a full ring drops the block instead
+    class AudioOutput
+    {
+    public:
+        // how much audio a real time sink may fall behind by before the oldest samples are skipped
+        static constexpr std::uint32_t MAX_BACKLOG_MS = 10;
+        // samples queued for sinks that record rather than play, enough to ride out a slow disk
+        static constexpr std::size_t RECORDING_RING_SIZE = 1 << 16;
+
+        /**
+         * @param sink An opened sink, at the buzzer's sample rate
+         * @param buzzer The tone generator
+         */
+        AudioOutput(std::unique_ptr<AudioSink> sink, const Buzzer &buzzer = Buzzer());
+        ~AudioOutput();
+
+        AudioOutput(const AudioOutput &) = delete;
+        AudioOutput &operator=(const AudioOutput &) = delete;
+
+        /**
+         * @brief Start feeding the sink
+         */
+        void start();
+
+        /**
+         * @brief Stop feeding the sink, samples still queued for a recording sink are written first
+         */
+        void stop();
+
+        /**
+         * @brief Queue the samples of one 60 Hz tick, emulation thread only
+         * @param on Whether the sound timer was running during the tick
+         * @param pattern The XO-CHIP audio pattern to play, nullptr for the plain tone, see Buzzer::render
+         * @param pitch Its playback pitch
+         */
+        void pushTick(const bool on, const std::uint8_t *pattern = nullptr, const std::uint8_t pitch = DEFAULT_PITCH);
+
+        /**
+         * @brief Samples lost because the ring was full
+         */
+        std::uint64_t droppedSamples() const;
+
+        /**
+         * @brief Samples a real time sink skipped to keep the latency down
+         */
+        std::uint64_t skippedSamples() const;
+
+    private:
+        void loop();
+
+    private:
+        std::unique_ptr<AudioSink> sink_;
+        Buzzer buzzer_;
+        const bool realtime_;
+        // one tick of samples, filled by the emulation thread
+        std::vector<std::int16_t> block_;
+        // what the audio thread hands to the sink at a time
+        std::vector<std::int16_t> chunk_;
+        utils::SpscRing<std::int16_t> ring_;
+        const std::size_t max_backlog_;
+        std::atomic<std::uint64_t> dropped_{0};
+        std::atomic<std::uint64_t> skipped_{0};
+        std::atomic<bool> stop_{false};
+        std::thread thread_;
+    };
+
+} // namespace emulator::audio
@@ -0,0 +1,124 @@
+#include "audio_sink.hpp"
+#include "alsa_sink.hpp"
+
+namespace emulator::audio
+{
+    namespace
+    {
+        // size of the RIFF header of a plain PCM .wav file
+        constexpr std::size_t WAV_HEADER_SIZE = 44;
+
+        void putLittleEndian(std::ofstream &file, const std::uint32_t value, const int bytes)
+        {
+            for (int i = 0; i < bytes; ++i)
+            {
+                file.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+    } // namespace
+
+    utils::Result NullSink::open(const std::uint32_t)
+    {
+        return utils::Result::Success;
+    }
+
+    void NullSink::write(const std::int16_t *, const std::size_t)
+    {
+    }
+
+    bool NullSink::realtime() const
+    {
+        return false;
+    }
+
+    WavSink::WavSink(std::string path) : path_(std::move(path))
+    {
+    }
+
+    WavSink::~WavSink()
+    {
+        if (file_.is_open())
+        {
+            // the sizes in the header were unknown until now
+            file_.seekp(0);
+            writeHeader();
+        }
+    }
+
+    utils::Result WavSink::open(const std::uint32_t sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        file_.open(path_, std::ios::binary | std::ios::trunc);
+        if (!file_)
+        {
+            return utils::Result::Failure;
+        }
+        writeHeader();
+        return file_ ? utils::Result::Success : utils::Result::Failure;
+    }
+
+    void WavSink::write(const std::int16_t *samples, const std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            putLittleEndian(file_, static_cast<std::uint16_t>(samples[i]), 2);
+        }
+        samples_ += count;
+    }
+
+    bool WavSink::realtime() const
+    {
+        return false;
+    }
+
+    void WavSink::writeHeader()
+    {
+        const std::uint32_t data_size = static_cast<std::uint32_t>(samples_ * sizeof(std::int16_t));
+        file_.write("RIFF", 4);
+        putLittleEndian(file_, static_cast<std::uint32_t>(WAV_HEADER_SIZE - 8) + data_size, 4);
+        file_.write("WAVEfmt ", 8);
+        putLittleEndian(file_, 16, 4);                                   // size of the format chunk
+        putLittleEndian(file_, 1, 2);                                    // PCM
+        putLittleEndian(file_, 1, 2);                                    // mono
+        putLittleEndian(file_, sample_rate_, 4);                         // samples per second
+        putLittleEndian(file_, sample_rate_ * sizeof(std::int16_t), 4); // bytes per second
+        putLittleEndian(file_, sizeof(std::int16_t), 2);                 // bytes per sample frame
+        putLittleEndian(file_, 16, 2);                                   // bits per sample
+        file_.write("data", 4);
+        putLittleEndian(file_, data_size, 4);
+    }
+
+    std::unique_ptr<AudioSink> openSink(const std::string &spec, const std::uint32_t sample_rate, utils::Messenger &messenger)
+    {
+        std::unique_ptr<AudioSink> sink;
+        if (spec == "null")
+        {
+            sink = std::make_unique<NullSink>();
+        }
+        else if (spec.rfind("wav:", 0) == 0 && spec.size() > 4)
+        {
+            sink = std::make_unique<WavSink>(spec.substr(4));
+        }
+        else if (spec == "alsa" || spec.rfind("alsa:", 0) == 0)
+        {
+            if (!ALSA_AVAILABLE)
+            {
+                messenger.log<utils::Level::Warning>("Built without ALSA, no sound will be played");
+                return nullptr;
+            }
+            sink = std::make_unique<AlsaSink>((spec.size() > 5) ? spec.substr(5) : std::string("default"));
+        }
+        else
+        {
+            messenger.log<utils::Level::Error>("Unknown audio output ", spec);
+            return nullptr;
+        }
+        if (sink->open(sample_rate) == utils::Result::Failure)
+        {
+            messenger.log<utils::Level::Warning>("Failed to open audio output ", spec, ", no sound will be played");
+            return nullptr;
+        }
+        return sink;
+    }
+
+} // namespace emulator::audio
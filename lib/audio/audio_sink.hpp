@@ -0,0 +1,80 @@
+#pragma once
+
+#include "common.hpp"
+#include "messages.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace emulator::audio
+{
+    // somewhere mono 16-bit samples end up, only ever used from the audio thread
+    class AudioSink
+    {
+    public:
+        virtual ~AudioSink() = default;
+
+        /**
+         * @brief Get the sink ready for samples at the given rate
+         */
+        virtual utils::Result open(const std::uint32_t sample_rate) = 0;
+
+        /**
+         * @brief Play or store the samples, may block until the sink has room for them
+         */
+        virtual void write(const std::int16_t *samples, const std::size_t count) = 0;
+
+        /**
+         * @brief Whether the sink plays in real time
+         * @details Real time sinks are fed silence when the emulator falls behind and skip samples when it runs ahead,
+         * the others get exactly the samples the emulator made
+         */
+        virtual bool realtime() const = 0;
+    };
+
+    // throws every sample away, for headless runs and tests
+    class NullSink : public AudioSink
+    {
+    public:
+        utils::Result open(const std::uint32_t sample_rate) override;
+        void write(const std::int16_t *samples, const std::size_t count) override;
+        bool realtime() const override;
+    };
+
+    // records the samples into a 16-bit mono PCM .wav file, the header is completed when the sink is destroyed
+    class WavSink : public AudioSink
+    {
+    public:
+        explicit WavSink(std::string path);
+        ~WavSink() override;
+
+        utils::Result open(const std::uint32_t sample_rate) override;
+        void write(const std::int16_t *samples, const std::size_t count) override;
+        bool realtime() const override;
+
+    private:
+        /**
+         * @brief Write the RIFF header for the samples written so far
+         */
+        void writeHeader();
+
+    private:
+        std::string path_;
+        std::ofstream file_;
+        std::uint32_t sample_rate_ = 0;
+        std::uint64_t samples_ = 0;
+    };
+
+    /**
+     * @brief Create and open a sink from its command line name
+     * @param spec "alsa", "alsa:DEVICE", "wav:FILE" or "null"
+     * @param sample_rate Samples per second
+     * @param messenger Where to report why a sink could not be opened
+     * @return The opened sink, or nullptr if it is unknown or failed to open
+     */
+    std::unique_ptr<AudioSink> openSink(const std::string &spec, const std::uint32_t sample_rate, utils::Messenger &messenger);
+
+} // namespace emulator::audio
@@ -0,0 +1,65 @@
+#include "buzzer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace emulator::audio
+{
+    Buzzer::Buzzer(const std::uint32_t sample_rate, const std::uint32_t tone_hz, const std::int16_t amplitude)
+        : sample_rate_(std::max<std::uint32_t>(sample_rate, TICK_RATE)), tone_hz_(std::max<std::uint32_t>(tone_hz, 1)),
+          amplitude_(amplitude)
+    {
+    }
+
+    std::size_t Buzzer::maxBlockSize() const
+    {
+        return (sample_rate_ + TICK_RATE - 1) / TICK_RATE;
+    }
+
+    std::size_t Buzzer::render(const bool on, std::int16_t *samples, const std::uint8_t *pattern, const std::uint8_t pitch)
+    {
+        const std::size_t count = (tick_ + 1) * sample_rate_ / TICK_RATE - tick_ * sample_rate_ / TICK_RATE;
+        ++tick_;
+        if (!on)
+        {
+            // restart the wave from its rising edge next time, every beep then starts the same way
+            phase_ = 0;
+            pattern_phase_ = 0.0;
+            std::fill(samples, samples + count, std::int16_t{0});
+            return count;
+        }
+        if (pattern != nullptr)
+        {
+            const double step = 4000.0 * std::exp2((pitch - DEFAULT_PITCH) / 48.0) / sample_rate_;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const auto bit = static_cast<std::size_t>(pattern_phase_);
+                const bool high = ((pattern[bit / 8] >> (7 - bit % 8)) & 0x1) != 0;
+                samples[i] = high ? amplitude_ : static_cast<std::int16_t>(-amplitude_);
+                pattern_phase_ += step;
+                if (pattern_phase_ >= PATTERN_BITS)
+                {
+                    pattern_phase_ -= PATTERN_BITS;
+                }
+            }
+            return count;
+        }
+        // the phase advances by tone_hz_ every sample and wraps at sample_rate_, high for the first half of a period
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            samples[i] = (phase_ * 2 < sample_rate_) ? amplitude_ : static_cast<std::int16_t>(-amplitude_);
+            phase_ += tone_hz_;
+            if (phase_ >= sample_rate_)
+            {
+                phase_ -= sample_rate_;
+            }
+        }
+        return count;
+    }
+
+    std::uint32_t Buzzer::sampleRate() const
+    {
+        return sample_rate_;
+    }
+
+} // namespace emulator::audio
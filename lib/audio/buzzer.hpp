@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace emulator::audio
+{
+    static constexpr std::uint32_t DEFAULT_SAMPLE_RATE = 48000;
+    static constexpr std::uint32_t DEFAULT_TONE_HZ = 440;
+    // the rate the sound timer ticks at, one block of samples is made per tick
+    static constexpr std::uint32_t TICK_RATE = 60;
+    // XO-CHIP audio patterns: 128 one-bit samples, played at 4000 bits per second at the default pitch
+    // and one octave higher or lower for every 48 steps of pitch above or below it
+    static constexpr std::size_t PATTERN_BITS = 128;
+    static constexpr std::uint8_t DEFAULT_PITCH = 64;
+
+    // square wave tone gated by the sound timer, one block of mono 16-bit samples per 60 Hz tick
+    // or, when an XO-CHIP program loaded one, its audio pattern looped at the program's pitch
+    // block sizes carry the remainder over like the instruction budgets, so 44.1 kHz gives exactly 735 a tick
+    // and 48 kHz exactly 800, and the phase runs on across blocks so the tone never clicks mid-note
+    class Buzzer
+    {
+    public:
+        /**
+         * @param sample_rate Samples per second
+         * @param tone_hz Frequency of the square wave
+         * @param amplitude Peak sample value
+         */
+        explicit Buzzer(const std::uint32_t sample_rate = DEFAULT_SAMPLE_RATE, const std::uint32_t tone_hz = DEFAULT_TONE_HZ,
+                        const std::int16_t amplitude = 6000);
+
+        /**
+         * @brief The most samples a single block can have, for sizing buffers
+         */
+        std::size_t maxBlockSize() const;
+
+        /**
+         * @brief Write the samples of the next tick
+         * @param on Whether the sound timer was running during the tick
+         * @param samples Destination holding at least maxBlockSize() samples
+         * @param pattern PATTERN_BITS / 8 bytes of pattern, first bit in the most significant bit, nullptr plays the tone
+         * @param pitch Playback pitch of the pattern
+         * @return The number of samples written
+         */
+        std::size_t render(const bool on, std::int16_t *samples, const std::uint8_t *pattern = nullptr,
+                           const std::uint8_t pitch = DEFAULT_PITCH);
+
+        std::uint32_t sampleRate() const;
+
+    private:
+        std::uint32_t sample_rate_;
+        std::uint32_t tone_hz_;
+        std::int16_t amplitude_;
+        std::uint64_t tick_ = 0;
+        // position within one period of the tone, in units of 1 / sample_rate_ periods
+        std::uint64_t phase_ = 0;
+        // position within the audio pattern, in bits
+        double pattern_phase_ = 0.0;
+    };
+} // namespace emulator::audio
@@ -0,0 +1,172 @@
+#include "delta_stream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace emulator::capture
+{
+    namespace
+    {
+        // a zero run shorter than this is cheaper to leave in the literal bytes than to start a new pair for
+        constexpr std::size_t MIN_ZERO_RUN = 3;
+        constexpr std::size_t HEADER_SIZE = sizeof(DELTA_MAGIC) + sizeof(std::uint32_t);
+
+        void appendVarint(std::vector<std::uint8_t> &out, std::uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<std::uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<std::uint8_t>(value));
+        }
+    } // namespace
+
+    void appendRecord(std::vector<std::uint8_t> &out, const std::uint64_t frames, const std::uint8_t flags, const std::uint8_t *screen,
+                      const std::uint8_t *previous)
+    {
+        appendVarint(out, frames);
+        out.push_back(flags);
+        const bool key = (flags & RECORD_KEY_FRAME) != 0;
+        std::uint8_t delta[SCREEN_BYTES];
+        for (std::size_t i = 0; i < SCREEN_BYTES; ++i)
+        {
+            delta[i] = key ? screen[i] : static_cast<std::uint8_t>(screen[i] ^ previous[i]);
+        }
+        std::size_t at = 0;
+        while (at < SCREEN_BYTES)
+        {
+            const std::size_t zeros_from = at;
+            while (at < SCREEN_BYTES && delta[at] == 0)
+            {
+                ++at;
+            }
+            const std::size_t literal_from = at;
+            // the literal bytes go on until a zero run long enough to be worth its own pair
+            while (at < SCREEN_BYTES)
+            {
+                std::size_t run = 0;
+                while (at + run < SCREEN_BYTES && run < MIN_ZERO_RUN && delta[at + run] == 0)
+                {
+                    ++run;
+                }
+                if (run == MIN_ZERO_RUN || at + run == SCREEN_BYTES)
+                {
+                    break;
+                }
+                at += std::max<std::size_t>(run, 1);
+            }
+            appendVarint(out, literal_from - zeros_from);
+            appendVarint(out, at - literal_from);
+            out.insert(out.end(), delta + literal_from, delta + at);
+        }
+    }
+
+    void packScreen(const interpreter::FrameBuffer &screen, std::uint8_t *bytes)
+    {
+        const std::uint64_t *words = screen.words();
+        for (int i = 0; i < interpreter::FrameBuffer::WORDS; ++i)
+        {
+            for (int byte = 0; byte < 8; ++byte)
+            {
+                *bytes++ = static_cast<std::uint8_t>(words[i] >> (56 - 8 * byte));
+            }
+        }
+    }
+
+    void unpackScreen(const std::uint8_t *bytes, const bool hires, interpreter::FrameBuffer &screen)
+    {
+        std::uint64_t words[interpreter::FrameBuffer::WORDS];
+        for (int i = 0; i < interpreter::FrameBuffer::WORDS; ++i)
+        {
+            words[i] = 0;
+            for (int byte = 0; byte < 8; ++byte)
+            {
+                words[i] = words[i] << 8 | *bytes++;
+            }
+        }
+        screen.load(words, hires);
+    }
+
+    std::optional<DeltaStreamReader> DeltaStreamReader::open(const char *path)
+    {
+        auto file = utils::MappedFile::open(path);
+        if (!file || file->size() < HEADER_SIZE || std::memcmp(file->data(), DELTA_MAGIC, sizeof(DELTA_MAGIC)) != 0)
+        {
+            return std::nullopt;
+        }
+        const std::uint8_t *version = file->data() + sizeof(DELTA_MAGIC);
+        if ((version[0] | version[1] << 8 | version[2] << 16 | static_cast<std::uint32_t>(version[3]) << 24) != DELTA_VERSION)
+        {
+            return std::nullopt;
+        }
+        return DeltaStreamReader(std::move(*file));
+    }
+
+    DeltaStreamReader::DeltaStreamReader(utils::MappedFile file)
+        : file_(std::move(file)), position_(HEADER_SIZE), screen_(SCREEN_BYTES, 0)
+    {
+    }
+
+    std::optional<std::uint64_t> DeltaStreamReader::varint()
+    {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64 && position_ < file_.size(); shift += 7)
+        {
+            const std::uint8_t byte = file_.data()[position_++];
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool DeltaStreamReader::next(interpreter::FrameBuffer &screen, std::uint64_t &frame)
+    {
+        if (damaged_ || position_ >= file_.size())
+        {
+            return false;
+        }
+        const auto frames = varint();
+        if (!frames || position_ >= file_.size())
+        {
+            damaged_ = true;
+            return false;
+        }
+        const std::uint8_t flags = file_.data()[position_++];
+        if (flags & RECORD_KEY_FRAME)
+        {
+            std::fill(screen_.begin(), screen_.end(), std::uint8_t{0});
+        }
+        std::size_t at = 0;
+        while (at < SCREEN_BYTES)
+        {
+            const auto zeros = varint();
+            const auto literal = varint();
+            // each value is checked on its own first, their sum can wrap around on a hostile file
+            if (!zeros || !literal || *zeros > SCREEN_BYTES - at || *literal > SCREEN_BYTES - at - *zeros ||
+                *literal > file_.size() - position_)
+            {
+                damaged_ = true;
+                return false;
+            }
+            at += *zeros;
+            for (std::size_t i = 0; i < *literal; ++i)
+            {
+                screen_[at++] ^= file_.data()[position_++];
+            }
+        }
+        frame_ += *frames;
+        frame = frame_;
+        unpackScreen(screen_.data(), (flags & RECORD_HIRES) != 0, screen);
+        return true;
+    }
+
+    bool DeltaStreamReader::damaged() const
+    {
+        return damaged_;
+    }
+
+} // namespace emulator::capture
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "common.hpp"
+#include "framebuffer.hpp"
+#include "mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace emulator::capture
+{
+    // a .c8v capture: the header, then one record per captured frame
+    //   header  "C8VD", u32 version (little endian)
+    //   record  varint frames since the previous record (the frame number itself for the first one), u8 flags,
+    //           then the screen bytes xor-ed with the previous record's (with a blank screen for a key frame) as
+    //           pairs of varint zero bytes skipped, varint literal bytes and the literal bytes, until SCREEN_BYTES are covered
+    // screens are WORDS of FrameBuffer::words() stored most significant byte first, so the bytes are in pixel order
+    static constexpr char DELTA_MAGIC[4] = {'C', '8', 'V', 'D'};
+    static constexpr std::uint32_t DELTA_VERSION = 1;
+    static constexpr std::size_t SCREEN_BYTES = interpreter::FrameBuffer::WORDS * sizeof(std::uint64_t);
+    // every this many records is a key frame, coded against a blank screen, so decoding from one needs none of the
+    // records before it; records carry no length, so a reader cannot find the next one past a damaged record and stops
+    static constexpr std::uint32_t KEY_FRAME_INTERVAL = 600;
+
+    // record flags
+    static constexpr std::uint8_t RECORD_HIRES = 0x1;
+    static constexpr std::uint8_t RECORD_KEY_FRAME = 0x2;
+
+    /**
+     * @brief Append the record of a screen to a delta stream
+     * @param out Where the record goes
+     * @param frames Frames since the previous record
+     * @param flags RECORD_HIRES and RECORD_KEY_FRAME
+     * @param screen The screen bytes
+     * @param previous The previous record's screen bytes, ignored for a key frame
+     */
+    void appendRecord(std::vector<std::uint8_t> &out, const std::uint64_t frames, const std::uint8_t flags, const std::uint8_t *screen,
+                      const std::uint8_t *previous);
+
+    /**
+     * @brief Store a screen's words as SCREEN_BYTES bytes in pixel order
+     */
+    void packScreen(const interpreter::FrameBuffer &screen, std::uint8_t *bytes);
+
+    /**
+     * @brief Turn SCREEN_BYTES bytes stored by packScreen back into a screen
+     */
+    void unpackScreen(const std::uint8_t *bytes, const bool hires, interpreter::FrameBuffer &screen);
+
+    // plays a .c8v capture back a record at a time
+    class DeltaStreamReader
+    {
+    public:
+        /**
+         * @brief Open a capture
+         * @return The reader, or nothing if the file is missing or not a capture of this version
+         */
+        static std::optional<DeltaStreamReader> open(const char *path);
+
+        /**
+         * @brief Decode the next record
+         * @param screen Set to the captured screen
+         * @param frame Set to its frame number
+         * @return false at the end of the stream or at a damaged record, see damaged
+         */
+        bool next(interpreter::FrameBuffer &screen, std::uint64_t &frame);
+
+        /**
+         * @brief Check if reading stopped at a record that does not decode, rather than at the end
+         */
+        bool damaged() const;
+
+    private:
+        explicit DeltaStreamReader(utils::MappedFile file);
+
+        /**
+         * @brief Read a varint at the current position
+         */
+        std::optional<std::uint64_t> varint();
+
+    private:
+        utils::MappedFile file_;
+        std::size_t position_;
+        std::uint64_t frame_ = 0;
+        std::vector<std::uint8_t> screen_;
+        bool damaged_ = false;
+    };
+
+} // namespace emulator::capture
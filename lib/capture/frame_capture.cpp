@@ -0,0 +1,87 @@
+#include "frame_capture.hpp"
+
+#include <chrono>
+
+namespace emulator::capture
+{
+    namespace
+    {
+        // how often the capture thread looks for frames once the ring ran empty, well within a 60 Hz frame
+        constexpr std::chrono::milliseconds IDLE_WAIT{5};
+    } // namespace
+
+    FrameCapture::FrameCapture(std::unique_ptr<FrameEncoder> encoder, const std::size_t ring_frames)
+        : encoder_(std::move(encoder)), ring_(ring_frames)
+    {
+    }
+
+    FrameCapture::~FrameCapture()
+    {
+        stop();
+    }
+
+    void FrameCapture::start()
+    {
+        stop_.store(false, std::memory_order_relaxed);
+        thread_ = std::thread(&FrameCapture::loop, this);
+    }
+
+    void FrameCapture::stop()
+    {
+        stop_.store(true, std::memory_order_relaxed);
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    void FrameCapture::push(const interpreter::FrameBuffer &screen, const std::uint64_t frame)
+    {
+        // straight into the ring slot, the only copy the emulation thread pays for
+        Frame *slot = ring_.claim();
+        if (!slot)
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        slot->screen = screen;
+        slot->number = frame;
+        ring_.commit();
+    }
+
+    std::uint64_t FrameCapture::droppedFrames() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t FrameCapture::encodedFrames() const
+    {
+        return encoded_.load(std::memory_order_relaxed);
+    }
+
+    void FrameCapture::loop()
+    {
+        while (!stop_.load(std::memory_order_relaxed))
+        {
+            if (!drain())
+            {
+                std::this_thread::sleep_for(IDLE_WAIT);
+            }
+        }
+        // the emulator has stopped pushing, whatever it left in the ring still belongs to the capture
+        drain();
+    }
+
+    bool FrameCapture::drain()
+    {
+        bool any = false;
+        while (ring_.pop(frame_))
+        {
+            encoder_->encode(frame_.screen, frame_.number);
+            encoded_.fetch_add(1, std::memory_order_relaxed);
+            any = true;
+        }
+        return any;
+    }
+
+} // namespace emulator::capture
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "frame_encoder.hpp"
+#include "framebuffer.hpp"
+#include "spsc_ring.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace emulator::capture
+{
+    // records finished frames through an encoder on its own thread
+    // the emulation thread copies each frame once into a lock-free ring and carries on, it never waits on the encoder
+    // or the disk; a full ring drops the frame instead
+    class FrameCapture
+    {
+    public:
+        // frames queued between the emulator and the encoder, a few seconds of uncapped emulation
+        static constexpr std::size_t RING_FRAMES = 1024;
+
+        /**
+         * @param encoder An opened encoder
+         * @param ring_frames How many frames may wait for the encoder
+         */
+        explicit FrameCapture(std::unique_ptr<FrameEncoder> encoder, const std::size_t ring_frames = RING_FRAMES);
+        ~FrameCapture();
+
+        FrameCapture(const FrameCapture &) = delete;
+        FrameCapture &operator=(const FrameCapture &) = delete;
+
+        /**
+         * @brief Start encoding
+         */
+        void start();
+
+        /**
+         * @brief Stop encoding once every frame still queued is written
+         */
+        void stop();
+
+        /**
+         * @brief Queue a finished frame, emulation thread only
+         * @param screen The screen to record, copied into the ring
+         * @param frame Its frame number, frames that were not pushed count as repeats of the one before
+         */
+        void push(const interpreter::FrameBuffer &screen, const std::uint64_t frame);
+
+        /**
+         * @brief Frames lost because the ring was full
+         */
+        std::uint64_t droppedFrames() const;
+
+        /**
+         * @brief Frames handed to the encoder so far
+         */
+        std::uint64_t encodedFrames() const;
+
+    private:
+        struct Frame
+        {
+            interpreter::FrameBuffer screen;
+            std::uint64_t number;
+        };
+
+        void loop();
+
+        /**
+         * @brief Encode whatever is queued
+         * @return false if the ring was empty
+         */
+        bool drain();
+
+    private:
+        std::unique_ptr<FrameEncoder> encoder_;
+        utils::SpscRing<Frame> ring_;
+        // where the capture thread pops frames into
+        Frame frame_;
+        std::atomic<std::uint64_t> dropped_{0};
+        std::atomic<std::uint64_t> encoded_{0};
+        std::atomic<bool> stop_{false};
+        std::thread thread_;
+    };
+
+} // namespace emulator::capture
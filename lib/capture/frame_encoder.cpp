@@ -0,0 +1,114 @@
+#include "frame_encoder.hpp"
+
+#include <cstdio>
+#include <system_error>
+
+// the implementation is compiled into this file only, it predates -Wpedantic and we only call the PNG writer
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#pragma GCC diagnostic ignored "-Wunused-function"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_STATIC
+#include "stb_image_write.h"
+#pragma GCC diagnostic pop
+
+namespace emulator::capture
+{
+    utils::Result writePng(const std::filesystem::path &path, const interpreter::FrameBuffer &screen)
+    {
+        constexpr int width = interpreter::FrameBuffer::HIRES_WIDTH;
+        constexpr int height = interpreter::FrameBuffer::HIRES_HEIGHT;
+        std::uint8_t pixels[width * height];
+        screen.expand(pixels, interpreter::SHADES);
+        return stbi_write_png(path.string().c_str(), width, height, 1, pixels, width) != 0 ? utils::Result::Success : utils::Result::Failure;
+    }
+
+    PngEncoder::PngEncoder(std::filesystem::path directory) : directory_(std::move(directory))
+    {
+    }
+
+    utils::Result PngEncoder::open()
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory_, error);
+        return std::filesystem::is_directory(directory_, error) ? utils::Result::Success : utils::Result::Failure;
+    }
+
+    void PngEncoder::encode(const interpreter::FrameBuffer &screen, const std::uint64_t frame)
+    {
+        // an unchanged screen is not worth a file, the frame numbers in the names keep the timing
+        const std::uint64_t hash = screen.hash();
+        if (!first_ && hash == last_hash_)
+        {
+            return;
+        }
+        first_ = false;
+        last_hash_ = hash;
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%08llu.png", static_cast<unsigned long long>(frame));
+        writePng(directory_ / name, screen);
+    }
+
+    DeltaEncoder::DeltaEncoder(std::string path) : path_(std::move(path)), screen_(SCREEN_BYTES), previous_(SCREEN_BYTES)
+    {
+        // room for the worst case up front, a record of nothing but literal bytes is barely longer than the screen
+        record_.reserve(2 * SCREEN_BYTES);
+    }
+
+    utils::Result DeltaEncoder::open()
+    {
+        file_.open(path_, std::ios::binary | std::ios::trunc);
+        if (!file_)
+        {
+            return utils::Result::Failure;
+        }
+        file_.write(DELTA_MAGIC, sizeof(DELTA_MAGIC));
+        for (int i = 0; i < 4; ++i)
+        {
+            file_.put(static_cast<char>((DELTA_VERSION >> (8 * i)) & 0xFF));
+        }
+        return file_ ? utils::Result::Success : utils::Result::Failure;
+    }
+
+    void DeltaEncoder::encode(const interpreter::FrameBuffer &screen, const std::uint64_t frame)
+    {
+        packScreen(screen, screen_.data());
+        std::uint8_t flags = screen.hires() ? RECORD_HIRES : 0;
+        if (records_ % KEY_FRAME_INTERVAL == 0)
+        {
+            flags |= RECORD_KEY_FRAME;
+        }
+        record_.clear();
+        appendRecord(record_, frame - frame_, flags, screen_.data(), previous_.data());
+        file_.write(reinterpret_cast<const char *>(record_.data()), static_cast<std::streamsize>(record_.size()));
+        screen_.swap(previous_);
+        frame_ = frame;
+        ++records_;
+    }
+
+    std::unique_ptr<FrameEncoder> openEncoder(const std::string &spec, utils::Messenger &messenger)
+    {
+        std::unique_ptr<FrameEncoder> encoder;
+        if (spec.rfind("png:", 0) == 0 && spec.size() > 4)
+        {
+            encoder = std::make_unique<PngEncoder>(spec.substr(4));
+        }
+        else if (spec.rfind("c8v:", 0) == 0 && spec.size() > 4)
+        {
+            encoder = std::make_unique<DeltaEncoder>(spec.substr(4));
+        }
+        else
+        {
+            messenger.log<utils::Level::Error>("Unknown capture output ", spec);
+            return nullptr;
+        }
+        if (encoder->open() == utils::Result::Failure)
+        {
+            messenger.log<utils::Level::Warning>("Failed to open capture output ", spec, ", nothing will be captured");
+            return nullptr;
+        }
+        return encoder;
+    }
+
+} // namespace emulator::capture
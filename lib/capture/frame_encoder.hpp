@@ -0,0 +1,83 @@
+#pragma once
+
+#include "common.hpp"
+#include "delta_stream.hpp"
+#include "framebuffer.hpp"
+#include "messages.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace emulator::capture
+{
+    // somewhere captured frames end up, only ever used from the capture thread
+    class FrameEncoder
+    {
+    public:
+        virtual ~FrameEncoder() = default;
+
+        /**
+         * @brief Get ready for frames
+         */
+        virtual utils::Result open() = 0;
+
+        /**
+         * @brief Store a frame
+         * @param screen The screen at the end of the frame
+         * @param frame Its frame number, increasing from one call to the next but not necessarily by one
+         */
+        virtual void encode(const interpreter::FrameBuffer &screen, const std::uint64_t frame) = 0;
+    };
+
+    // writes every frame that differs from the one before as DIR/frame_NNNNNNNN.png, 128x64 grayscale
+    class PngEncoder : public FrameEncoder
+    {
+    public:
+        explicit PngEncoder(std::filesystem::path directory);
+
+        utils::Result open() override;
+        void encode(const interpreter::FrameBuffer &screen, const std::uint64_t frame) override;
+
+    private:
+        std::filesystem::path directory_;
+        std::uint64_t last_hash_ = 0;
+        bool first_ = true;
+    };
+
+    // writes a .c8v delta stream, see delta_stream.hpp, expanded to PNGs later by chip8_capture_convert
+    class DeltaEncoder : public FrameEncoder
+    {
+    public:
+        explicit DeltaEncoder(std::string path);
+
+        utils::Result open() override;
+        void encode(const interpreter::FrameBuffer &screen, const std::uint64_t frame) override;
+
+    private:
+        std::string path_;
+        std::ofstream file_;
+        std::vector<std::uint8_t> record_;
+        std::vector<std::uint8_t> screen_;
+        std::vector<std::uint8_t> previous_;
+        std::uint64_t frame_ = 0;
+        std::uint64_t records_ = 0;
+    };
+
+    /**
+     * @brief Write a screen as a 128x64 grayscale PNG, low resolution pixels doubled
+     */
+    utils::Result writePng(const std::filesystem::path &path, const interpreter::FrameBuffer &screen);
+
+    /**
+     * @brief Create and open an encoder from its command line name
+     * @param spec "png:DIRECTORY" or "c8v:FILE"
+     * @param messenger Where to report why an encoder could not be opened
+     * @return The opened encoder, or nullptr if it is unknown or failed to open
+     */
+    std::unique_ptr<FrameEncoder> openEncoder(const std::string &spec, utils::Messenger &messenger);
+
+} // namespace emulator::capture
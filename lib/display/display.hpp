@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common.hpp"
+#include "framebuffer.hpp"
+#include "key_mailbox.hpp"
+
+#include <string>
+
+namespace emulator::display
+{
+    // somewhere finished screens are shown and keys come from, used from the main thread only (except wake)
+    class Display
+    {
+    public:
+        virtual ~Display() = default;
+
+        /**
+         * @brief Get ready to show screens
+         * @param keys The mailbox key presses are posted to, the emulation thread picks them up from there
+         */
+        virtual utils::Result open(utils::KeyMailbox &keys) = 0;
+
+        /**
+         * @brief Show a finished screen
+         */
+        virtual utils::Result present(const interpreter::FrameBuffer &screen) = 0;
+
+        /**
+         * @brief Sleep until input arrives, wake() is called or the timeout runs out, and handle the input
+         * @param timeout The longest time to wait, in seconds
+         */
+        virtual void waitEvents(const double timeout) = 0;
+
+        /**
+         * @brief Wake up a waitEvents call, can be called from any thread
+         */
+        virtual void wake() = 0;
+
+        /**
+         * @brief Show a line of status text, such as the speed while fast forwarding
+         */
+        virtual void setTitle(const std::string &title) = 0;
+
+        /**
+         * @brief Check if the user closed the display or pressed escape
+         */
+        virtual bool closed() = 0;
+    };
+
+} // namespace emulator::display
@@ -0,0 +1,329 @@
+#include "terminal_display.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace emulator::display
+{
+    namespace
+    {
+        // the cell glyphs by which of its pixels are on: none, top, bottom, both
+        constexpr const char *HALF_BLOCKS[4] = {" ", "▀", "▄", "█"};
+        // the Chip8 keypad in the same layout as the window uses, 1234 / QWER / ASDF / ZXCV
+        constexpr char KEYPAD[] = "1234qwerasdfzxcv";
+        constexpr char ESCAPE = 0x1B;
+        constexpr char CTRL_C = 0x03;
+
+        // the closest colour of the 256 colour palette to a shade: black, white or one of the 24 grays in between
+        int terminalColour(const std::uint8_t shade)
+        {
+            const std::uint8_t level = interpreter::SHADES[shade];
+            if (level == 0x00)
+            {
+                return 16;
+            }
+            if (level >= 0xF8)
+            {
+                return 231;
+            }
+            return 232 + std::min((std::max<int>(level, 8) - 8) / 10, 23);
+        }
+    } // namespace
+
+    TerminalDisplay::TerminalDisplay(utils::Messenger &messenger) : messenger_(messenger)
+    {
+        cells_.fill(UNKNOWN);
+    }
+
+    TerminalDisplay::~TerminalDisplay()
+    {
+        if (keys_)
+        {
+            // leave the cursor under the screen and the status line, with the terminal as it was
+            out_ += "\x1b[0m\x1b[?25h\x1b[" + std::to_string(rows_ + 2) + ";1H\n";
+            flush();
+        }
+        if (raw_)
+        {
+            ::tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_);
+        }
+        if (messenger_output_)
+        {
+            messenger_.setOutput(*messenger_output_);
+        }
+        for (const int fd : wake_pipe_)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    }
+
+    utils::Result TerminalDisplay::open(utils::KeyMailbox &keys)
+    {
+        if (::pipe(wake_pipe_) != 0)
+        {
+            messenger_.log<utils::Level::Error>("Failed to set up the terminal display");
+            return utils::Result::Failure;
+        }
+        for (const int fd : wake_pipe_)
+        {
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+        // keys arrive one byte at a time without waiting for enter or being echoed, ctrl-c is read as a key so
+        // the terminal is always put back on the way out
+        if (::isatty(STDIN_FILENO) && ::tcgetattr(STDIN_FILENO, &saved_) == 0)
+        {
+            termios raw = saved_;
+            raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+            raw.c_iflag &= ~(IXON | ICRNL);
+            raw.c_cc[VMIN] = 0;
+            raw.c_cc[VTIME] = 0;
+            raw_ = ::tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == 0;
+        }
+        if (!raw_)
+        {
+            messenger_.log<utils::Level::Warning>("stdin is not a terminal, keys will not be read");
+        }
+        // everything said so far goes out before the first screen, later messages go to stderr so a redirected one
+        // keeps them off the screen, and present repaints the whole screen over any that still land on it
+        messenger_.flush();
+        messenger_output_ = &messenger_.setOutput(std::cerr);
+        messenger_outputs_ = messenger_.outputs();
+        keys_ = &keys;
+        out_ += "\x1b[?25l";
+        flush();
+        return utils::Result::Success;
+    }
+
+    utils::Result TerminalDisplay::present(const interpreter::FrameBuffer &screen)
+    {
+        const int columns = screen.width();
+        const int rows = screen.height() / 2;
+        const std::size_t outputs = messenger_.outputs();
+        if (columns != columns_ || rows != rows_ || outputs != messenger_outputs_)
+        {
+            // first screen, a new resolution or messages written over the old one, start from a blank terminal
+            // and send every cell
+            messenger_outputs_ = outputs;
+            columns_ = columns;
+            rows_ = rows;
+            cells_.fill(UNKNOWN);
+            out_ += "\x1b[0m\x1b[2J";
+            foreground_ = -1;
+            background_ = -1;
+            setTitle(title_);
+        }
+        // where the terminal's cursor is, it moves one cell to the right after every glyph
+        int cursor_row = -1;
+        int cursor_column = -1;
+        for (int row = 0; row < rows_; ++row)
+        {
+            for (int column = 0; column < columns_; ++column)
+            {
+                const std::uint8_t cell = static_cast<std::uint8_t>(screen.pixel(column, 2 * row) | screen.pixel(column, 2 * row + 1) << 2);
+                std::uint8_t &shown = cells_[row * MAX_COLUMNS + column];
+                if (shown == cell)
+                {
+                    continue;
+                }
+                if (row != cursor_row || column != cursor_column)
+                {
+                    out_ += "\x1b[" + std::to_string(row + 1) + ';' + std::to_string(column + 1) + 'H';
+                }
+                emitCell(cell);
+                shown = cell;
+                cursor_row = row;
+                cursor_column = column + 1;
+            }
+        }
+        flush();
+        return utils::Result::Success;
+    }
+
+    void TerminalDisplay::emitCell(const std::uint8_t cell)
+    {
+        const std::uint8_t top = cell & 0x3;
+        const std::uint8_t bottom = cell >> 2;
+        if (top <= 1 && bottom <= 1)
+        {
+            // pixels on the first plane only, a glyph in the terminal's own colours says it all
+            if (foreground_ != -1 || background_ != -1)
+            {
+                out_ += "\x1b[0m";
+                foreground_ = -1;
+                background_ = -1;
+            }
+            out_ += HALF_BLOCKS[top | bottom << 1];
+            return;
+        }
+        // the second plane needs its shade, the upper half block takes the top pixel's and the background the bottom's
+        const int foreground = terminalColour(top);
+        const int background = terminalColour(bottom);
+        if (foreground != foreground_)
+        {
+            out_ += "\x1b[38;5;" + std::to_string(foreground) + 'm';
+            foreground_ = foreground;
+        }
+        if (background != background_)
+        {
+            out_ += "\x1b[48;5;" + std::to_string(background) + 'm';
+            background_ = background;
+        }
+        out_ += HALF_BLOCKS[1];
+    }
+
+    void TerminalDisplay::waitEvents(const double timeout)
+    {
+        // wake up in time to release the next held key
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(timeout));
+        const auto now = std::chrono::steady_clock::now();
+        for (const auto until : held_until_)
+        {
+            if (until != std::chrono::steady_clock::time_point{})
+            {
+                wait = std::min(wait, std::chrono::ceil<std::chrono::milliseconds>(std::max(until - now, std::chrono::steady_clock::duration{0})));
+            }
+        }
+        pollfd fds[2] = {{wake_pipe_[0], POLLIN, 0}, {STDIN_FILENO, POLLIN, 0}};
+        // stdin is only watched when it is a terminal, a closed or redirected one would always be readable
+        const int ready = ::poll(fds, raw_ ? 2 : 1, static_cast<int>(wait.count()));
+        releaseKeys();
+        if (ready <= 0)
+        {
+            return;
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            char drained[64];
+            while (::read(wake_pipe_[0], drained, sizeof(drained)) > 0)
+            {
+            }
+        }
+        if (raw_ && (fds[1].revents & POLLIN))
+        {
+            readKeys();
+        }
+    }
+
+    void TerminalDisplay::readKeys()
+    {
+        char typed[64];
+        const ssize_t count = ::read(STDIN_FILENO, typed, sizeof(typed));
+        for (ssize_t i = 0; i < count; ++i)
+        {
+            const char byte = typed[i];
+            if (byte == ESCAPE)
+            {
+                if (i + 1 == count)
+                {
+                    // escape on its own, not the start of an arrow or function key sequence
+                    closed_ = true;
+                    return;
+                }
+                // skip the sequence up to its final byte
+                i += 2;
+                while (i < count && (typed[i] < 0x40 || typed[i] > 0x7E))
+                {
+                    ++i;
+                }
+                continue;
+            }
+            if (byte == CTRL_C)
+            {
+                closed_ = true;
+                return;
+            }
+            if (byte == 0x7F || byte == '\b')
+            {
+                rewinding_ = !rewinding_;
+                keys_->holdRewind(rewinding_);
+                continue;
+            }
+            if (byte == '\t')
+            {
+                keys_->toggleFastForward();
+                continue;
+            }
+            const char *key = std::strchr(KEYPAD, (byte >= 'A' && byte <= 'Z') ? byte - 'A' + 'a' : byte);
+            if (byte == '\0' || !key)
+            {
+                continue;
+            }
+            auto &until = held_until_[key - KEYPAD];
+            if (until == std::chrono::steady_clock::time_point{})
+            {
+                keys_->post(static_cast<std::uint8_t>(key - KEYPAD), true);
+                until = std::chrono::steady_clock::now() + FIRST_HOLD;
+                continue;
+            }
+            // typed again while held, an auto-repeat
+            until = std::chrono::steady_clock::now() + REPEAT_HOLD;
+        }
+    }
+
+    void TerminalDisplay::releaseKeys()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        for (std::size_t key = 0; key < held_until_.size(); ++key)
+        {
+            if (held_until_[key] != std::chrono::steady_clock::time_point{} && held_until_[key] <= now)
+            {
+                keys_->post(static_cast<std::uint8_t>(key), false);
+                held_until_[key] = {};
+            }
+        }
+    }
+
+    void TerminalDisplay::wake()
+    {
+        // a full pipe already has a wake up pending
+        [[maybe_unused]] const ssize_t written = ::write(wake_pipe_[1], "w", 1);
+    }
+
+    void TerminalDisplay::setTitle(const std::string &title)
+    {
+        title_ = title;
+        if (rows_ == 0)
+        {
+            // drawn under the first screen
+            return;
+        }
+        out_ += "\x1b[0m\x1b[" + std::to_string(rows_ + 1) + ";1H" + title_ + "\x1b[K";
+        foreground_ = -1;
+        background_ = -1;
+        flush();
+    }
+
+    bool TerminalDisplay::closed()
+    {
+        return closed_;
+    }
+
+    void TerminalDisplay::flush()
+    {
+        std::size_t written = 0;
+        while (written < out_.size())
+        {
+            const ssize_t count = ::write(STDOUT_FILENO, out_.data() + written, out_.size() - written);
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (count <= 0)
+            {
+                break;
+            }
+            written += static_cast<std::size_t>(count);
+        }
+        out_.clear();
+    }
+
+} // namespace emulator::display
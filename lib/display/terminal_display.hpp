@@ -0,0 +1,97 @@
+#pragma once
+
+#include "display.hpp"
+#include "messages.hpp"
+
+#include <termios.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace emulator::display
+{
+    // draws the screen on an ANSI terminal, two pixels per character cell with Unicode half blocks
+    // only the cells that changed since the last frame are sent, each behind a cursor move unless it directly follows
+    // the previous one, so a mostly static game costs a few bytes per frame over a slow link
+    // keys are read from a raw mode stdin; a terminal reports no key releases, so a key counts as held until it has not
+    // been typed (or auto-repeated) for FIRST_HOLD, or REPEAT_HOLD once it repeats, and backspace starts and stops
+    // rewinding
+    // while the screen is up the messenger writes to stderr, and the screen is redrawn in full after it wrote
+    class TerminalDisplay : public Display
+    {
+    public:
+        explicit TerminalDisplay(utils::Messenger &messenger);
+        ~TerminalDisplay() override;
+
+        TerminalDisplay(const TerminalDisplay &) = delete;
+        TerminalDisplay &operator=(const TerminalDisplay &) = delete;
+
+        utils::Result open(utils::KeyMailbox &keys) override;
+        utils::Result present(const interpreter::FrameBuffer &screen) override;
+        void waitEvents(const double timeout) override;
+        void wake() override;
+        void setTitle(const std::string &title) override;
+        bool closed() override;
+
+    private:
+        // most cells a screen has, at 128x64
+        static constexpr int MAX_COLUMNS = interpreter::FrameBuffer::HIRES_WIDTH;
+        static constexpr int MAX_ROWS = interpreter::FrameBuffer::HIRES_HEIGHT / 2;
+        // a cell that matches no screen, forcing it to be drawn
+        static constexpr std::uint8_t UNKNOWN = 0xFF;
+        // how long a typed key stays down: the first press has to outlast the terminal's delay before it starts
+        // auto-repeating, 250 to 600 ms, once repeats arrive the key only has to outlast the gap between two
+        static constexpr std::chrono::milliseconds FIRST_HOLD{650};
+        static constexpr std::chrono::milliseconds REPEAT_HOLD{100};
+
+        /**
+         * @brief Append a cell to the output: the shades of its top and bottom pixel, 2 bits each
+         */
+        void emitCell(const std::uint8_t cell);
+
+        /**
+         * @brief Handle the bytes typed since the last call
+         */
+        void readKeys();
+
+        /**
+         * @brief Release the keys whose hold ran out without them being typed again
+         */
+        void releaseKeys();
+
+        /**
+         * @brief Hand the output to the terminal in one write
+         */
+        void flush();
+
+    private:
+        utils::Messenger &messenger_;
+        utils::KeyMailbox *keys_ = nullptr;
+        // what the terminal shows, one byte per cell as emitCell takes it
+        std::array<std::uint8_t, MAX_COLUMNS * MAX_ROWS> cells_;
+        int columns_ = 0;
+        int rows_ = 0;
+        // colours currently set on the terminal, -1 for the default ones
+        int foreground_ = -1;
+        int background_ = -1;
+        std::string out_;
+        std::string title_;
+        // where the messenger wrote before the terminal was taken over, and how often it has written since the
+        // screen was last drawn in full
+        std::ostream *messenger_output_ = nullptr;
+        std::size_t messenger_outputs_ = 0;
+        // when each Chip8 key is released, a default time point for keys that are up
+        std::array<std::chrono::steady_clock::time_point, 16> held_until_{};
+        bool rewinding_ = false;
+        bool closed_ = false;
+        // stdin is a terminal and was switched to raw mode, saved_ holds the settings to put back
+        bool raw_ = false;
+        termios saved_{};
+        // wake writes a byte into the pipe waitEvents polls next to stdin
+        int wake_pipe_[2] = {-1, -1};
+    };
+
+} // namespace emulator::display
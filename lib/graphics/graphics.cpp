@@ -1,8 +1,18 @@
 #include "graphics.hpp"
+#include "terminal_display.hpp"
 
 namespace emulator::graphics
 {
-    Graphics::Graphics(utils::Messenger &messenger) : messenger_(messenger)
+    std::unique_ptr<display::Display> makeDisplay(utils::Messenger &messenger, const Renderer renderer)
+    {
+        if (renderer == Renderer::Terminal)
+        {
+            return std::make_unique<display::TerminalDisplay>(messenger);
+        }
+        return std::make_unique<Graphics>(messenger, renderer);
+    }
+
+    Graphics::Graphics(utils::Messenger &messenger, const Renderer renderer) : messenger_(messenger), renderer_(renderer)
     {
     }
 
@@ -11,12 +21,45 @@ namespace emulator::graphics
         glfwTerminate();
     }
 
+    utils::Result Graphics::open(utils::KeyMailbox &keys)
+    {
+        if (initialise() == utils::Result::Failure)
+        {
+            messenger_.printUnsuccessfulGraphicsInitMessage();
+            return utils::Result::Failure;
+        }
+        const auto window = getWindow();
+        if (!window)
+        {
+            messenger_.printUnsuccessfulWindowCreationMessage();
+            return utils::Result::Failure;
+        }
+        window_ = *window;
+        setKeyReactFun(keys, window_);
+        return utils::Result::Success;
+    }
+
+    utils::Result Graphics::present(const interpreter::FrameBuffer &screen)
+    {
+        return drawOnWindow(screen, window_);
+    }
+
+    void Graphics::setTitle(const std::string &title)
+    {
+        setTitle(window_, title);
+    }
+
+    bool Graphics::closed()
+    {
+        return windowDisrupted(window_);
+    }
+
     utils::Result Graphics::initialise()
     {
         // Initialise GLFW
         if (!glfwInit())
         {
-            messenger_.printMessage("Failed to initialise GLFW");
+            messenger_.log<utils::Level::Error>("Failed to initialise GLFW");
             return utils::Result::Failure;
         }
 
@@ -29,10 +72,10 @@ namespace emulator::graphics
     std::optional<GLFWwindow *> Graphics::getWindow()
     {
         // Open a window and create its OpenGL context
-        GLFWwindow *window = glfwCreateWindow(MODIFIED_WIDTH, MODIFIED_HEIGHT, "CHIP Display", NULL, NULL);
+        GLFWwindow *window = glfwCreateWindow(MODIFIED_WIDTH, MODIFIED_HEIGHT, WINDOW_TITLE, NULL, NULL);
         if (window == NULL)
         {
-            messenger_.printMessage("Failed to open GLFW window. Ensure you have the recommended libraries installed");
+            messenger_.log<utils::Level::Error>("Failed to open GLFW window. Ensure you have the recommended libraries installed");
             glfwTerminate();
             return std::nullopt;
         }
@@ -41,7 +84,7 @@ namespace emulator::graphics
         // Initialize GLEW
         if (glewInit() != GLEW_OK)
         {
-            messenger_.printMessage("Failed to initialize GLEW");
+            messenger_.log<utils::Level::Error>("Failed to initialize GLEW");
             glfwTerminate();
             return std::nullopt;
         }
@@ -54,121 +97,207 @@ namespace emulator::graphics
         gluOrtho2D(0, MODIFIED_WIDTH, MODIFIED_HEIGHT, 0);
         glMatrixMode(GL_MODELVIEW);
         glViewport(0, 0, MODIFIED_WIDTH, MODIFIED_HEIGHT);
+        if (renderer_ == Renderer::Texture)
+        {
+            createScreenTexture();
+        }
         return window;
     }
 
-    utils::Result Graphics::drawOnWindow(const interpreter::Chip8 &Chip8, GLFWwindow *window)
+    void Graphics::createScreenTexture()
+    {
+        glGenTextures(1, &screen_texture_);
+        glBindTexture(GL_TEXTURE_2D, screen_texture_);
+        // nearest filtering keeps the pixels sharp when the texture is scaled up to the window
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // rows are 128 bytes wide, but do not rely on the default 4 byte alignment
+        // the texture is always 128x64, low resolution screens are expanded into it with every pixel doubled
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, interpreter::FrameBuffer::HIRES_WIDTH, interpreter::FrameBuffer::HIRES_HEIGHT, 0, GL_LUMINANCE,
+                     GL_UNSIGNED_BYTE, pixels_.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    utils::Result Graphics::drawOnWindow(const interpreter::FrameBuffer &screen, GLFWwindow *window)
     {
         clearWindow();
-        for (size_t col_num = 0; col_num < utils::SCREEN_HEIGHT; ++col_num)
+        if (renderer_ == Renderer::Texture)
+        {
+            drawTexture(screen);
+        }
+        else
+        {
+            drawImmediate(screen);
+        }
+        // Updating the window
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+        return utils::Result::Success;
+    }
+
+    void Graphics::drawImmediate(const interpreter::FrameBuffer &screen)
+    {
+        // pixels are half as big in high resolution, the window stays the same size
+        const int size = MODIFIED_WIDTH / screen.width();
+        for (int col_num = 0; col_num < screen.height(); ++col_num)
         {
-            for (size_t row_num = 0; row_num < utils::SCREEN_WIDTH; ++row_num)
+            for (int row_num = 0; row_num < screen.width(); ++row_num)
             {
-                const auto pixel_op = Chip8.readGraphicsBuffer((col_num * utils::SCREEN_WIDTH) + row_num);
-                if (!pixel_op)
-                {
-                    messenger_.printMessage("Failed to read graphics buffer");
-                    return utils::Result::Failure;
-                }
-                // Setting RGB according to whether pixel is on or off
-                if (*pixel_op == 0)
-                {
-                    glColor3f(0.0f, 0.0f, 0.0f);
-                }
-                else
-                {
-                    glColor3f(1.0f, 1.0f, 1.0f);
-                }
+                // Setting RGB according to the planes the pixel is on
+                const float level = PALETTE[screen.pixel(row_num, col_num)] / 255.0f;
+                glColor3f(level, level, level);
                 // Drawing the pixel as a square
                 glBegin(GL_QUADS);
-                glVertex2f((row_num * MODIFIER), (col_num * MODIFIER));
-                glVertex2f((row_num * MODIFIER), (col_num * MODIFIER) + MODIFIER);
-                glVertex2f((row_num * MODIFIER) + MODIFIER, (col_num * MODIFIER) + MODIFIER);
-                glVertex2f((row_num * MODIFIER) + MODIFIER, (col_num * MODIFIER));
+                glVertex2f((row_num * size), (col_num * size));
+                glVertex2f((row_num * size), (col_num * size) + size);
+                glVertex2f((row_num * size) + size, (col_num * size) + size);
+                glVertex2f((row_num * size) + size, (col_num * size));
                 glEnd();
             }
         }
-        // Updating the window
-        glfwSwapBuffers(window);
+    }
+
+    void Graphics::drawTexture(const interpreter::FrameBuffer &screen)
+    {
+        // expand the packed screen to luminance bytes and upload it in one call
+        screen.expand(pixels_.data(), PALETTE);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, screen_texture_);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, interpreter::FrameBuffer::HIRES_WIDTH, interpreter::FrameBuffer::HIRES_HEIGHT, GL_LUMINANCE,
+                        GL_UNSIGNED_BYTE, pixels_.data());
+        // one quad covering the whole window, texture row 0 is the top row of the screen
+        glColor3f(1.0f, 1.0f, 1.0f);
+        glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 0.0f);
+        glVertex2f(0.0f, 0.0f);
+        glTexCoord2f(0.0f, 1.0f);
+        glVertex2f(0.0f, MODIFIED_HEIGHT);
+        glTexCoord2f(1.0f, 1.0f);
+        glVertex2f(MODIFIED_WIDTH, MODIFIED_HEIGHT);
+        glTexCoord2f(1.0f, 0.0f);
+        glVertex2f(MODIFIED_WIDTH, 0.0f);
+        glEnd();
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDisable(GL_TEXTURE_2D);
+    }
+
+    void Graphics::pollEvents()
+    {
         glfwPollEvents();
-        return utils::Result::Success;
+    }
+
+    void Graphics::waitEvents(const double timeout)
+    {
+        glfwWaitEventsTimeout(timeout);
+    }
+
+    void Graphics::wake()
+    {
+        glfwPostEmptyEvent();
+    }
+
+    void Graphics::setTitle(GLFWwindow *window, const std::string &title)
+    {
+        glfwSetWindowTitle(window, title.c_str());
     }
 
     bool Graphics::windowDisrupted(GLFWwindow *window)
     {
-        return (glfwWindowShouldClose(window) == 0 || glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS) ? false : true;
+        return glfwWindowShouldClose(window) != 0 || glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS;
     }
 
     void Graphics::keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
     {
     }
 
-    void Graphics::setKeyReactFun(interpreter::Chip8 &Chip8, GLFWwindow *window)
+    void Graphics::setKeyReactFun(utils::KeyMailbox &keys, GLFWwindow *window)
     {
-        // Setting the user pointer to the Chip8 object so that the key callback can access it
-        glfwSetWindowUserPointer(window, &Chip8);
+        // Setting the user pointer to the key mailbox so that the key callback can access it
+        glfwSetWindowUserPointer(window, &keys);
         // GLFWKeyFun is a function pointer that can be used to set the key callback (I've used a lambda for this)
         glfwSetKeyCallback(
             window,
             [](GLFWwindow *window, int key, int scancode, int action, int mods)
             {
-                auto Chip8_ptr = reinterpret_cast<interpreter::Chip8 *>(glfwGetWindowUserPointer(window));
-                if (action == GLFW_PRESS || action == GLFW_REPEAT)
+                auto keys_ptr = reinterpret_cast<utils::KeyMailbox *>(glfwGetWindowUserPointer(window));
+                if (key == GLFW_KEY_BACKSPACE)
+                {
+                    // the emulation thread steps back a frame at a time for as long as backspace is held
+                    keys_ptr->holdRewind(action != GLFW_RELEASE);
+                    return;
+                }
+                if (key == GLFW_KEY_TAB)
                 {
-                    switch (key)
+                    // fast forward stays on until tab is pressed again
+                    if (action == GLFW_PRESS)
                     {
-                    case GLFW_KEY_1:
-                        Chip8_ptr->setKey(0x0);
-                        break;
-                    case GLFW_KEY_2:
-                        Chip8_ptr->setKey(0x1);
-                        break;
-                    case GLFW_KEY_3:
-                        Chip8_ptr->setKey(0x2);
-                        break;
-                    case GLFW_KEY_4:
-                        Chip8_ptr->setKey(0x3);
-                        break;
-                    case GLFW_KEY_Q:
-                        Chip8_ptr->setKey(0x4);
-                        break;
-                    case GLFW_KEY_W:
-                        Chip8_ptr->setKey(0x5);
-                        break;
-                    case GLFW_KEY_E:
-                        Chip8_ptr->setKey(0x6);
-                        break;
-                    case GLFW_KEY_R:
-                        Chip8_ptr->setKey(0x7);
-                        break;
-                    case GLFW_KEY_A:
-                        Chip8_ptr->setKey(0x8);
-                        break;
-                    case GLFW_KEY_S:
-                        Chip8_ptr->setKey(0x9);
-                        break;
-                    case GLFW_KEY_D:
-                        Chip8_ptr->setKey(0xA);
-                        break;
-                    case GLFW_KEY_F:
-                        Chip8_ptr->setKey(0xB);
-                        break;
-                    case GLFW_KEY_Z:
-                        Chip8_ptr->setKey(0xC);
-                        break;
-                    case GLFW_KEY_X:
-                        Chip8_ptr->setKey(0xD);
-                        break;
-                    case GLFW_KEY_C:
-                        Chip8_ptr->setKey(0xE);
-                        break;
-                    case GLFW_KEY_V:
-                        Chip8_ptr->setKey(0xF);
-                        break;
-                    default:
-                        break;
+                        keys_ptr->toggleFastForward();
                     }
+                    return;
+                }
+                // key repeats change nothing, the key is already down
+                if (action == GLFW_REPEAT)
+                {
+                    return;
+                }
+                int chip8_key;
+                switch (key)
+                {
+                case GLFW_KEY_1:
+                    chip8_key = 0x0;
+                    break;
+                case GLFW_KEY_2:
+                    chip8_key = 0x1;
+                    break;
+                case GLFW_KEY_3:
+                    chip8_key = 0x2;
+                    break;
+                case GLFW_KEY_4:
+                    chip8_key = 0x3;
+                    break;
+                case GLFW_KEY_Q:
+                    chip8_key = 0x4;
+                    break;
+                case GLFW_KEY_W:
+                    chip8_key = 0x5;
+                    break;
+                case GLFW_KEY_E:
+                    chip8_key = 0x6;
+                    break;
+                case GLFW_KEY_R:
+                    chip8_key = 0x7;
+                    break;
+                case GLFW_KEY_A:
+                    chip8_key = 0x8;
+                    break;
+                case GLFW_KEY_S:
+                    chip8_key = 0x9;
+                    break;
+                case GLFW_KEY_D:
+                    chip8_key = 0xA;
+                    break;
+                case GLFW_KEY_F:
+                    chip8_key = 0xB;
+                    break;
+                case GLFW_KEY_Z:
+                    chip8_key = 0xC;
+                    break;
+                case GLFW_KEY_X:
+                    chip8_key = 0xD;
+                    break;
+                case GLFW_KEY_C:
+                    chip8_key = 0xE;
+                    break;
+                case GLFW_KEY_V:
+                    chip8_key = 0xF;
+                    break;
+                default:
+                    return;
                 }
+                keys_ptr->post(static_cast<std::uint8_t>(chip8_key), action == GLFW_PRESS);
             });
     }
 
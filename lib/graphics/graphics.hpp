@@ -1,10 +1,15 @@
 #pragma once
 
 #include "common.hpp"
+#include "display.hpp"
 #include "messages.hpp"
-#include "interpreter.hpp"
+#include "framebuffer.hpp"
+#include "key_mailbox.hpp"
 
+#include <array>
+#include <memory>
 #include <optional>
+#include <string>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -14,12 +19,48 @@ namespace emulator::graphics
     static constexpr int MODIFIER = 10;
     static constexpr int MODIFIED_WIDTH = utils::SCREEN_WIDTH * MODIFIER;
     static constexpr int MODIFIED_HEIGHT = utils::SCREEN_HEIGHT * MODIFIER;
+    static constexpr const char *WINDOW_TITLE = "CHIP Display";
+    // luminance of a pixel by the planes it is on
+    static constexpr std::array<std::uint8_t, 4> PALETTE = interpreter::SHADES;
 
-    class Graphics
+    // how the Chip8 screen is put on the window
+    enum class Renderer
+    {
+        Immediate, // one immediate-mode quad per pixel
+        Texture,   // upload the screen as a texture and draw a single scaled quad
+        Terminal   // no window, half block characters on the terminal the emulator runs in
+    };
+
+    /**
+     * @brief Create the display a renderer draws on, a GLFW window or the terminal
+     */
+    std::unique_ptr<display::Display> makeDisplay(utils::Messenger &messenger, const Renderer renderer);
+
+    class Graphics : public display::Display
     {
     public:
-        Graphics(utils::Messenger &messenger);
-        ~Graphics();
+        Graphics(utils::Messenger &messenger, const Renderer renderer = Renderer::Texture);
+        ~Graphics() override;
+
+        /**
+         * @brief Initialise GLFW, open the window and send its key presses to the mailbox
+         */
+        utils::Result open(utils::KeyMailbox &keys) override;
+
+        /**
+         * @brief Draw a Chip8 screen on the window opened by open()
+         */
+        utils::Result present(const interpreter::FrameBuffer &screen) override;
+
+        /**
+         * @brief Replace the text in the title bar of the window opened by open()
+         */
+        void setTitle(const std::string &title) override;
+
+        /**
+         * @brief Check if the window opened by open() has been closed or the escape key pressed
+         */
+        bool closed() override;
 
         /**
          * @brief Initialise GLFW and set up hints
@@ -32,11 +73,32 @@ namespace emulator::graphics
         std::optional<GLFWwindow *> getWindow();
 
         /**
-         * @brief Draw the Chip8 screen (pixels stored in graphics_buffer) on the window
-         * @param Chip8 The Chip8 interpreter to draw from
+         * @brief Draw a Chip8 screen on the window
+         * @param screen The screen to draw
          * @param window The window to draw on
          */
-        utils::Result drawOnWindow(const interpreter::Chip8 &Chip8, GLFWwindow *window);
+        utils::Result drawOnWindow(const interpreter::FrameBuffer &screen, GLFWwindow *window);
+
+        /**
+         * @brief Process pending window and keyboard events without drawing
+         */
+        void pollEvents();
+
+        /**
+         * @brief Sleep until a window event arrives, wake() is called or the timeout runs out
+         * @param timeout The longest time to wait, in seconds
+         */
+        void waitEvents(const double timeout) override;
+
+        /**
+         * @brief Wake up a waitEvents call, can be called from any thread
+         */
+        void wake() override;
+
+        /**
+         * @brief Replace the text in the window's title bar
+         */
+        void setTitle(GLFWwindow *window, const std::string &title);
 
         /**
          * @brief Check if the window has been closed or the escape key pressed
@@ -46,10 +108,10 @@ namespace emulator::graphics
 
         /**
          * @brief Set the key callback function for the window
-         * @param Chip8 The Chip8 interpreter to pass to the callback function, so it can update the key states
+         * @param keys The mailbox key presses are posted to, the emulation thread picks them up from there
          * @param window The window to set the callback function for
          */
-        void setKeyReactFun(interpreter::Chip8 &Chip8, GLFWwindow *window);
+        void setKeyReactFun(utils::KeyMailbox &keys, GLFWwindow *window);
 
     private:
         /**
@@ -67,8 +129,28 @@ namespace emulator::graphics
          */
         void clearWindow();
 
+        /**
+         * @brief Create the texture the screen is uploaded to
+         */
+        void createScreenTexture();
+
+        /**
+         * @brief Draw every pixel as its own quad
+         */
+        void drawImmediate(const interpreter::FrameBuffer &screen);
+
+        /**
+         * @brief Upload the screen into the texture and draw it as one quad
+         */
+        void drawTexture(const interpreter::FrameBuffer &screen);
+
     private:
-        utils::Messenger messenger_;
+        utils::Messenger &messenger_;
+        Renderer renderer_;
+        GLFWwindow *window_ = nullptr;
+        GLuint screen_texture_ = 0;
+        // one byte per pixel staging area for texture uploads, always at high resolution
+        std::array<std::uint8_t, interpreter::FrameBuffer::HIRES_WIDTH * interpreter::FrameBuffer::HIRES_HEIGHT> pixels_{};
     };
 
 } // namespace graphics
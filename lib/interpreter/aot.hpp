@@ -0,0 +1,145 @@
+#pragma once
+
+#include "common.hpp"
+#include "interpreter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace emulator::interpreter
+{
+  // runs one basic block of a recompiled ROM and leaves pc on the instruction after it
+  using AotBlockFunction = void (*)(Chip8 &);
+
+  struct AotBlock
+  {
+    std::uint16_t address; // of the block's first instruction
+    std::uint16_t length;  // instructions it stands for, all of them run every time
+    AotBlockFunction run;
+  };
+
+  // a ROM translated to C++ ahead of time by chip8_recompile, one function per basic block
+  // the blocks assume memory still holds the ROM wherever the analysis found code, Chip8 stops calling them once a
+  // store changes a byte of it and goes back to them once the bytes are restored
+  struct AotProgram
+  {
+    const char *name;
+    utils::Platform platform; // the blocks follow this platform's rules, they are not run on any other
+    std::uint64_t rom_hash;   // XXH64 of the ROM, as RomImage::hash
+    const std::uint8_t *rom;
+    std::size_t rom_size;
+    // one byte per ROM byte, 1 where it is part of an instruction the analysis reached
+    const std::uint8_t *code;
+    const AotBlock *blocks;
+    std::size_t block_count;
+  };
+
+  // what the generated blocks reach of a machine: its registers, and the same instruction bodies both engines use
+  // for everything beyond register arithmetic, so a block does exactly what its instructions would have done
+  struct Aot
+  {
+    static std::uint8_t *V(Chip8 &chip8)
+    {
+      return chip8.V;
+    }
+
+    static std::uint16_t *stack(Chip8 &chip8)
+    {
+      return chip8.stack;
+    }
+
+    static std::uint16_t &I(Chip8 &chip8)
+    {
+      return chip8.I;
+    }
+
+    static std::uint16_t &pc(Chip8 &chip8)
+    {
+      return chip8.pc;
+    }
+
+    static std::uint8_t &sp(Chip8 &chip8)
+    {
+      return chip8.sp;
+    }
+
+    static std::uint8_t &delayTimer(Chip8 &chip8)
+    {
+      return chip8.delay_timer;
+    }
+
+    static std::uint8_t &soundTimer(Chip8 &chip8)
+    {
+      return chip8.sound_timer;
+    }
+
+    static const std::uint8_t *keyboard(Chip8 &chip8)
+    {
+      return chip8.keyboard;
+    }
+
+    static std::uint8_t random(Chip8 &chip8)
+    {
+      return chip8.random.nextByte();
+    }
+
+    static void clearScreen(Chip8 &chip8)
+    {
+      chip8.clearScreen();
+    }
+
+    static void screenControl(Chip8 &chip8, const std::uint16_t opcode)
+    {
+      chip8.screenControl(opcode);
+    }
+
+    static void drawSprite(Chip8 &chip8, const std::uint8_t x, const std::uint8_t y, const std::uint8_t n)
+    {
+      chip8.drawSprite(x, y, n);
+    }
+
+    // pc must already be past the jump
+    static void detectIdleLoop(Chip8 &chip8, const std::uint16_t target)
+    {
+      chip8.detectIdleLoop(target);
+    }
+
+    // pc must already be past the instruction, it is moved back onto it while no key is down
+    static void waitForKey(Chip8 &chip8, const std::uint8_t x)
+    {
+      chip8.waitForKey(x);
+    }
+
+    static void storeBcd(Chip8 &chip8, const std::uint8_t x)
+    {
+      chip8.storeBcd(x);
+    }
+
+    static void storeRegisters(Chip8 &chip8, const std::uint8_t x)
+    {
+      chip8.storeRegisters(x);
+    }
+
+    static void loadRegisters(Chip8 &chip8, const std::uint8_t x)
+    {
+      chip8.loadRegisters(x);
+    }
+
+    static void storeRange(Chip8 &chip8, const std::uint8_t x, const std::uint8_t y)
+    {
+      chip8.storeRange(x, y);
+    }
+
+    static void loadRange(Chip8 &chip8, const std::uint8_t x, const std::uint8_t y)
+    {
+      chip8.loadRange(x, y);
+    }
+
+    // only for the Fxnn instructions extendedMisc knows on the program's platform, and not for the long I load
+    static void extendedMisc(Chip8 &chip8, const std::uint8_t x, const std::uint8_t kk)
+    {
+      chip8.extendedMisc(x, kk);
+    }
+  };
+
+} // namespace emulator::interpreter
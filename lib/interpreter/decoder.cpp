@@ -0,0 +1,420 @@
+#include "interpreter.hpp"
+
+namespace emulator::interpreter
+{
+  // one handler per instruction, each mirrors the matching case of Chip8::stepSwitch
+  // pc has already been moved past the instruction when a handler runs
+  struct Handlers
+  {
+    static void sys(Chip8 &, const Chip8::Instruction &) // Sys addr - ignored
+    {
+    }
+
+    static void screen(Chip8 &c, const Chip8::Instruction &in) // SCD, SCU, SCR, SCL, EXIT, LOW, HIGH or Sys addr
+    {
+      c.screenControl(in.opcode);
+    }
+
+    static void cls(Chip8 &c, const Chip8::Instruction &) // CLS
+    {
+      c.clearScreen();
+    }
+
+    static void ret(Chip8 &c, const Chip8::Instruction &) // RET
+    {
+      c.pc = c.stack[--c.sp & 0xF];
+    }
+
+    static void jp(Chip8 &c, const Chip8::Instruction &in) // JP addr
+    {
+      c.pc = in.nnn;
+    }
+
+    static void jpIdle(Chip8 &c, const Chip8::Instruction &in) // JP addr that may close an idle loop, see Chip8::detectIdleLoop
+    {
+      c.detectIdleLoop(in.nnn);
+      c.pc = in.nnn;
+    }
+
+    static void call(Chip8 &c, const Chip8::Instruction &in) // CALL addr
+    {
+      c.stack[c.sp & 0xF] = c.pc;
+      ++c.sp;
+      c.pc = in.nnn;
+    }
+
+    static void seByte(Chip8 &c, const Chip8::Instruction &in) // SE Vx, byte
+    {
+      if (c.V[in.x] == in.kk)
+      {
+        c.skip();
+      }
+    }
+
+    static void sneByte(Chip8 &c, const Chip8::Instruction &in) // SNE Vx, byte
+    {
+      if (c.V[in.x] != in.kk)
+      {
+        c.skip();
+      }
+    }
+
+    static void seReg(Chip8 &c, const Chip8::Instruction &in) // SE Vx, Vy
+    {
+      if (c.V[in.x] == c.V[in.y])
+      {
+        c.skip();
+      }
+    }
+
+    static void saveRange(Chip8 &c, const Chip8::Instruction &in) // SAVE Vx - Vy
+    {
+      c.storeRange(in.x, in.y);
+    }
+
+    static void loadRange(Chip8 &c, const Chip8::Instruction &in) // LOAD Vx - Vy
+    {
+      c.loadRange(in.x, in.y);
+    }
+
+    static void ldByte(Chip8 &c, const Chip8::Instruction &in) // LD Vx, byte
+    {
+      c.V[in.x] = in.kk;
+    }
+
+    static void addByte(Chip8 &c, const Chip8::Instruction &in) // ADD Vx, byte
+    {
+      c.V[in.x] += in.kk;
+    }
+
+    static void ldReg(Chip8 &c, const Chip8::Instruction &in) // LD Vx, Vy
+    {
+      c.V[in.x] = c.V[in.y];
+    }
+
+    static void orReg(Chip8 &c, const Chip8::Instruction &in) // OR Vx, Vy
+    {
+      c.V[in.x] |= c.V[in.y];
+    }
+
+    static void andReg(Chip8 &c, const Chip8::Instruction &in) // AND Vx, Vy
+    {
+      c.V[in.x] &= c.V[in.y];
+    }
+
+    static void xorReg(Chip8 &c, const Chip8::Instruction &in) // XOR Vx, Vy
+    {
+      c.V[in.x] ^= c.V[in.y];
+    }
+
+    static void addReg(Chip8 &c, const Chip8::Instruction &in) // ADD Vx, Vy
+    {
+      c.V[0xF] = (c.V[in.y] > (0xFF - c.V[in.x])) ? 1 : 0;
+      c.V[in.x] += c.V[in.y];
+    }
+
+    static void subReg(Chip8 &c, const Chip8::Instruction &in) // SUB Vx, Vy
+    {
+      c.V[0xF] = (c.V[in.y] > c.V[in.x]) ? 0 : 1;
+      c.V[in.x] -= c.V[in.y];
+    }
+
+    static void shr(Chip8 &c, const Chip8::Instruction &in) // SHR Vx
+    {
+      c.V[0xF] = c.V[in.x] & 0x1;
+      c.V[in.x] >>= 1;
+    }
+
+    static void shrVy(Chip8 &c, const Chip8::Instruction &in) // SHR Vx, Vy
+    {
+      const std::uint8_t source = c.V[in.y];
+      c.V[0xF] = source & 0x1;
+      c.V[in.x] = source >> 1;
+    }
+
+    static void subn(Chip8 &c, const Chip8::Instruction &in) // SUBN Vx, Vy
+    {
+      c.V[0xF] = (c.V[in.x] > c.V[in.y]) ? 0 : 1;
+      c.V[in.x] = c.V[in.y] - c.V[in.x];
+    }
+
+    static void shl(Chip8 &c, const Chip8::Instruction &in) // SHL Vx
+    {
+      c.V[0xF] = (c.V[in.x] >> 7);
+      c.V[in.x] <<= 1;
+    }
+
+    static void shlVy(Chip8 &c, const Chip8::Instruction &in) // SHL Vx, Vy
+    {
+      const std::uint8_t source = c.V[in.y];
+      c.V[0xF] = source >> 7;
+      c.V[in.x] = source << 1;
+    }
+
+    static void sneReg(Chip8 &c, const Chip8::Instruction &in) // SNE Vx, Vy
+    {
+      if (c.V[in.x] != c.V[in.y])
+      {
+        c.skip();
+      }
+    }
+
+    static void ldI(Chip8 &c, const Chip8::Instruction &in) // LD I, addr
+    {
+      c.I = in.nnn;
+    }
+
+    static void jpV0(Chip8 &c, const Chip8::Instruction &in) // JP V0, addr
+    {
+      c.pc = in.nnn + c.V[0];
+    }
+
+    static void jpVx(Chip8 &c, const Chip8::Instruction &in) // JP Vx, addr
+    {
+      c.pc = in.nnn + c.V[in.x];
+    }
+
+    static void rnd(Chip8 &c, const Chip8::Instruction &in) // RND Vx, byte
+    {
+      c.V[in.x] = c.random.nextByte() & in.kk;
+    }
+
+    static void drw(Chip8 &c, const Chip8::Instruction &in) // DRW Vx, Vy, nibble
+    {
+      c.drawSprite(in.x, in.y, in.n);
+    }
+
+    static void skp(Chip8 &c, const Chip8::Instruction &in) // SKP Vx
+    {
+      if (c.keyboard[c.V[in.x] & 0xF] == 1)
+      {
+        c.skip();
+      }
+    }
+
+    static void sknp(Chip8 &c, const Chip8::Instruction &in) // SKNP Vx
+    {
+      if (c.keyboard[c.V[in.x] & 0xF] == 0)
+      {
+        c.skip();
+      }
+    }
+
+    static void ldVxDt(Chip8 &c, const Chip8::Instruction &in) // LD Vx, DT
+    {
+      c.V[in.x] = c.delay_timer;
+    }
+
+    static void ldKey(Chip8 &c, const Chip8::Instruction &in) // LD Vx, K
+    {
+      c.waitForKey(in.x);
+    }
+
+    static void ldDtVx(Chip8 &c, const Chip8::Instruction &in) // LD DT, Vx
+    {
+      c.delay_timer = c.V[in.x];
+    }
+
+    static void ldStVx(Chip8 &c, const Chip8::Instruction &in) // LD ST, Vx
+    {
+      c.sound_timer = c.V[in.x];
+    }
+
+    static void addI(Chip8 &c, const Chip8::Instruction &in) // ADD I, Vx
+    {
+      c.I += c.V[in.x];
+    }
+
+    static void ldFont(Chip8 &c, const Chip8::Instruction &in) // LD F, Vx
+    {
+      c.I = c.V[in.x] * 5;
+    }
+
+    static void ldBcd(Chip8 &c, const Chip8::Instruction &in) // LD B, Vx
+    {
+      c.storeBcd(in.x);
+    }
+
+    static void store(Chip8 &c, const Chip8::Instruction &in) // LD [I], Vx
+    {
+      c.storeRegisters(in.x);
+    }
+
+    static void load(Chip8 &c, const Chip8::Instruction &in) // LD Vx, [I]
+    {
+      c.loadRegisters(in.x);
+    }
+
+    static void extended(Chip8 &c, const Chip8::Instruction &in) // Fxnn of SUPER-CHIP and XO-CHIP
+    {
+      if (!c.extendedMisc(in.x, in.kk))
+      {
+        c.unknownOpcode(in.opcode);
+      }
+    }
+
+    static void unknown(Chip8 &c, const Chip8::Instruction &in)
+    {
+      c.unknownOpcode(in.opcode);
+    }
+
+    /**
+     * @brief Pick the handler for an opcode, following the same decoding as Chip8::stepSwitch
+     */
+    static Chip8::Handler select(const std::uint16_t opcode, const utils::Platform platform)
+    {
+      const bool chip8 = (platform == utils::Platform::Chip8);
+      const bool xo = (platform == utils::Platform::XoChip);
+      switch (opcode & 0xF000)
+      {
+      case 0x0000:
+        return (opcode == 0x00E0) ? &cls : (opcode == 0x00EE) ? &ret
+                                         : chip8              ? &sys
+                                                              : &screen;
+      case 0x1000:
+        return &jp;
+      case 0x2000:
+        return &call;
+      case 0x3000:
+        return &seByte;
+      case 0x4000:
+        return &sneByte;
+      case 0x5000:
+        switch (xo ? (opcode & 0x000F) : 0x0000)
+        {
+        case 0x0000:
+          return &seReg;
+        case 0x0002:
+          return &saveRange;
+        case 0x0003:
+          return &loadRange;
+        default:
+          return &unknown;
+        }
+      case 0x6000:
+        return &ldByte;
+      case 0x7000:
+        return &addByte;
+      case 0x8000:
+        switch (opcode & 0x000F)
+        {
+        case 0x0000:
+          return &ldReg;
+        case 0x0001:
+          return &orReg;
+        case 0x0002:
+          return &andReg;
+        case 0x0003:
+          return &xorReg;
+        case 0x0004:
+          return &addReg;
+        case 0x0005:
+          return &subReg;
+        case 0x0006:
+          return xo ? &shrVy : &shr;
+        case 0x0007:
+          return &subn;
+        case 0x000E:
+          return xo ? &shlVy : &shl;
+        default:
+          return &unknown;
+        }
+      case 0x9000:
+        return &sneReg;
+      case 0xA000:
+        return &ldI;
+      case 0xB000:
+        return (platform == utils::Platform::SuperChip) ? &jpVx : &jpV0;
+      case 0xC000:
+        return &rnd;
+      case 0xD000:
+        return &drw;
+      case 0xE000:
+        switch (opcode & 0x00FF)
+        {
+        case 0x009E:
+          return &skp;
+        case 0x00A1:
+          return &sknp;
+        default:
+          return &unknown;
+        }
+      default: // 0xF000
+        switch (opcode & 0x00FF)
+        {
+        case 0x0007:
+          return &ldVxDt;
+        case 0x000A:
+          return &ldKey;
+        case 0x0015:
+          return &ldDtVx;
+        case 0x0018:
+          return &ldStVx;
+        case 0x001E:
+          return &addI;
+        case 0x0029:
+          return &ldFont;
+        case 0x0033:
+          return &ldBcd;
+        case 0x0055:
+          return &store;
+        case 0x0065:
+          return &load;
+        default:
+          return chip8 ? &unknown : &extended;
+        }
+      }
+    }
+  };
+
+  Chip8::Instruction Chip8::decode(const std::uint16_t address) const
+  {
+    const std::uint16_t opcode = readMemory(address) << 8 | readMemory(address + 1);
+    Instruction instruction;
+    instruction.handler = Handlers::select(opcode, platform);
+    instruction.opcode = opcode;
+    instruction.nnn = opcode & 0x0FFF;
+    // only jumps onto themselves or two instructions back can close an idle loop, the rest skip the check
+    if (instruction.handler == &Handlers::jp && (instruction.nnn == address || instruction.nnn == address - 4))
+    {
+      instruction.handler = &Handlers::jpIdle;
+    }
+    instruction.x = (opcode & 0x0F00) >> 8;
+    instruction.y = (opcode & 0x00F0) >> 4;
+    instruction.kk = opcode & 0x00FF;
+    instruction.n = opcode & 0x000F;
+    return instruction;
+  }
+
+  void Chip8::fillInstructionCache()
+  {
+    // every address gets an entry, jumps to odd addresses are legal
+    instruction_cache.resize(addressSpace());
+    for (std::size_t address = 0; address < addressSpace(); ++address)
+    {
+      instruction_cache[address] = decode(address);
+    }
+  }
+
+  void Chip8::decodeAndExecute(Chip8 &chip8, const Instruction &)
+  {
+    const std::uint16_t address = chip8.pc - 2;
+    Instruction &fresh = chip8.instruction_cache[address];
+    fresh = chip8.decode(address);
+    fresh.handler(chip8, fresh);
+  }
+
+  void Chip8::stepCached()
+  {
+    // the last byte of memory cannot start a whole instruction, leave that (and anything past it) to the switch
+    if (pc >= addressSpace() - 1)
+    {
+      stepSwitch();
+      return;
+    }
+    const Instruction &instruction = instruction_cache[pc];
+    pc += 2;
+    instruction.handler(*this, instruction);
+  }
+
+} // namespace emulator::interpreter
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "framebuffer.hpp"
+#include "hash.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace emulator::interpreter
+{
+  namespace
+  {
+    constexpr std::array<PixelRow, 256> makeByteToPixels()
+    {
+      std::array<PixelRow, 256> table{};
+      for (std::size_t byte = 0; byte < 256; ++byte)
+      {
+        for (std::size_t bit = 0; bit < 8; ++bit)
+        {
+          table[byte][bit] = (byte >> (7 - bit)) & 0x1;
+        }
+      }
+      return table;
+    }
+  } // namespace
+
+  const std::array<PixelRow, 256> BYTE_TO_PIXELS = makeByteToPixels();
+
+  namespace
+  {
+    // a screen row as one 128-bit value, hi holding the leftmost 64 pixels
+    struct Bits
+    {
+      std::uint64_t hi;
+      std::uint64_t lo;
+    };
+
+    Bits shiftRight(const Bits bits, const int count)
+    {
+      if (count == 0)
+      {
+        return bits;
+      }
+      if (count >= 64)
+      {
+        return {0, (count >= 128) ? 0 : bits.hi >> (count - 64)};
+      }
+      return {bits.hi >> count, (bits.lo >> count) | (bits.hi << (64 - count))};
+    }
+
+    Bits shiftLeft(const Bits bits, const int count)
+    {
+      if (count == 0)
+      {
+        return bits;
+      }
+      if (count >= 64)
+      {
+        return {(count >= 128) ? 0 : bits.lo << (count - 64), 0};
+      }
+      return {(bits.hi << count) | (bits.lo >> (64 - count)), bits.lo << count};
+    }
+  } // namespace
+
+  std::uint64_t *FrameBuffer::row(const int plane, const int y)
+  {
+    return words_.data() + (plane * HIRES_HEIGHT + y) * WORDS_PER_ROW;
+  }
+
+  const std::uint64_t *FrameBuffer::row(const int plane, const int y) const
+  {
+    return words_.data() + (plane * HIRES_HEIGHT + y) * WORDS_PER_ROW;
+  }
+
+  void FrameBuffer::clear()
+  {
+    words_.fill(0);
+  }
+
+  void FrameBuffer::clear(const std::uint8_t planes)
+  {
+    for (int plane = 0; plane < PLANES; ++plane)
+    {
+      if (planes & (1 << plane))
+      {
+        std::memset(row(plane, 0), 0, HIRES_HEIGHT * WORDS_PER_ROW * sizeof(std::uint64_t));
+      }
+    }
+  }
+
+  void FrameBuffer::setHires(const bool hires)
+  {
+    hires_ = hires ? 1 : 0;
+    clear();
+  }
+
+  bool FrameBuffer::hires() const
+  {
+    return hires_ != 0;
+  }
+
+  int FrameBuffer::width() const
+  {
+    return hires_ ? HIRES_WIDTH : WIDTH;
+  }
+
+  int FrameBuffer::height() const
+  {
+    return hires_ ? HIRES_HEIGHT : HEIGHT;
+  }
+
+  bool FrameBuffer::drawRow(const int x, const int y, const std::uint8_t sprite)
+  {
+    // place the sprite at the top of the word and slide it right, bits pushed past column 63 fall off
+    const std::uint64_t bits = (static_cast<std::uint64_t>(sprite) << 56) >> x;
+    std::uint64_t &word = row(0, y)[0];
+    const bool collision = (word & bits) != 0;
+    word ^= bits;
+    return collision;
+  }
+
+  bool FrameBuffer::drawRow(const int plane, const int x, const int y, const std::uint16_t sprite, const int count, const bool wrap)
+  {
+    const int screen_width = width();
+    const Bits aligned{static_cast<std::uint64_t>(sprite) << (64 - count), 0};
+    Bits bits = shiftRight(aligned, x);
+    if (wrap && x + count > screen_width)
+    {
+      // the pixels that went past the right edge, moved back by a whole screen width
+      const Bits wrapped = shiftLeft(aligned, screen_width - x);
+      bits.hi |= wrapped.hi;
+      bits.lo |= wrapped.lo;
+    }
+    if (screen_width == WIDTH)
+    {
+      bits.lo = 0;
+    }
+    std::uint64_t *words = row(plane, y);
+    const bool collision = ((words[0] & bits.hi) | (words[1] & bits.lo)) != 0;
+    words[0] ^= bits.hi;
+    words[1] ^= bits.lo;
+    return collision;
+  }
+
+  void FrameBuffer::scrollDown(const int rows, const std::uint8_t planes)
+  {
+    const int moved = std::min(rows, height());
+    const std::size_t row_bytes = WORDS_PER_ROW * sizeof(std::uint64_t);
+    for (int plane = 0; plane < PLANES; ++plane)
+    {
+      if (planes & (1 << plane))
+      {
+        std::memmove(row(plane, moved), row(plane, 0), (height() - moved) * row_bytes);
+        std::memset(row(plane, 0), 0, moved * row_bytes);
+      }
+    }
+  }
+
+  void FrameBuffer::scrollUp(const int rows, const std::uint8_t planes)
+  {
+    const int moved = std::min(rows, height());
+    const std::size_t row_bytes = WORDS_PER_ROW * sizeof(std::uint64_t);
+    for (int plane = 0; plane < PLANES; ++plane)
+    {
+      if (planes & (1 << plane))
+      {
+        std::memmove(row(plane, 0), row(plane, moved), (height() - moved) * row_bytes);
+        std::memset(row(plane, height() - moved), 0, moved * row_bytes);
+      }
+    }
+  }
+
+  void FrameBuffer::scrollRight(const int columns, const std::uint8_t planes)
+  {
+    for (int plane = 0; plane < PLANES; ++plane)
+    {
+      for (int y = 0; (planes & (1 << plane)) && y < height(); ++y)
+      {
+        std::uint64_t *words = row(plane, y);
+        const Bits bits = shiftRight({words[0], words[1]}, columns);
+        words[0] = bits.hi;
+        // pixels moved past column 63 of the low resolution screen fall off
+        words[1] = hires_ ? bits.lo : 0;
+      }
+    }
+  }
+
+  void FrameBuffer::scrollLeft(const int columns, const std::uint8_t planes)
+  {
+    for (int plane = 0; plane < PLANES; ++plane)
+    {
+      for (int y = 0; (planes & (1 << plane)) && y < height(); ++y)
+      {
+        std::uint64_t *words = row(plane, y);
+        const Bits bits = shiftLeft({words[0], words[1]}, columns);
+        words[0] = bits.hi;
+        words[1] = bits.lo;
+      }
+    }
+  }
+
+  std::uint8_t FrameBuffer::pixel(const int x, const int y) const
+  {
+    const int shift = 63 - x % 64;
+    return static_cast<std::uint8_t>(((row(0, y)[x / 64] >> shift) & 0x1) | (((row(1, y)[x / 64] >> shift) & 0x1) << 1));
+  }
+
+  void FrameBuffer::expand(std::uint8_t *pixels, const std::array<std::uint8_t, 4> &palette) const
+  {
+    // a byte of both planes at a time, doubled horizontally and every row written twice in low resolution
+    const int scale = hires_ ? 1 : 2;
+    for (int y = 0; y < HIRES_HEIGHT; ++y)
+    {
+      std::uint8_t *out = pixels + y * HIRES_WIDTH;
+      if (y % scale != 0)
+      {
+        std::memcpy(out, out - HIRES_WIDTH, HIRES_WIDTH);
+        continue;
+      }
+      const std::uint64_t *first = row(0, y / scale);
+      const std::uint64_t *second = row(1, y / scale);
+      for (int x = 0; x < HIRES_WIDTH / scale; x += 8)
+      {
+        const int shift = 56 - x % 64;
+        const PixelRow &low = BYTE_TO_PIXELS[(first[x / 64] >> shift) & 0xFF];
+        const PixelRow &high = BYTE_TO_PIXELS[(second[x / 64] >> shift) & 0xFF];
+        for (int bit = 0; bit < 8; ++bit)
+        {
+          const std::uint8_t value = palette[low[bit] | (high[bit] << 1)];
+          for (int copy = 0; copy < scale; ++copy)
+          {
+            *out++ = value;
+          }
+        }
+      }
+    }
+  }
+
+  std::uint64_t FrameBuffer::hash() const
+  {
+    return utils::fnv1a(words_.data(), sizeof(words_), utils::fnv1a(&hires_, sizeof(hires_)));
+  }
+
+  const std::uint64_t *FrameBuffer::words() const
+  {
+    return words_.data();
+  }
+
+  void FrameBuffer::load(const std::uint64_t *words, const bool hires)
+  {
+    std::memcpy(words_.data(), words, sizeof(words_));
+    hires_ = hires ? 1 : 0;
+  }
+
+} // namespace emulator::interpreter
\ No newline at end of file
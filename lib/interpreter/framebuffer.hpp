@@ -0,0 +1,144 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace emulator::interpreter
+{
+  // pixels of one sprite byte, most significant bit first, each either 0 or 1
+  using PixelRow = std::array<std::uint8_t, 8>;
+
+  /**
+   * @brief Lookup table expanding a byte of packed pixels into one byte per pixel
+   */
+  extern const std::array<PixelRow, 256> BYTE_TO_PIXELS;
+
+  // luminance of a pixel by the planes it is on: off, first plane (all CHIP-8 and SUPER-CHIP draw), second plane, both
+  static constexpr std::array<std::uint8_t, 4> SHADES = {0x00, 0xFF, 0x70, 0xB0};
+
+  // display packed one bit per pixel in two bit-planes, as XO-CHIP has them (CHIP-8 and SUPER-CHIP only draw on the first)
+  // every row of a plane is two 64-bit words with the leftmost pixel in the most significant bit of the first one,
+  // so sprites are xor-ed a row at a time and scrolls are word shifts
+  // in low resolution the screen is 64x32 and only the first word of the first 32 rows is used, in high resolution 128x64
+  class FrameBuffer
+  {
+  public:
+    static constexpr int WIDTH = utils::SCREEN_WIDTH;
+    static constexpr int HEIGHT = utils::SCREEN_HEIGHT;
+    static constexpr int HIRES_WIDTH = 2 * WIDTH;
+    static constexpr int HIRES_HEIGHT = 2 * HEIGHT;
+    static constexpr int PLANES = 2;
+    static constexpr int WORDS_PER_ROW = HIRES_WIDTH / 64;
+    static constexpr int WORDS = PLANES * HIRES_HEIGHT * WORDS_PER_ROW;
+
+    /**
+     * @brief Turn every pixel of every plane off
+     */
+    void clear();
+
+    /**
+     * @brief Turn every pixel of the selected planes off
+     * @param planes One bit per plane
+     */
+    void clear(const std::uint8_t planes);
+
+    /**
+     * @brief Switch between 64x32 and 128x64, the screen is cleared
+     */
+    void setHires(const bool hires);
+
+    bool hires() const;
+
+    /**
+     * @brief Width of the screen in its current resolution
+     */
+    int width() const;
+
+    /**
+     * @brief Height of the screen in its current resolution
+     */
+    int height() const;
+
+    /**
+     * @brief XOR an 8 pixel wide sprite row onto the first plane of the low resolution screen, clipped at the right edge
+     * @param x The column of the leftmost sprite pixel (0-63)
+     * @param y The row to draw on (0-31)
+     * @param sprite The sprite row, most significant bit leftmost
+     * @return true if any pixel that was on got turned off
+     */
+    bool drawRow(const int x, const int y, const std::uint8_t sprite);
+
+    /**
+     * @brief XOR a sprite row of up to 16 pixels onto one plane in the current resolution
+     * @param plane The plane to draw on
+     * @param x The column of the leftmost sprite pixel, below width()
+     * @param y The row to draw on, below height()
+     * @param sprite The sprite row, its first pixel in bit count - 1
+     * @param count The number of pixels in the row, 8 or 16
+     * @param wrap Pixels past the right edge come back on the left instead of being clipped
+     * @return true if any pixel that was on got turned off
+     */
+    bool drawRow(const int plane, const int x, const int y, const std::uint16_t sprite, const int count, const bool wrap);
+
+    /**
+     * @brief Move the selected planes down, rows scrolled in at the top are blank
+     */
+    void scrollDown(const int rows, const std::uint8_t planes);
+
+    /**
+     * @brief Move the selected planes up, rows scrolled in at the bottom are blank
+     */
+    void scrollUp(const int rows, const std::uint8_t planes);
+
+    /**
+     * @brief Move the selected planes right, columns scrolled in on the left are blank
+     */
+    void scrollRight(const int columns, const std::uint8_t planes);
+
+    /**
+     * @brief Move the selected planes left, columns scrolled in on the right are blank
+     */
+    void scrollLeft(const int columns, const std::uint8_t planes);
+
+    /**
+     * @brief Get a single pixel in the current resolution
+     * @return The bits of the planes the pixel is on in, 0 if it is off everywhere
+     */
+    std::uint8_t pixel(const int x, const int y) const;
+
+    /**
+     * @brief Expand the whole screen to one byte per pixel at 128x64, low resolution pixels are doubled
+     * @param pixels Destination holding at least HIRES_WIDTH * HIRES_HEIGHT bytes
+     * @param palette The value written for every combination of planes, index 0 for pixels that are off
+     */
+    void expand(std::uint8_t *pixels, const std::array<std::uint8_t, 4> &palette = {0, 1, 2, 3}) const;
+
+    /**
+     * @brief Hash the screen contents, equal screens give equal hashes
+     */
+    std::uint64_t hash() const;
+
+    /**
+     * @brief The packed pixels, WORDS of them: the first plane then the second, HIRES_HEIGHT rows of WORDS_PER_ROW words each
+     */
+    const std::uint64_t *words() const;
+
+    /**
+     * @brief Replace the whole screen, for screens stored elsewhere as words()
+     */
+    void load(const std::uint64_t *words, const bool hires);
+
+  private:
+    std::uint64_t *row(const int plane, const int y);
+    const std::uint64_t *row(const int plane, const int y) const;
+
+  private:
+    std::array<std::uint64_t, WORDS> words_{};
+    // a whole word so the buffer has no padding and can be diffed as raw bytes inside a Snapshot
+    std::uint64_t hires_ = 0;
+  };
+
+} // namespace emulator::interpreter
@@ -1,80 +1,485 @@
 #include "interpreter.hpp"
+#include "aot.hpp"
+#include "jit.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
 
 namespace emulator::interpreter
 {
   Chip8::Chip8(utils::Messenger &messenger)
-      : messenger_(messenger)
+      : messenger_(messenger), random(DEFAULT_SEED), platform(utils::Platform::Chip8), address_mask(CHIP8_MEMORY_SIZE - 1),
+        engine(utils::Engine::Switch), program(nullptr), stale_code(0)
   {
     initialise();
   }
 
+  Chip8::~Chip8() = default;
+
   void Chip8::initialise()
   {
     pc = 0x200; // program counter starts at 0x200
     I = 0;      // reset index register
     sp = 0;     // reset stack pointer
 
+    // clear memory and registers so every run starts from the same state
+    memset(memory, 0, sizeof(memory));
+    memset(V, 0, sizeof(V));
+
     // populate interpreter-memory with fontset
-    for (size_t i = 0; i < 80; ++i)
-    {
-      memory[i] = chip8_fontset[i];
-    }
+    memcpy(memory, FONTSET, sizeof(FONTSET));
+    memcpy(memory + BIG_FONT_START, BIG_FONTSET, sizeof(BIG_FONTSET));
+    // nothing forked or loaded yet that memory or the screen could be shared with
+    mirrored_pages.fill(nullptr);
+    dirty_pages = 0;
+    mirrored_screen.reset();
+    screen_dirty = false;
 
     // clear display, keyboard and stack
-    memset(graphics_buffer, 0, sizeof(graphics_buffer));
+    graphics_buffer.setHires(false);
     memset(keyboard, 0, sizeof(keyboard));
     memset(stack, 0, sizeof(stack));
+    memset(flags, 0, sizeof(flags));
+
+    planes = 0x1;
+    memset(audio_pattern, 0, sizeof(audio_pattern));
+    pitch = 64;
+    pattern_loaded = false;
 
     delay_timer = 0;
     sound_timer = 0;
 
     terminate = utils::Flag::Lowered;
     draw = utils::Flag::Lowered;
+    buzz = utils::Flag::Lowered;
+
+    idle_length = 0;
+    idle_register = 16;
+    waiting_for_key = false;
+
+    CHIP8_PROFILE_ONLY(profiler_.reset();)
   }
 
-  // add exception handling
   utils::Result Chip8::loadGame(const char *filename)
   {
     messenger_.printMessage("Loading game ", filename, "...");
-    std::ifstream file(filename, std::ios::in | std::ios::binary);
-    if (file.is_open())
+    // the file is mapped rather than read, its bytes are copied straight into memory by loadRom
+    const auto file = utils::MappedFile::open(filename);
+    if (!file || loadRom(file->data(), file->size()) == utils::Result::Failure)
+    {
+      messenger_.log<utils::Level::Error>("Failed to load game!");
+      return utils::Result::Failure;
+    }
+    messenger_.printMessage("Game loaded successfully!");
+    return utils::Result::Success;
+  }
+
+  utils::Result Chip8::loadRom(const std::uint8_t *rom, const std::size_t size)
+  {
+    if (size > addressSpace() - PROGRAM_START)
+    {
+      messenger_.log<utils::Level::Error>("The game is ", size, " bytes, only ", addressSpace() - PROGRAM_START, " fit in memory");
+      return utils::Result::Failure;
+    }
+    if (size > 0)
+    {
+      memcpy(memory + PROGRAM_START, rom, size);
+      // written around writeMemory, no page can be shared as it was
+      dirty_pages = ~std::uint64_t{0};
+    }
+    if (engine != utils::Engine::Switch)
+    {
+      fillInstructionCache();
+    }
+    if (jit)
+    {
+      jit->flush();
+    }
+    if (program)
+    {
+      checkProgramCode();
+    }
+    return utils::Result::Success;
+  }
+
+  void Chip8::saveState(Snapshot &snapshot) const
+  {
+    snapshot.screen = graphics_buffer;
+    // a CHIP-8 or SUPER-CHIP program cannot reach past its 4K, whatever the rest of memory holds it is saved as zeroes
+    memcpy(snapshot.memory, memory, addressSpace());
+    memset(snapshot.memory + addressSpace(), 0, sizeof(memory) - addressSpace());
+    memcpy(snapshot.stack, stack, sizeof(stack));
+    snapshot.I = I;
+    snapshot.pc = pc;
+    snapshot.sp = sp;
+    memcpy(snapshot.V, V, sizeof(V));
+    snapshot.delay_timer = delay_timer;
+    snapshot.sound_timer = sound_timer;
+    snapshot.random_state = random.state();
+    memcpy(snapshot.flags, flags, sizeof(flags));
+    memcpy(snapshot.audio_pattern, audio_pattern, sizeof(audio_pattern));
+    snapshot.planes = planes;
+    snapshot.pitch = pitch;
+    snapshot.pattern_loaded = pattern_loaded ? 1 : 0;
+    memset(snapshot.reserved, 0, sizeof(snapshot.reserved));
+  }
+
+  void Chip8::setPlatform(const utils::Platform platform)
+  {
+    this->platform = platform;
+    address_mask = static_cast<std::uint32_t>(((platform == utils::Platform::XoChip) ? MEMORY_SIZE : CHIP8_MEMORY_SIZE) - 1);
+    // the instruction cache and the compiled code are sized and decoded for the platform, start them over
+    setEngine(engine);
+  }
+
+  utils::Platform Chip8::getPlatform() const
+  {
+    return platform;
+  }
+
+  std::size_t Chip8::addressSpace() const
+  {
+    return std::size_t{address_mask} + 1;
+  }
+
+  void Chip8::seed(const std::uint64_t seed)
+  {
+    random.reseed(seed);
+  }
+
+  void Chip8::loadState(const Snapshot &snapshot)
+  {
+    restoreMemory(0, snapshot.memory, addressSpace());
+    graphics_buffer = snapshot.screen;
+    memcpy(stack, snapshot.stack, sizeof(stack));
+    I = snapshot.I;
+    pc = snapshot.pc;
+    sp = static_cast<std::uint8_t>(snapshot.sp);
+    memcpy(V, snapshot.V, sizeof(V));
+    delay_timer = snapshot.delay_timer;
+    sound_timer = snapshot.sound_timer;
+    random.restore(snapshot.random_state);
+    memcpy(flags, snapshot.flags, sizeof(flags));
+    memcpy(audio_pattern, snapshot.audio_pattern, sizeof(audio_pattern));
+    planes = snapshot.planes;
+    pitch = snapshot.pitch;
+    pattern_loaded = snapshot.pattern_loaded != 0;
+    idle_length = 0;
+    waiting_for_key = false;
+    screenChanged();
+  }
+
+  void Chip8::fork(MachineState &state)
+  {
+    Registers &registers = state.registers;
+    memcpy(registers.V, V, sizeof(V));
+    memcpy(registers.stack, stack, sizeof(stack));
+    registers.I = I;
+    registers.pc = pc;
+    registers.sp = sp;
+    registers.delay_timer = delay_timer;
+    registers.sound_timer = sound_timer;
+    registers.planes = planes;
+    registers.random_state = random.state();
+    memcpy(registers.keyboard, keyboard, sizeof(keyboard));
+    memcpy(registers.flags, flags, sizeof(flags));
+    memcpy(registers.audio_pattern, audio_pattern, sizeof(audio_pattern));
+    registers.pitch = pitch;
+    registers.pattern_loaded = pattern_loaded ? 1 : 0;
+    state.platform = platform;
+    state.terminated = terminate == utils::Flag::Raised;
+
+    // the pages written since the last fork or load become new ones, the rest are handed on as they are
+    const std::size_t pages = addressSpace() / PAGE_SIZE;
+    state.extra_pages.resize(pages - std::min(pages, CHIP8_PAGE_COUNT));
+    for (std::size_t page = 0; page < pages; ++page)
     {
-      file.seekg(0, std::ios::end);
-      const size_t file_size = file.tellg();
-      file.seekg(0, std::ios::beg);
-      char *buffer = new char[file_size];
-      file.read(buffer, file_size);
-      for (size_t i = 0; i < file_size; ++i)
+      if (!mirrored_pages[page] || (dirty_pages >> page & 1))
       {
-        // load game into memory starting at 0x200 (512)
-        memory[i + 512] = static_cast<std::uint8_t>(buffer[i]);
+        auto copy = std::make_shared<MemoryPage>();
+        memcpy(copy->bytes, memory + page * PAGE_SIZE, PAGE_SIZE);
+        mirrored_pages[page] = std::move(copy);
       }
-      delete[] buffer;
-      messenger_.printMessage("Game loaded successfully!");
-      file.close();
-      return utils::Result::Success;
+      state.page(page) = mirrored_pages[page];
     }
-    else
+    dirty_pages = 0;
+    if (!mirrored_screen || screen_dirty)
     {
-      messenger_.printMessage("Failed to load game!");
-      file.close();
-      return utils::Result::Failure;
+      mirrored_screen = std::make_shared<const FrameBuffer>(graphics_buffer);
+      screen_dirty = false;
     }
+    state.screen = mirrored_screen;
   }
 
-  std::optional<std::uint8_t> Chip8::readGraphicsBuffer(const int x) const
+  void Chip8::loadState(const MachineState &state)
   {
-    if (x < 0 || x > 2047)
+    if (state.platform != platform)
+    {
+      setPlatform(state.platform);
+    }
+    const std::size_t pages = addressSpace() / PAGE_SIZE;
+    for (std::size_t page = 0; page < pages; ++page)
+    {
+      const auto &shared = state.page(page);
+      if (mirrored_pages[page] == shared && !(dirty_pages >> page & 1))
+      {
+        continue;
+      }
+      restoreMemory(page * PAGE_SIZE, shared->bytes, PAGE_SIZE);
+      mirrored_pages[page] = shared;
+    }
+    dirty_pages = 0;
+    if (mirrored_screen != state.screen || screen_dirty)
     {
-      return std::nullopt;
+      graphics_buffer = *state.screen;
+      mirrored_screen = state.screen;
+      screen_dirty = false;
     }
-    return graphics_buffer[x];
+
+    const Registers &registers = state.registers;
+    memcpy(V, registers.V, sizeof(V));
+    memcpy(stack, registers.stack, sizeof(stack));
+    I = registers.I;
+    pc = registers.pc;
+    sp = registers.sp;
+    delay_timer = registers.delay_timer;
+    sound_timer = registers.sound_timer;
+    planes = registers.planes;
+    random.restore(registers.random_state);
+    memcpy(keyboard, registers.keyboard, sizeof(keyboard));
+    memcpy(flags, registers.flags, sizeof(flags));
+    memcpy(audio_pattern, registers.audio_pattern, sizeof(audio_pattern));
+    pitch = registers.pitch;
+    pattern_loaded = registers.pattern_loaded != 0;
+    terminate = state.terminated ? utils::Flag::Raised : utils::Flag::Lowered;
+    idle_length = 0;
+    waiting_for_key = false;
+    draw = utils::Flag::Raised;
+  }
+
+  void Chip8::restoreMemory(const std::size_t base, const std::uint8_t *bytes, const std::size_t size)
+  {
+    // compare a word at a time and only go through writeMemory where something changed,
+    // so rewinding a few frames does not throw away every decoded or compiled instruction
+    for (std::size_t offset = 0; offset < size; offset += sizeof(std::uint64_t))
+    {
+      std::uint64_t current;
+      std::uint64_t saved;
+      memcpy(&current, memory + base + offset, sizeof(current));
+      memcpy(&saved, bytes + offset, sizeof(saved));
+      if (current == saved)
+      {
+        continue;
+      }
+      for (std::size_t at = offset; at < offset + sizeof(std::uint64_t); ++at)
+      {
+        if (memory[base + at] != bytes[at])
+        {
+          writeMemory(base + at, bytes[at]);
+        }
+      }
+    }
+  }
+
+  const FrameBuffer &Chip8::getFrameBuffer() const
+  {
+    return graphics_buffer;
+  }
+
+  std::uint64_t Chip8::hashGraphicsBuffer() const
+  {
+    return graphics_buffer.hash();
+  }
+
+  const Profiler *Chip8::profiler() const
+  {
+#if CHIP8_PROFILE
+    return &profiler_;
+#else
+    return nullptr;
+#endif
   }
 
   void Chip8::emulateCycle()
+  {
+    CHIP8_PROFILE_ONLY(const Profiler::Scope scope(profiler_, pc, memory);)
+    // a single instruction is not worth entering native code for, the jit engine steps through the cache
+    if (engine != utils::Engine::Switch)
+    {
+      stepCached();
+    }
+    else
+    {
+      stepSwitch();
+    }
+    // a single step has no budget to skip through
+    idle_length = 0;
+  }
+
+  std::size_t Chip8::run(const std::size_t cycles)
+  {
+    std::size_t executed = 0;
+    // recompiled blocks first, the engine takes the rest of the budget once the program overwrote its own code
+    if (program && platform == program->platform)
+    {
+      executed = runProgram(cycles);
+    }
+    // engine is checked once up front so the loops below stay tight
+    if (engine == utils::Engine::Jit)
+    {
+      while (executed < cycles && terminate == utils::Flag::Lowered)
+      {
+        const std::size_t native = jit->run(cycles - executed);
+        if (native > 0)
+        {
+          executed += native;
+          continue;
+        }
+        stepCached();
+        ++executed;
+        if (idle_length != 0)
+        {
+          executed += skipIdle(cycles - executed);
+        }
+      }
+    }
+    else if (engine == utils::Engine::Cached)
+    {
+      while (executed < cycles && terminate == utils::Flag::Lowered)
+      {
+        CHIP8_PROFILE_ONLY(const Profiler::Scope scope(profiler_, pc, memory);)
+        stepCached();
+        ++executed;
+        if (idle_length != 0)
+        {
+          executed += skipIdle(cycles - executed);
+        }
+      }
+    }
+    else
+    {
+      while (executed < cycles && terminate == utils::Flag::Lowered)
+      {
+        CHIP8_PROFILE_ONLY(const Profiler::Scope scope(profiler_, pc, memory);)
+        stepSwitch();
+        ++executed;
+        if (idle_length != 0)
+        {
+          executed += skipIdle(cycles - executed);
+        }
+      }
+    }
+    return executed;
+  }
+
+  void Chip8::setEngine(const utils::Engine engine)
+  {
+    this->engine = engine;
+    if (engine == utils::Engine::Jit)
+    {
+      jit = std::make_unique<Jit>(*this);
+      // native blocks cannot be timed instruction by instruction, profiling builds interpret everything
+      if (!jit->available() || PROFILING_ENABLED)
+      {
+        messenger_.log<utils::Level::Warning>(PROFILING_ENABLED ? "Profiling builds do not run native code, using the cached engine instead"
+                                                         : "Native code generation is not available, using the cached engine instead");
+        jit.reset();
+        this->engine = utils::Engine::Cached;
+      }
+    }
+    else
+    {
+      jit.reset();
+    }
+    if (this->engine == utils::Engine::Switch)
+    {
+      // release the cache, the switch engine does not need it
+      std::vector<Instruction>().swap(instruction_cache);
+    }
+    else
+    {
+      // the jit engine uses the cache for every instruction it leaves to the interpreter
+      fillInstructionCache();
+    }
+  }
+
+  utils::Engine Chip8::getEngine() const
+  {
+    return engine;
+  }
+
+  void Chip8::setProgram(const AotProgram *program)
+  {
+    // like native blocks, recompiled ones cannot be timed instruction by instruction
+    if (program && PROFILING_ENABLED)
+    {
+      messenger_.log<utils::Level::Warning>("Profiling builds do not run recompiled code, using the ", engine == utils::Engine::Switch ? "switch" : "cached", " engine instead");
+      program = nullptr;
+    }
+    this->program = program;
+    program_blocks.clear();
+    if (!program)
+    {
+      stale_code = 0;
+      return;
+    }
+    program_blocks.assign((program->platform == utils::Platform::XoChip) ? MEMORY_SIZE : CHIP8_MEMORY_SIZE, nullptr);
+    for (std::size_t i = 0; i < program->block_count; ++i)
+    {
+      program_blocks[program->blocks[i].address & (program_blocks.size() - 1)] = &program->blocks[i];
+    }
+    checkProgramCode();
+  }
+
+  std::size_t Chip8::runProgram(const std::size_t cycles)
+  {
+    std::size_t executed = 0;
+    while (executed < cycles && terminate == utils::Flag::Lowered && stale_code == 0)
+    {
+      const AotBlock *block = program_blocks[pc & address_mask];
+      // a block always runs to its end, one that does not fit the budget is stepped through by the engine instead
+      if (block && block->length <= cycles - executed)
+      {
+        block->run(*this);
+        executed += block->length;
+      }
+      else
+      {
+        if (engine == utils::Engine::Switch)
+        {
+          stepSwitch();
+        }
+        else
+        {
+          stepCached();
+        }
+        ++executed;
+      }
+      if (idle_length != 0)
+      {
+        executed += skipIdle(cycles - executed);
+      }
+    }
+    return executed;
+  }
+
+  void Chip8::checkProgramCode()
+  {
+    stale_code = 0;
+    const std::size_t size = std::min(program->rom_size, addressSpace() - PROGRAM_START);
+    for (std::size_t i = 0; i < program->rom_size; ++i)
+    {
+      if (program->code[i] && (i >= size || memory[PROGRAM_START + i] != program->rom[i]))
+      {
+        ++stale_code;
+      }
+    }
+  }
+
+  void Chip8::stepSwitch()
   {
     // opcode is 2 bytes long
-    const std::uint16_t opcode = memory[pc] << 8 | memory[pc + 1];
+    const std::uint16_t opcode = readMemory(pc) << 8 | readMemory(pc + 1);
     // all possible relevant fields from instruction
     const std::uint8_t x = (opcode & 0x0F00) >> 8;
     const std::uint8_t y = (opcode & 0x00F0) >> 4;
@@ -91,35 +496,63 @@ namespace emulator::interpreter
       {
       // CLS - clear the display
       case 0x00E0:
-        memset(graphics_buffer, 0, sizeof(graphics_buffer));
-        draw = utils::Flag::Raised;
+        clearScreen();
         break;
       case 0x00EE: // RET - return from subroutine
-        pc = stack[--sp];
+        pc = stack[--sp & 0xF];
         break;
-      default: // Sys addr - call RCA 1802 program at nnn - we ignore this
+      default: // Sys addr - call RCA 1802 program at nnn - we ignore this, unless it is a later machine's screen instruction
+        if (platform != utils::Platform::Chip8)
+        {
+          screenControl(opcode);
+        }
         break;
       }
       break;
     case 0x1000: // JP addr - jump to location nnn
+      detectIdleLoop(nnn);
       pc = nnn;
       break;
     case 0x2000: // CALL addr - call subroutine at nnn
-      stack[sp] = pc;
+      stack[sp & 0xF] = pc;
       ++sp;
       pc = nnn;
       break;
     case 0x3000: // SE Vx,byte
       // skip next instr if Vx == kk
-      pc += (V[x] == kk) ? 2 : 0;
+      if (V[x] == kk)
+      {
+        skip();
+      }
       break;
     case 0x4000: // SNE Vx,byte
       // skip next instr if Vx != kk
-      pc += (V[x] != kk) ? 2 : 0;
+      if (V[x] != kk)
+      {
+        skip();
+      }
       break;
-    case 0x5000: // SE Vx,Vy
-      // skip next instr if Vx == Vy;
-      pc += (V[x] == V[y]) ? 2 : 0;
+    case 0x5000:
+      if (platform != utils::Platform::XoChip || n == 0x0) // SE Vx,Vy
+      {
+        // skip next instr if Vx == Vy;
+        if (V[x] == V[y])
+        {
+          skip();
+        }
+      }
+      else if (n == 0x2) // SAVE Vx - Vy
+      {
+        storeRange(x, y);
+      }
+      else if (n == 0x3) // LOAD Vx - Vy
+      {
+        loadRange(x, y);
+      }
+      else
+      {
+        unknownOpcode(opcode);
+      }
       break;
     case 0x6000: // LD Vx,byte
       V[x] = kk;
@@ -151,7 +584,14 @@ namespace emulator::interpreter
         V[x] -= V[y];
         break;
       case 0x0006: // SHR Vx,Vy
-        // V[x] = V[y];         // based on original implementation
+        if (platform == utils::Platform::XoChip)
+        {
+          // XO-CHIP shifts Vy into Vx, based on original implementation
+          const std::uint8_t source = V[y];
+          V[0XF] = source & 0x1;
+          V[x] = source >> 1;
+          break;
+        }
         V[0XF] = V[x] & 0x1; // store least significant bit of V[x] in V[0XF]
         V[x] >>= 1;          // diviing by 2
         break;
@@ -160,77 +600,59 @@ namespace emulator::interpreter
         V[x] = V[y] - V[x];
         break;
       case 0x000E: // SHL Vx, {, Vy}
-        // V[x] = V[y];          // based on original implementation
+        if (platform == utils::Platform::XoChip)
+        {
+          const std::uint8_t source = V[y];
+          V[0XF] = source >> 7;
+          V[x] = source << 1;
+          break;
+        }
         V[0XF] = (V[x] >> 7); // set VF to msb of Vx
         V[x] <<= 1;           // multiply by 2
         break;
       default:
-        messenger_.printMessage("Unknown opcode: ", opcode, " exiting emulator...");
-        terminate = utils::Flag::Raised;
+        unknownOpcode(opcode);
       }
       break;
     case 0x9000: // SNE Vx, Vy
       // skip next instr if Vx != Vy
-      pc += (V[x] != V[y]) ? 2 : 0;
+      if (V[x] != V[y])
+      {
+        skip();
+      }
       break;
     case 0xA000: // LD I, addr
       I = nnn;
       break;
-    case 0xB000:       // JP V0, addr
-      pc = nnn + V[0]; // based on original implementation
+    case 0xB000: // JP V0, addr
+      // based on original implementation, SUPER-CHIP adds Vx instead (x being the top digit of the address)
+      pc = nnn + V[(platform == utils::Platform::SuperChip) ? x : 0];
       break;
     case 0xC000: // RND Vx, byte
-      V[x] = floor((rand() % 256) & kk);
+      V[x] = random.nextByte() & kk;
       break;
     case 0xD000: // DRW Vx, Vy, nibble
-    {            // only starting position are wrapped around screen - based on original implementation
-      std::uint8_t x_coord = V[x] % 64;
-      std::uint8_t y_coord = V[y] % 32;
-      V[0xF] = 0;
-      for (size_t i = 0; i < n; ++i)
-      {
-        // stop drawing if the bottom of the scrren is reached, sprite will clip
-        if (y_coord + i >= 32)
-        {
-          break;
-        }
-        std::uint8_t curr_bit_row = memory[i + I];
-        for (size_t j = 0; j < 8; ++j)
-        {
-          // if the considered bit is set, only then do xor else there is no difference
-          if (curr_bit_row & (0x80 >> j))
-          {
-            // stop drawing if right end of screen is reached, sprite will clip
-            if (x_coord + j >= 64)
-            {
-              break;
-            }
-            // if both bits are 1 then set VF since current bit on screen is erased
-            if (graphics_buffer[x_coord + j + ((y_coord + i) * 64)])
-            {
-              V[0XF] = 1;
-            }
-            graphics_buffer[x_coord + j + ((y_coord + i) * 64)] ^= 1;
-          }
-        }
-      }
-      draw = utils::Flag::Raised;
+      drawSprite(x, y, n);
       break;
-    }
     case 0xE000:
       switch (opcode & 0X00FF)
       {
       case 0X009E: // SKP Vx
-        // if key corresponding to V[x] is down, skip next instr
-        pc += (keyboard[V[x]] == 1) ? 2 : 0;
+        // if key corresponding to V[x] is down, skip next instr, only the low nibble names a key
+        if (keyboard[V[x] & 0xF] == 1)
+        {
+          skip();
+        }
         break;
       case 0X00A1: // SKNP Vx
         // if key corresponding to V[x] is up, skip next instr
-        pc += (keyboard[V[x]] == 0) ? 2 : 0;
+        if (keyboard[V[x] & 0xF] == 0)
+        {
+          skip();
+        }
         break;
       default:
-        messenger_.printMessage("Unknown opcode: ", opcode, " exiting emulator...");
-        terminate = utils::Flag::Raised;
+        unknownOpcode(opcode);
       }
       break;
     case 0xF000:
@@ -240,20 +662,7 @@ namespace emulator::interpreter
         V[x] = delay_timer;
         break;
       case 0x000A: // KD Vx, K
-        // find if any key pressed, only proceeed in execution if this is the case
-        for (size_t i = 0; i < 16; ++i)
-        {
-          if (keyboard[i])
-          {
-            V[x] = i;
-            pc += 2;
-          }
-          else
-          {
-            // repeat the same instruction if no key is pressed
-            pc -= 2;
-          }
-        }
+        waitForKey(x);
         break;
       case 0x0015: // LD DT, Vx
         delay_timer = V[x];
@@ -270,61 +679,391 @@ namespace emulator::interpreter
         I = V[x] * 5;
         break;
       case 0x0033: // LD B, Vx
-      {            // storing the BCD representation of the decimal value at Vx a in memory from [I:I+2]
-        std::uint8_t deci = V[x];
-        for (std::size_t i = 3; i-- > 0;) // prevents underflow
-        {
-          memory[I + i] = deci % 10;
-          deci /= 10;
-        }
+        storeBcd(x);
         break;
-      }
       case 0x0055: // LD [I], Vx
-      {            // store values of registers Vo to Vx (inclusive) in memory starting at I, then update I
-        for (size_t i = 0; i <= x; ++i)
+        storeRegisters(x);
+        break;
+      case 0x0065: // LD Vx, [I]
+        loadRegisters(x);
+        break;
+      default:
+        if (!extendedMisc(x, kk))
         {
-          memory[I + i] = V[i];
+          unknownOpcode(opcode);
         }
-        // I += x + 1;
+      }
+      break;
+    default:
+      unknownOpcode(opcode);
+      break;
+    }
+  }
+
+  void Chip8::writeMemory(const std::size_t address, const std::uint8_t value)
+  {
+    const std::size_t wrapped = address & address_mask;
+    if (program)
+    {
+      // keep count of the recompiled code's bytes that differ, below PROGRAM_START the offset wraps past the ROM
+      const std::size_t offset = wrapped - PROGRAM_START;
+      if (offset < program->rom_size && program->code[offset])
+      {
+        const std::uint8_t original = program->rom[offset];
+        stale_code = stale_code + (value != original ? 1 : 0) - (memory[wrapped] != original ? 1 : 0);
+      }
+    }
+    memory[wrapped] = value;
+    dirty_pages |= std::uint64_t{1} << (wrapped / PAGE_SIZE);
+    if (!instruction_cache.empty())
+    {
+      // both the instruction starting here and the one starting a byte earlier contain this byte
+      instruction_cache[wrapped].handler = &Chip8::decodeAndExecute;
+      instruction_cache[(wrapped - 1) & address_mask].handler = &Chip8::decodeAndExecute;
+    }
+    if (jit)
+    {
+      jit->invalidate(wrapped);
+    }
+  }
+
+  void Chip8::screenChanged()
+  {
+    draw = utils::Flag::Raised;
+    screen_dirty = true;
+  }
+
+  std::uint8_t Chip8::readMemory(const std::size_t address) const
+  {
+    return memory[address & address_mask];
+  }
+
+  void Chip8::skip()
+  {
+    const bool long_load = (platform == utils::Platform::XoChip) && readMemory(pc) == 0xF0 && readMemory(pc + 1) == 0x00;
+    pc += long_load ? 4 : 2;
+  }
+
+  void Chip8::detectIdleLoop(const std::uint16_t target)
+  {
+    const std::uint16_t address = static_cast<std::uint16_t>(pc - 2);
+    if (target == address)
+    {
+      idle_length = 1;
+      idle_register = 16;
+      return;
+    }
+    if (target != static_cast<std::uint16_t>(address - 4))
+    {
+      return;
+    }
+    const std::uint16_t poll = readMemory(target) << 8 | readMemory(target + 1);
+    const std::uint16_t test = readMemory(target + 2) << 8 | readMemory(target + 3);
+    const std::uint8_t x = (poll & 0x0F00) >> 8;
+    const bool equal = (test & 0xF000) == 0x3000;
+    if ((poll & 0xF0FF) != 0xF007 || (!equal && (test & 0xF000) != 0x4000) || ((test & 0x0F00) >> 8) != x)
+    {
+      return;
+    }
+    // SE leaves the loop once the timer reaches kk and SNE as long as it is not kk, neither happens before the next tick
+    if ((delay_timer == (test & 0x00FF)) == equal)
+    {
+      return;
+    }
+    idle_length = 3;
+    idle_register = x;
+  }
+
+  std::size_t Chip8::skipIdle(const std::size_t remaining)
+  {
+    // a round leaves nothing behind but Vx holding the delay timer, and pc back where it started
+    const std::size_t rounds = remaining / idle_length;
+    if (rounds > 0 && idle_register < 16)
+    {
+      V[idle_register] = delay_timer;
+    }
+    const std::size_t skipped = rounds * idle_length;
+    idle_length = 0;
+    return skipped;
+  }
+
+  void Chip8::clearScreen()
+  {
+    // CHIP-8 only ever draws on the first plane, so clearing the selected ones clears everything it can see
+    graphics_buffer.clear(planes);
+    screenChanged();
+  }
+
+  void Chip8::screenControl(const std::uint16_t opcode)
+  {
+    // scrolls move the selected planes by pixels of the current resolution
+    if ((opcode & 0xFFF0) == 0x00C0) // SCD nibble
+    {
+      graphics_buffer.scrollDown(opcode & 0x000F, planes);
+    }
+    else if ((opcode & 0xFFF0) == 0x00D0 && platform == utils::Platform::XoChip) // SCU nibble
+    {
+      graphics_buffer.scrollUp(opcode & 0x000F, planes);
+    }
+    else
+    {
+      switch (opcode)
+      {
+      case 0x00FB: // SCR
+        graphics_buffer.scrollRight(4, planes);
+        break;
+      case 0x00FC: // SCL
+        graphics_buffer.scrollLeft(4, planes);
+        break;
+      case 0x00FD: // EXIT - the program is done, not an error
+        terminate = utils::Flag::Raised;
+        return;
+      case 0x00FE: // LOW
+        graphics_buffer.setHires(false);
+        break;
+      case 0x00FF: // HIGH
+        graphics_buffer.setHires(true);
         break;
+      default: // Sys addr
+        return;
       }
-      case 0x0065: // LD Vx, [I]
-      {            // fill registers Vo to Vx (inclusive) from memory starting at I, then update I
-        for (size_t i = 0; i <= x; ++i)
+    }
+    screenChanged();
+  }
+
+  void Chip8::drawSprite(const std::uint8_t x, const std::uint8_t y, const std::uint8_t n)
+  {
+    if (platform != utils::Platform::Chip8)
+    {
+      drawExtendedSprite(x, y, n);
+      return;
+    }
+    // only starting position are wrapped around screen - based on original implementation
+    const std::uint8_t x_coord = V[x] % utils::SCREEN_WIDTH;
+    const std::uint8_t y_coord = V[y] % utils::SCREEN_HEIGHT;
+    std::uint8_t collision = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      // stop drawing if the bottom of the scrren is reached, sprite will clip
+      if (y_coord + i >= utils::SCREEN_HEIGHT)
+      {
+        break;
+      }
+      // a whole sprite row is xor-ed at once, anything past the right end of the screen clips
+      // if any set bit hits a set pixel, that pixel is erased and VF gets set
+      const std::uint8_t sprite = readMemory(i + I);
+      collision |= graphics_buffer.drawRow(x_coord, y_coord + i, sprite) ? 1 : 0;
+      CHIP8_PROFILE_ONLY(profiler_.recordSpriteRow(sprite, x_coord);)
+    }
+    V[0xF] = collision;
+    CHIP8_PROFILE_ONLY(profiler_.recordSprite(collision != 0);)
+    screenChanged();
+  }
+
+  void Chip8::drawExtendedSprite(const std::uint8_t x, const std::uint8_t y, const std::uint8_t n)
+  {
+    // both resolutions are powers of two, the starting position wraps around the screen like on CHIP-8
+    const int x_coord = V[x] & (graphics_buffer.width() - 1);
+    const int y_coord = V[y] & (graphics_buffer.height() - 1);
+    // XO-CHIP wraps the rest of the sprite around as well, SUPER-CHIP clips it
+    const bool wrap = (platform == utils::Platform::XoChip);
+    const int width = (n == 0) ? 16 : 8;
+    const int rows = (n == 0) ? 16 : n;
+    const std::size_t row_bytes = width / 8;
+    std::uint8_t collision = 0;
+    // every selected plane takes its own sprite, one after the other in memory
+    std::size_t address = I;
+    for (int plane = 0; plane < FrameBuffer::PLANES; ++plane)
+    {
+      if ((planes & (1 << plane)) == 0)
+      {
+        continue;
+      }
+      for (int i = 0; i < rows; ++i)
+      {
+        int row = y_coord + i;
+        if (row >= graphics_buffer.height())
         {
-          V[i] = memory[I + i];
+          if (!wrap)
+          {
+            break;
+          }
+          row -= graphics_buffer.height();
         }
-        // I += x + 1;
+        const std::size_t at = address + i * row_bytes;
+        const std::uint16_t sprite = (width == 16) ? (readMemory(at) << 8 | readMemory(at + 1)) : readMemory(at);
+        collision |= graphics_buffer.drawRow(plane, x_coord, row, sprite, width, wrap) ? 1 : 0;
+      }
+      address += rows * row_bytes;
+    }
+    V[0xF] = collision;
+    CHIP8_PROFILE_ONLY(profiler_.recordSprite(collision != 0);)
+    screenChanged();
+  }
+
+  void Chip8::waitForKey(const std::uint8_t x)
+  {
+    // find if any key pressed, only proceeed in execution if this is the case
+    for (size_t i = 0; i < 16; ++i)
+    {
+      if (keyboard[i])
+      {
+        V[x] = i;
+        waiting_for_key = false;
+        return;
+      }
+    }
+    // repeat the same instruction if no key is pressed, which cannot change before setKey
+    pc -= 2;
+    waiting_for_key = true;
+    idle_length = 1;
+    idle_register = 16;
+  }
+
+  void Chip8::storeBcd(const std::uint8_t x)
+  {
+    // storing the BCD representation of the decimal value at Vx a in memory from [I:I+2]
+    std::uint8_t deci = V[x];
+    for (std::size_t i = 3; i-- > 0;) // prevents underflow
+    {
+      writeMemory(I + i, deci % 10);
+      deci /= 10;
+    }
+  }
+
+  void Chip8::storeRegisters(const std::uint8_t x)
+  {
+    // store values of registers Vo to Vx (inclusive) in memory starting at I, then update I
+    for (size_t i = 0; i <= x; ++i)
+    {
+      writeMemory(I + i, V[i]);
+    }
+    // based on original implementation, which only XO-CHIP keeps
+    if (platform == utils::Platform::XoChip)
+    {
+      I += x + 1;
+    }
+  }
+
+  void Chip8::loadRegisters(const std::uint8_t x)
+  {
+    // fill registers Vo to Vx (inclusive) from memory starting at I, then update I
+    for (size_t i = 0; i <= x; ++i)
+    {
+      V[i] = readMemory(I + i);
+    }
+    if (platform == utils::Platform::XoChip)
+    {
+      I += x + 1;
+    }
+  }
+
+  void Chip8::storeRange(const std::uint8_t x, const std::uint8_t y)
+  {
+    // registers are stored in the order given, so Vy can come first
+    const int step = (x <= y) ? 1 : -1;
+    for (int i = 0, reg = x;; ++i, reg += step)
+    {
+      writeMemory(I + i, V[reg]);
+      if (reg == y)
+      {
         break;
       }
-      default:
-        messenger_.printMessage("Unknown opcode: ", opcode, " exiting emulator...");
-        terminate = utils::Flag::Raised;
+    }
+  }
+
+  void Chip8::loadRange(const std::uint8_t x, const std::uint8_t y)
+  {
+    const int step = (x <= y) ? 1 : -1;
+    for (int i = 0, reg = x;; ++i, reg += step)
+    {
+      V[reg] = readMemory(I + i);
+      if (reg == y)
+      {
+        break;
       }
-      break;
+    }
+  }
+
+  bool Chip8::extendedMisc(const std::uint8_t x, const std::uint8_t kk)
+  {
+    if (platform == utils::Platform::Chip8)
+    {
+      return false;
+    }
+    const bool xo = (platform == utils::Platform::XoChip);
+    switch (kk)
+    {
+    case 0x30: // LD HF, Vx - I points at the big digit in Vx
+      I = static_cast<std::uint16_t>(BIG_FONT_START + (V[x] & 0xF) * 10);
+      return true;
+    case 0x75: // LD R, Vx - save V0 to Vx in the flags
+      memcpy(flags, V, x + 1);
+      return true;
+    case 0x85: // LD Vx, R - load V0 to Vx from the flags
+      memcpy(V, flags, x + 1);
+      return true;
+    case 0x00: // LD I, long addr - F000 nnnn, the address is the next word
+      if (!xo || x != 0)
+      {
+        return false;
+      }
+      I = static_cast<std::uint16_t>(readMemory(pc) << 8 | readMemory(pc + 1));
+      pc += 2;
+      return true;
+    case 0x01: // PLANE n - x is the plane mask here
+      if (!xo)
+      {
+        return false;
+      }
+      planes = x & 0x3;
+      return true;
+    case 0x02: // AUDIO - load the 16 byte pattern at I
+      if (!xo || x != 0)
+      {
+        return false;
+      }
+      for (std::size_t i = 0; i < sizeof(audio_pattern); ++i)
+      {
+        audio_pattern[i] = readMemory(I + i);
+      }
+      pattern_loaded = true;
+      return true;
+    case 0x3A: // PITCH Vx
+      if (!xo)
+      {
+        return false;
+      }
+      pitch = V[x];
+      return true;
     default:
-      messenger_.printMessage("Unknown opcode: ", opcode, " exiting emulator...");
-      terminate = utils::Flag::Raised;
-      break;
+      return false;
     }
-    updateTimers();
   }
 
-  void Chip8::updateTimers()
+  void Chip8::unknownOpcode(const std::uint16_t opcode)
+  {
+    messenger_.log<utils::Level::Error>("Unknown opcode: ", opcode, " exiting emulator...");
+    terminate = utils::Flag::Raised;
+  }
+
+  void Chip8::tickTimers()
   {
     if (delay_timer > 0)
     {
       --delay_timer;
     }
+    // the buzzer sounds for every tick the sound timer is still counting down on
+    buzz = (sound_timer > 0) ? utils::Flag::Raised : utils::Flag::Lowered;
     if (sound_timer > 0)
     {
-      messenger_.printMessage("BEEP!"); // TODO: add sound
       --sound_timer;
     }
   }
 
   utils::Flag Chip8::shouldDraw()
   {
+    CHIP8_PROFILE_ONLY(profiler_.recordDrawPoll(draw == utils::Flag::Raised);)
     if (draw == utils::Flag::Raised)
     {
       // reset draw flag
@@ -339,11 +1078,29 @@ namespace emulator::interpreter
     return terminate;
   }
 
-  void Chip8::setKey(const std::uint8_t key)
+  utils::Flag Chip8::shouldBuzz() const
   {
-    // clear keyboard after each cycle
-    memset(keyboard, 0, sizeof(keyboard));
-    keyboard[key] = 1;
+    return buzz;
+  }
+
+  const std::uint8_t *Chip8::audioPattern() const
+  {
+    return pattern_loaded ? audio_pattern : nullptr;
+  }
+
+  std::uint8_t Chip8::audioPitch() const
+  {
+    return pitch;
+  }
+
+  bool Chip8::waitingForKey() const
+  {
+    return waiting_for_key && delay_timer == 0 && sound_timer == 0;
+  }
+
+  void Chip8::setKey(const std::uint8_t key, const bool pressed)
+  {
+    keyboard[key & 0xF] = pressed ? 1 : 0;
   }
 
 } // namespace emulator
\ No newline at end of file
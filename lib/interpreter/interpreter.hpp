@@ -1,21 +1,164 @@
 #pragma once
 
 #include "common.hpp"
+#include "framebuffer.hpp"
 #include "messages.hpp"
+#include "profiler.hpp"
+#include "random.hpp"
 
+#include <array>
 #include <cstdio>
 #include <optional>
 #include <cstring>
 #include <cmath>
 #include <fstream>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 namespace emulator::interpreter
 {
+  // physical memory, as much as XO-CHIP addresses; CHIP-8 and SUPER-CHIP programs only see the first CHIP8_MEMORY_SIZE bytes
+  static constexpr std::size_t MEMORY_SIZE = 0x10000;
+  static constexpr std::size_t CHIP8_MEMORY_SIZE = 4096;
+  // programs are loaded here, everything below belonged to the original interpreter
+  static constexpr std::size_t PROGRAM_START = 0x200;
+  static constexpr std::size_t MAX_ROM_SIZE = MEMORY_SIZE - PROGRAM_START;
+  // the SUPER-CHIP 8x10 digits follow the small font
+  static constexpr std::size_t BIG_FONT_START = 0x50;
+  // RND sequence a machine starts with until it is seeded, so unseeded runs are still reproducible
+  static constexpr std::uint64_t DEFAULT_SEED = 0xC8;
+  // memory is shared between forks in pages of this many bytes, a page is only copied once it is written to
+  static constexpr std::size_t PAGE_SIZE = 1024;
+  static constexpr std::size_t PAGE_COUNT = MEMORY_SIZE / PAGE_SIZE;
+  static constexpr std::size_t CHIP8_PAGE_COUNT = CHIP8_MEMORY_SIZE / PAGE_SIZE;
+
+  // To be put anywhere in the first 512 bytes of memory, where the original interpreter was located
+  // I'll go with the first 80 bytes from the bottom
+  static constexpr std::uint8_t FONTSET[80] =
+      {
+          0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+          0x20, 0x60, 0x20, 0x20, 0x70, // 1
+          0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+          0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+          0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+          0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+          0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+          0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+          0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+          0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+          0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+          0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+          0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+          0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+          0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+          0xF0, 0x80, 0xF0, 0x80, 0x80  // F
+  };
+
+  // SUPER-CHIP digits, 8x10 pixels each, right after the small font (A-F as XO-CHIP has them)
+  static constexpr std::uint8_t BIG_FONTSET[160] =
+      {
+          0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, // 0
+          0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // 1
+          0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, // 2
+          0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, // 3
+          0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, // 4
+          0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, // 5
+          0x3E, 0x7C, 0xC0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, // 6
+          0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, // 7
+          0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, // 8
+          0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C, // 9
+          0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+          0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+          0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+          0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+          0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+          0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+  };
+
+  class Jit;
+  struct AotProgram;
+  struct AotBlock;
+
+  // the whole machine state, laid out without padding so snapshots can be compared and diffed as raw bytes
+  struct Snapshot
+  {
+    FrameBuffer screen;
+    std::uint8_t memory[MEMORY_SIZE];
+    std::uint16_t stack[16];
+    std::uint16_t I;
+    std::uint16_t pc;
+    std::uint16_t sp;
+    std::uint8_t V[16];
+    std::uint8_t delay_timer;
+    std::uint8_t sound_timer;
+    std::uint64_t random_state;
+    std::uint8_t flags[16];
+    std::uint8_t audio_pattern[16];
+    std::uint8_t planes;
+    std::uint8_t pitch;
+    std::uint8_t pattern_loaded;
+    std::uint8_t reserved[5]; // keeps the size a multiple of 8 bytes, always zero
+  };
+  static_assert(sizeof(Snapshot) % sizeof(std::uint64_t) == 0, "snapshots are diffed a word at a time");
+
+  // every register of the machine, copied with the state as a single trivially copyable block
+  // the first cache line holds what nearly every instruction touches, the second what only a few do
+  struct alignas(64) Registers
+  {
+    std::uint8_t V[16];
+    std::uint16_t stack[16];
+    std::uint16_t I;
+    std::uint16_t pc;
+    std::uint8_t sp;
+    std::uint8_t delay_timer;
+    std::uint8_t sound_timer;
+    std::uint8_t planes;
+    std::uint64_t random_state;
+    std::uint8_t keyboard[16];
+    std::uint8_t flags[16];
+    std::uint8_t audio_pattern[16];
+    std::uint8_t pitch;
+    std::uint8_t pattern_loaded;
+  };
+  static_assert(std::is_trivially_copyable_v<Registers> && sizeof(Registers) == 128, "registers fill two cache lines");
+
+  struct MemoryPage
+  {
+    std::uint8_t bytes[PAGE_SIZE];
+  };
+
+  // a machine as Chip8::fork leaves it, unlike a Snapshot it shares its memory pages and screen with the machine and
+  // every other fork that has not written to them since, so it costs the registers and a pointer per page to make
+  struct MachineState
+  {
+    Registers registers;
+    utils::Platform platform;
+    // the program had ended (EXIT or an unknown opcode)
+    bool terminated;
+    std::shared_ptr<const FrameBuffer> screen;
+    // the pages of the platform's address space: the CHIP-8 and SUPER-CHIP ones are held inline, the rest of
+    // XO-CHIP's in extra_pages, which stays empty on the other platforms so their forks are a few hundred bytes
+    std::array<std::shared_ptr<const MemoryPage>, CHIP8_PAGE_COUNT> pages;
+    std::vector<std::shared_ptr<const MemoryPage>> extra_pages;
+
+    const std::shared_ptr<const MemoryPage> &page(const std::size_t index) const
+    {
+      return (index < CHIP8_PAGE_COUNT) ? pages[index] : extra_pages[index - CHIP8_PAGE_COUNT];
+    }
+
+    std::shared_ptr<const MemoryPage> &page(const std::size_t index)
+    {
+      return (index < CHIP8_PAGE_COUNT) ? pages[index] : extra_pages[index - CHIP8_PAGE_COUNT];
+    }
+  };
+
   // an emulator class for chip8
   class Chip8
   {
   public:
     Chip8(utils::Messenger &messenger);
+    ~Chip8();
 
     /**
      * @brief Load a game into memory
@@ -23,12 +166,74 @@ namespace emulator::interpreter
      */
     utils::Result loadGame(const char *filename);
 
+    /**
+     * @brief Load a game already in memory
+     * @param rom The program, copied to PROGRAM_START
+     * @param size Its size in bytes, at most addressSpace() - PROGRAM_START
+     */
+    utils::Result loadRom(const std::uint8_t *rom, const std::size_t size);
+
+    /**
+     * @brief Select the machine to emulate, which decides the instruction set, the quirks and the address space
+     * @details Call before loading a program, the cached and compiled instructions are rebuilt
+     * @param platform CHIP-8 unless set otherwise
+     */
+    void setPlatform(const utils::Platform platform);
+
+    /**
+     * @brief Get the machine currently emulated
+     */
+    utils::Platform getPlatform() const;
+
+    /**
+     * @brief Number of bytes the program can address, 4K for CHIP-8 and SUPER-CHIP and 64K for XO-CHIP
+     */
+    std::size_t addressSpace() const;
+
     /**
      * @brief Emulate a single cycle of the Chip8
-     * @details Fetch, decode and execute an instruction from memory[pc]
+     * @details Fetch, decode and execute an instruction from memory[pc]. Timers are not touched, see tickTimers
      */
     void emulateCycle();
 
+    /**
+     * @brief Decrement the delay and sound timers
+     * @details Must be called at 60Hz of emulated time, independently of how many cycles are run
+     */
+    void tickTimers();
+
+    /**
+     * @brief Emulate up to the given number of cycles back to back
+     * @details Stops early if the terminate flag is raised. Loops that can only be left by the next timer tick or a key press
+     * (a jump onto itself, polling the delay timer, waiting for a key) are counted through to the end of the budget
+     * instead of being executed round after round, with the same result
+     * @param cycles The maximum number of instructions to execute
+     * @return The number of instructions actually executed
+     */
+    std::size_t run(const std::size_t cycles);
+
+    /**
+     * @brief Select how instructions are executed
+     * @details All engines produce identical results, the cached and jit engines are faster for long runs.
+     * The jit engine falls back to the cached engine on hosts where native code cannot be generated
+     * @param engine The engine to use from the next cycle on
+     */
+    void setEngine(const utils::Engine engine);
+
+    /**
+     * @brief Get the engine currently used to execute instructions
+     */
+    utils::Engine getEngine() const;
+
+    /**
+     * @brief Run the blocks of a ROM recompiled ahead of time by chip8_recompile instead of the engine
+     * @details The engine still runs everything the blocks do not cover: indirect jumps, code the analysis did not
+     * reach, the end of a block that does not fit the budget, and all of it while the program has overwritten its own
+     * code. The blocks are only used while the machine emulates the program's platform
+     * @param program The recompiled ROM, which must outlive the machine, nullptr to go back to the engine alone
+     */
+    void setProgram(const AotProgram *program);
+
     /**
      * @brief Get the draw flag
      * @return utils::Flag
@@ -42,18 +247,107 @@ namespace emulator::interpreter
     utils::Flag shouldTerminate();
 
     /**
-     * @brief Set the key pressed by the user to the Chip8 keyboard
-     * @param key The key to set
+     * @brief Get the buzzer flag
+     * @return utils::Flag Raised if the sound timer was running during the last tickTimers
+     */
+    utils::Flag shouldBuzz() const;
+
+    /**
+     * @brief Get the XO-CHIP audio pattern the buzzer plays
+     * @return 128 one-bit samples, or nullptr while the program has not loaded one and a plain tone is wanted
      */
-    void setKey(const std::uint8_t key);
+    const std::uint8_t *audioPattern() const;
 
     /**
-     * @brief Read a byte from the graphics buffer
-     * @return the byte at the given index (optional)
+     * @brief Get the XO-CHIP playback pitch of the audio pattern, 64 plays it at 4000 samples per second
      */
-    std::optional<std::uint8_t> readGraphicsBuffer(const int x) const;
+    std::uint8_t audioPitch() const;
+
+    /**
+     * @brief Check if the program sits on LD Vx, K with no key down and both timers out
+     * @details Nothing but a key press changes the machine from here on, the caller may block until there is one
+     */
+    bool waitingForKey() const;
+
+    /**
+     * @brief Press or release a key of the Chip8 keyboard, any number of keys can be down at once
+     * @param key The key (0x0-0xF)
+     * @param pressed Whether the key is down
+     */
+    void setKey(const std::uint8_t key, const bool pressed);
+
+    /**
+     * @brief Restart the sequence RND draws from
+     * @param seed Machines with equal seeds and equal input produce equal results
+     */
+    void seed(const std::uint64_t seed);
+
+    /**
+     * @brief Copy the machine state out, the keyboard and the engine are not part of it
+     * @param snapshot The snapshot to overwrite
+     */
+    void saveState(Snapshot &snapshot) const;
+
+    /**
+     * @brief Put the machine back into a saved state
+     * @details Only the cached and compiled instructions overlapping bytes that differ are thrown away
+     * @param snapshot The state to restore
+     */
+    void loadState(const Snapshot &snapshot);
+
+    /**
+     * @brief Branch the machine off into a state that can be loaded into this or any other machine later
+     * @details Only the memory pages written and the screen if drawn on since the last fork or load are copied,
+     * the rest are shared. The keyboard is part of the state, the engine is not
+     * @param state The state to overwrite
+     */
+    void fork(MachineState &state);
+
+    /**
+     * @brief Put the machine into a forked state
+     * @details Pages the machine already holds, because it forked or loaded them and has not written to them since,
+     * are skipped, and only the cached and compiled instructions overlapping bytes that differ are thrown away
+     * @param state The state to restore, switching the platform if it differs
+     */
+    void loadState(const MachineState &state);
+
+    /**
+     * @brief Get the whole bit-packed screen at once, its width and height say which resolution it is in
+     */
+    const FrameBuffer &getFrameBuffer() const;
+
+    /**
+     * @brief Hash the current contents of the graphics buffer
+     * @return A 64-bit FNV-1a hash, equal for identical screens
+     */
+    std::uint64_t hashGraphicsBuffer() const;
+
+    /**
+     * @brief Get what the profiler recorded since the last loadGame
+     * @return The profiler, or nullptr when built without CHIP8_PROFILE
+     */
+    const Profiler *profiler() const;
 
   private:
+    friend struct Handlers;
+    friend class Jit;
+    friend struct Aot;
+
+    struct Instruction;
+    using Handler = void (*)(Chip8 &, const Instruction &);
+
+    // a pre-decoded instruction, all operand fields are extracted once when the instruction is decoded
+    struct Instruction
+    {
+      Handler handler;
+      std::uint16_t opcode;
+      std::uint16_t nnn;
+      std::uint8_t x;
+      std::uint8_t y;
+      std::uint8_t kk;
+      std::uint8_t n;
+    };
+
     /**
      * @brief Set up the Chip8 instance with default values
      * @details Set up the pc (to 0x200), memory, registers, timers, stack, keyboard and graphics buffer
@@ -61,44 +355,181 @@ namespace emulator::interpreter
     void initialise();
 
     /**
-     * @brief Decrement the delay and sound timers at 60Hz (set to 60Hz in main.cpp)
+     * @brief Fetch, decode and execute the instruction at pc using the nested switch
+     */
+    void stepSwitch();
+
+    /**
+     * @brief Execute the instruction at pc from the pre-decoded instruction cache
+     */
+    void stepCached();
+
+    /**
+     * @brief Decode the instruction at the given address into an Instruction record
+     * @param address The address of the first byte of the instruction
+     */
+    Instruction decode(const std::uint16_t address) const;
+
+    /**
+     * @brief Decode every address of memory into the instruction cache
+     */
+    void fillInstructionCache();
+
+    /**
+     * @brief Handler of invalidated cache entries, re-decodes the instruction in place and executes it
+     */
+    static void decodeAndExecute(Chip8 &chip8, const Instruction &stale);
+
+    /**
+     * @brief Write a byte to memory, invalidating any cached instruction that overlaps it
+     * @param address The address to write to (wrapped to the address space)
+     * @param value The byte to write
+     */
+    void writeMemory(const std::size_t address, const std::uint8_t value);
+
+    /**
+     * @brief Bring a stretch of memory to the given bytes, going through writeMemory only where they differ
+     */
+    void restoreMemory(const std::size_t base, const std::uint8_t *bytes, const std::size_t size);
+
+    /**
+     * @brief Note that the screen changed, to be shown and to be copied by the next fork
+     */
+    void screenChanged();
+
+    /**
+     * @brief Read a byte from memory
+     * @param address The address to read from (wrapped to the address space)
+     */
+    std::uint8_t readMemory(const std::size_t address) const;
+
+    /**
+     * @brief Move past the instruction a conditional skip jumps over
+     * @details On XO-CHIP that is two words when it is a long I load
+     */
+    void skip();
+
+    /**
+     * @brief Check if a JP addr about to be taken closes a loop that only the next timer tick can leave
+     * @details A jump onto itself, or back to a Fx07 / 3xkk or 4xkk pair on the same register that keeps looping
+     * with the current delay timer. Sets idle_length when it does
+     * @param target Where the jump goes, pc is still past the jump
+     */
+    void detectIdleLoop(const std::uint16_t target);
+
+    /**
+     * @brief Account for every whole round of the idle loop found by the last instruction that fits in the budget
+     * @param remaining Instructions left in the budget
+     * @return How many instructions the skipped rounds stand for
+     */
+    std::size_t skipIdle(const std::size_t remaining);
+
+    /**
+     * @brief run() with a recompiled program: its blocks where they fit, the engine one instruction at a time elsewhere
+     * @return The number of instructions executed, short of the budget if the program's code was overwritten
+     */
+    std::size_t runProgram(const std::size_t cycles);
+
+    /**
+     * @brief Count how many bytes of the program's code memory differs from, from scratch
      */
-    void updateTimers();
+    void checkProgramCode();
+
+    // instruction bodies shared by both engines
+
+    // CLS
+    void clearScreen();
+    // SCD, SCU, SCR, SCL, LOW, HIGH and EXIT of SUPER-CHIP and XO-CHIP, any other 0nnn is ignored like Sys addr
+    void screenControl(const std::uint16_t opcode);
+    // DRW Vx, Vy, nibble
+    void drawSprite(const std::uint8_t x, const std::uint8_t y, const std::uint8_t n);
+    // SUPER-CHIP and XO-CHIP Dxyn: 16x16 sprites for n == 0, clipping or wrapping, one sprite per selected plane
+    void drawExtendedSprite(const std::uint8_t x, const std::uint8_t y, const std::uint8_t n);
+    // LD Vx, K
+    void waitForKey(const std::uint8_t x);
+    // LD B, Vx
+    void storeBcd(const std::uint8_t x);
+    // LD [I], Vx
+    void storeRegisters(const std::uint8_t x);
+    // LD Vx, [I]
+    void loadRegisters(const std::uint8_t x);
+    // XO-CHIP SAVE Vx - Vy and LOAD Vx - Vy, either order, I is left alone
+    void storeRange(const std::uint8_t x, const std::uint8_t y);
+    void loadRange(const std::uint8_t x, const std::uint8_t y);
+    // SUPER-CHIP and XO-CHIP Fxnn instructions with no CHIP-8 counterpart, false for an unknown one
+    bool extendedMisc(const std::uint8_t x, const std::uint8_t kk);
+    // any opcode we do not know about
+    void unknownOpcode(const std::uint16_t opcode);
 
   private:
     utils::Messenger &messenger_;
-    // memory model for chip8
-    std::uint8_t memory[4096];
+
+    // the hot registers share a cache line, in the order Registers has them
 
     // registers
-    std::uint8_t V[16]; // 16 8-bit general purpose registers
-    std::uint16_t I;    // I register to store memory addresses, only lower 12 bits are used [2^12==4k]
+    alignas(64) std::uint8_t V[16]; // 16 8-bit general purpose registers
+
+    // stack - 16 levels! sp is wrapped to them on every CALL and RET, so runaway calls or returns never leave the stack
+    std::uint16_t stack[16];
+
+    std::uint16_t I; // I register to store memory addresses, only lower 12 bits are used [2^12==4k]
 
     // special registers
     std::uint16_t pc; // program counter
     std::uint8_t sp;  // stack pointer
 
+    // timers
+    // active when nonzero, in which case subtract 1 from delay_timer at 60Hz
+    // when delay_timer reaches 0, it deactivates
+    std::uint8_t delay_timer;
+
     // active when nonzero, in which case subtract 1 from sound_timer at 60Hz
     // when sound_timer reaches 0, it deactivates
     // as long as value > 0, sound chip8 buzzer until it reaches 0
     std::uint8_t sound_timer;
 
-    // timers
-    // active when nonzero, in which case subtract 1 from delay_timer at 60Hz
-    // when delay_timer reaches 0, it deactivates
-    std::uint8_t delay_timer;
+    // XO-CHIP bit-planes drawn on, cleared and scrolled (bit 0 for the first one)
+    std::uint8_t planes;
 
-    // stack - 16 levels!
-    std::uint16_t stack[16];
+    // where RND takes its bytes from
+    utils::Random random;
+
+    // the machine emulated and the addresses it reaches, memory is wrapped with address_mask
+    utils::Platform platform;
+    std::uint32_t address_mask;
+
+    // SUPER-CHIP persistent flags (RPL user flags), saved and restored by Fx75 / Fx85
+    std::uint8_t flags[16];
+
+    // XO-CHIP audio: 128 one-bit samples played while the sound timer runs, and their playback pitch
+    std::uint8_t audio_pattern[16];
+    std::uint8_t pitch;
+    bool pattern_loaded;
+
+    // set by the last instruction when it closed a loop that cannot be left before the next timer tick or key press:
+    // how many instructions one round takes and the register it loads the delay timer into (16 for none)
+    std::uint8_t idle_length;
+    std::uint8_t idle_register;
+    // LD Vx, K found no key down the last time it ran
+    bool waiting_for_key;
 
     // keyboard
-    // only one key down during any given cycle
-    // 0-15 correspond to keys 0-F
+    // 0-15 correspond to keys 0-F, 1 while the key is down
     std::uint8_t keyboard[16]; // 16 keys
 
     // graphics
-    // 32x64 (rows x cols) pixel monochrome display - treated like a 2D array of bits
-    std::uint8_t graphics_buffer[32 * 64];
+    // 32x64 (rows x cols) pixel monochrome display - one 64-bit word per row
+    FrameBuffer graphics_buffer;
+
+    // memory model for chip8
+    std::uint8_t memory[MEMORY_SIZE];
+
+    // the pages and screen last forked or loaded, which memory and graphics_buffer still match unless their page
+    // bit in dirty_pages or screen_dirty is set, so the next fork shares instead of copying them
+    std::array<std::shared_ptr<const MemoryPage>, PAGE_COUNT> mirrored_pages;
+    std::uint64_t dirty_pages;
+    std::shared_ptr<const FrameBuffer> mirrored_screen;
+    bool screen_dirty;
 
     // draw flag
     utils::Flag draw;
@@ -106,26 +537,23 @@ namespace emulator::interpreter
     // terminate flag
     utils::Flag terminate;
 
-    // To be put anywhere in the first 512 bytes of memory, where the original interpreter was located
-    // I'll go with the first 80 bytes from the bottom
-    std::uint8_t chip8_fontset[80] =
-        {
-            0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
-            0x20, 0x60, 0x20, 0x20, 0x70, // 1
-            0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
-            0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
-            0x90, 0x90, 0xF0, 0x10, 0x10, // 4
-            0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
-            0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
-            0xF0, 0x10, 0x20, 0x40, 0x40, // 7
-            0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
-            0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
-            0xF0, 0x90, 0xF0, 0x90, 0x90, // A
-            0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
-            0xF0, 0x80, 0x80, 0x80, 0xF0, // C
-            0xE0, 0x90, 0x90, 0x90, 0xE0, // D
-            0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
-            0xF0, 0x80, 0xF0, 0x80, 0x80  // F
-    };
+    // buzzer flag, set by every timer tick
+    utils::Flag buzz;
+
+    // execution engine and its instruction cache, indexed by address (empty unless the cached engine is used)
+    utils::Engine engine;
+    std::vector<Instruction> instruction_cache;
+    // native code cache of the jit engine (null unless the jit engine is used)
+    std::unique_ptr<Jit> jit;
+
+    // a ROM recompiled ahead of time (null unless set), its blocks by address over the platform's address space, and
+    // how many bytes of its code memory differs from: the blocks only run while that is 0
+    const AotProgram *program;
+    std::vector<const AotBlock *> program_blocks;
+    std::size_t stale_code;
+
+    // instruction, sprite and draw flag counters, only present in CHIP8_PROFILE builds
+    CHIP8_PROFILE_ONLY(Profiler profiler_;)
   };
+  static_assert(PAGE_COUNT <= 64, "dirty pages are tracked one bit each");
 } // namespace emulator
\ No newline at end of file
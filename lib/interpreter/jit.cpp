@@ -0,0 +1,666 @@
+#include "jit.hpp"
+#include "interpreter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+#define CHIP8_JIT_SUPPORTED 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace emulator::interpreter
+{
+  namespace
+  {
+    static constexpr std::size_t CODE_CACHE_SIZE = 256 * 1024;
+    static constexpr std::size_t MAX_BLOCK_INSTRUCTIONS = 64;
+    // blocks invalidated this many times are no longer compiled
+    static constexpr std::uint8_t MAX_INVALIDATIONS = 4;
+    // generous upper bound on the code a single block can take (longest translation is well under 64 bytes)
+    static constexpr std::size_t MAX_BLOCK_CODE = MAX_BLOCK_INSTRUCTIONS * 64 + 128;
+
+    // rdi = block entry, rsi = budget, rdx = base address of the Chip8, rcx = entry table
+    using EnterFunction = std::uint64_t (*)(const void *, std::uint64_t, std::uintptr_t, const void *);
+
+    // second opcode bytes of the two-byte jcc rel32 forms
+    static constexpr std::uint8_t JB = 0x82;
+    static constexpr std::uint8_t JE = 0x84;
+    static constexpr std::uint8_t JNE = 0x85;
+    static constexpr std::uint8_t JA = 0x87;
+
+    // minimal x86-64 encoder writing into the code cache
+    // generated code keeps the Chip8 base address in rbp, the entry table in rbx and the remaining budget in r14,
+    // every guest register is addressed as [rbp + disp32]
+    class Emitter
+    {
+    public:
+      Emitter(std::uint8_t *code, std::size_t position) : code_(code), position_(position)
+      {
+      }
+
+      std::size_t position() const
+      {
+        return position_;
+      }
+
+      void bytes(std::initializer_list<std::uint8_t> values)
+      {
+        for (const auto value : values)
+        {
+          code_[position_++] = value;
+        }
+      }
+
+      void u16(const std::uint16_t value)
+      {
+        std::memcpy(code_ + position_, &value, sizeof(value));
+        position_ += sizeof(value);
+      }
+
+      void u32(const std::uint32_t value)
+      {
+        std::memcpy(code_ + position_, &value, sizeof(value));
+        position_ += sizeof(value);
+      }
+
+      // write a rel32 at the given position so that it lands on target
+      void patchRel32(const std::size_t at, const std::size_t target)
+      {
+        const auto rel = static_cast<std::int32_t>(static_cast<std::int64_t>(target) - static_cast<std::int64_t>(at + 4));
+        std::memcpy(code_ + at, &rel, sizeof(rel));
+      }
+
+      void patchU32(const std::size_t at, const std::uint32_t value)
+      {
+        std::memcpy(code_ + at, &value, sizeof(value));
+      }
+
+      // jcc rel32 to a known position
+      void jcc(const std::uint8_t condition, const std::size_t target)
+      {
+        bytes({0x0F, condition});
+        const std::size_t at = position_;
+        u32(0);
+        patchRel32(at, target);
+      }
+
+      // jcc rel32 to a label bound later, returns the position to patch
+      std::size_t jccForward(const std::uint8_t condition)
+      {
+        bytes({0x0F, condition});
+        const std::size_t at = position_;
+        u32(0);
+        return at;
+      }
+
+      void jmp(const std::size_t target)
+      {
+        bytes({0xE9});
+        const std::size_t at = position_;
+        u32(0);
+        patchRel32(at, target);
+      }
+
+      // <opcode bytes> with ModRM [rbp + disp32] and the given reg field
+      void rbpOperand(std::initializer_list<std::uint8_t> opcode, const std::uint8_t reg, const std::int32_t disp)
+      {
+        bytes(opcode);
+        bytes({static_cast<std::uint8_t>(0x85 | (reg << 3))});
+        u32(static_cast<std::uint32_t>(disp));
+      }
+
+    private:
+      std::uint8_t *code_;
+      std::size_t position_;
+    };
+
+    // register numbers used in ModRM reg fields
+    static constexpr std::uint8_t AL = 0;
+    static constexpr std::uint8_t CL = 1;
+
+    // displacements of the guest state from the Chip8 base address
+    struct Layout
+    {
+      std::int32_t v;
+      std::int32_t i;
+      std::int32_t pc;
+      std::int32_t sp;
+      std::int32_t stack;
+      std::int32_t delay_timer;
+      std::int32_t sound_timer;
+      std::uint32_t addresses; // size of the address space, pc values at or past it always go through the interpreter
+      bool xo;                 // XO-CHIP shifts and skips
+
+      std::int32_t reg(const std::uint8_t index) const
+      {
+        return v + index;
+      }
+    };
+
+    enum class Kind
+    {
+      Straight,   // compiled, execution continues with the next instruction
+      Terminator, // compiled, ends the block
+      Unsupported // left to the interpreter
+    };
+
+    Kind classify(const std::uint16_t opcode, const utils::Platform platform)
+    {
+      switch (opcode & 0xF000)
+      {
+      case 0x0000:
+        // on later machines 0nnn covers the scroll and resolution instructions, which the interpreter handles
+        return (opcode == 0x00E0)                    ? Kind::Unsupported
+               : (opcode == 0x00EE)                  ? Kind::Terminator
+               : (platform == utils::Platform::Chip8) ? Kind::Straight
+                                                      : Kind::Unsupported;
+      case 0x5000:
+        return (platform == utils::Platform::XoChip && (opcode & 0x000F) != 0) ? Kind::Unsupported : Kind::Terminator;
+      case 0xB000:
+        return (platform == utils::Platform::SuperChip) ? Kind::Unsupported : Kind::Terminator;
+      case 0x1000:
+      case 0x2000:
+      case 0x3000:
+      case 0x4000:
+      case 0x9000:
+        return Kind::Terminator;
+      case 0x6000:
+      case 0x7000:
+      case 0xA000:
+        return Kind::Straight;
+      case 0x8000:
+        switch (opcode & 0x000F)
+        {
+        case 0x0000:
+        case 0x0001:
+        case 0x0002:
+        case 0x0003:
+        case 0x0004:
+        case 0x0005:
+        case 0x0006:
+        case 0x0007:
+        case 0x000E:
+          return Kind::Straight;
+        default:
+          return Kind::Unsupported;
+        }
+      case 0xF000:
+        switch (opcode & 0x00FF)
+        {
+        case 0x0007:
+        case 0x0015:
+        case 0x0018:
+        case 0x001E:
+        case 0x0029:
+          return Kind::Straight;
+        default: // keyboard and memory store instructions go through the interpreter
+          return Kind::Unsupported;
+        }
+      default: // RND, DRW, SKP/SKNP
+        return Kind::Unsupported;
+      }
+    }
+
+    // leave the block for a known pc, chaining straight into the next block when it is compiled
+    void emitStaticExit(Emitter &e, const Layout &layout, const std::size_t exit, const std::uint16_t target)
+    {
+      e.rbpOperand({0x66, 0xC7}, 0, layout.pc); // mov word [pc], target
+      e.u16(target);
+      if (target >= layout.addresses)
+      {
+        e.jmp(exit);
+        return;
+      }
+      e.bytes({0x48, 0x8B, 0x83}); // mov rax, [rbx + target * 8]
+      e.u32(static_cast<std::uint32_t>(target * sizeof(void *)));
+      e.bytes({0x48, 0x85, 0xC0}); // test rax, rax
+      e.jcc(JE, exit);
+      e.bytes({0xFF, 0xE0}); // jmp rax
+    }
+
+    // leave the block for the pc held in eax
+    void emitDynamicExit(Emitter &e, const Layout &layout, const std::size_t exit)
+    {
+      e.rbpOperand({0x66, 0x89}, AL, layout.pc); // mov [pc], ax
+      e.bytes({0x3D});                           // cmp eax, addresses - 1
+      e.u32(layout.addresses - 1);
+      e.jcc(JA, exit);
+      e.bytes({0x48, 0x8B, 0x04, 0xC3}); // mov rax, [rbx + rax * 8]
+      e.bytes({0x48, 0x85, 0xC0});       // test rax, rax
+      e.jcc(JE, exit);
+      e.bytes({0xFF, 0xE0}); // jmp rax
+    }
+
+    // conditional skip: the condition flags are set, skip when the jcc below is NOT taken
+    // skipped is the size of the instruction jumped over, fixed when compiling since the block covers it
+    void emitSkip(Emitter &e, const Layout &layout, const std::size_t exit, const std::uint8_t no_skip, const std::uint16_t next,
+                  const std::uint16_t skipped)
+    {
+      const std::size_t at = e.jccForward(no_skip);
+      emitStaticExit(e, layout, exit, next + skipped);
+      e.patchRel32(at, e.position());
+      emitStaticExit(e, layout, exit, next);
+    }
+
+    // translate one supported instruction, next is the address of the following instruction and skipped its size
+    void emitInstruction(Emitter &e, const Layout &layout, const std::size_t exit, const std::uint16_t opcode, const std::uint16_t next,
+                         const std::uint16_t skipped)
+    {
+      const std::uint8_t x = (opcode & 0x0F00) >> 8;
+      const std::uint8_t y = (opcode & 0x00F0) >> 4;
+      const std::uint8_t kk = opcode & 0x00FF;
+      const std::uint16_t nnn = opcode & 0x0FFF;
+      const std::int32_t vx = layout.reg(x);
+      const std::int32_t vy = layout.reg(y);
+      const std::int32_t vf = layout.reg(0xF);
+      switch (opcode & 0xF000)
+      {
+      case 0x0000:
+        if (opcode == 0x00EE) // RET
+        {
+          e.rbpOperand({0xFE}, 1, layout.sp);         // dec byte [sp]
+          e.rbpOperand({0x0F, 0xB6}, AL, layout.sp);  // movzx eax, byte [sp]
+          e.bytes({0x83, 0xE0, 0x0F});                // and eax, 0xF
+          e.bytes({0x0F, 0xB7, 0x84, 0x45});          // movzx eax, word [rbp + rax * 2 + stack]
+          e.u32(static_cast<std::uint32_t>(layout.stack));
+          emitDynamicExit(e, layout, exit);
+        }
+        // Sys addr is ignored
+        break;
+      case 0x1000: // JP addr
+        emitStaticExit(e, layout, exit, nnn);
+        break;
+      case 0x2000:                                   // CALL addr
+        e.rbpOperand({0x0F, 0xB6}, AL, layout.sp);  // movzx eax, byte [sp]
+        e.bytes({0x83, 0xE0, 0x0F});                // and eax, 0xF
+        e.bytes({0x66, 0xC7, 0x84, 0x45});          // mov word [rbp + rax * 2 + stack], next
+        e.u32(static_cast<std::uint32_t>(layout.stack));
+        e.u16(next);
+        e.rbpOperand({0xFE}, 0, layout.sp); // inc byte [sp]
+        emitStaticExit(e, layout, exit, nnn);
+        break;
+      case 0x3000:                         // SE Vx, byte
+        e.rbpOperand({0x8A}, AL, vx);      // mov al, [Vx]
+        e.bytes({0x3C, kk});               // cmp al, kk
+        emitSkip(e, layout, exit, JNE, next, skipped);
+        break;
+      case 0x4000: // SNE Vx, byte
+        e.rbpOperand({0x8A}, AL, vx);
+        e.bytes({0x3C, kk});
+        emitSkip(e, layout, exit, JE, next, skipped);
+        break;
+      case 0x5000:                    // SE Vx, Vy
+        e.rbpOperand({0x8A}, AL, vx); // mov al, [Vx]
+        e.rbpOperand({0x3A}, AL, vy); // cmp al, [Vy]
+        emitSkip(e, layout, exit, JNE, next, skipped);
+        break;
+      case 0x9000: // SNE Vx, Vy
+        e.rbpOperand({0x8A}, AL, vx);
+        e.rbpOperand({0x3A}, AL, vy);
+        emitSkip(e, layout, exit, JE, next, skipped);
+        break;
+      case 0x6000:                      // LD Vx, byte
+        e.rbpOperand({0xC6}, 0, vx);    // mov byte [Vx], kk
+        e.bytes({kk});
+        break;
+      case 0x7000:                      // ADD Vx, byte
+        e.rbpOperand({0x80}, 0, vx);    // add byte [Vx], kk
+        e.bytes({kk});
+        break;
+      case 0x8000:
+        switch (opcode & 0x000F)
+        {
+        case 0x0000:                    // LD Vx, Vy
+          e.rbpOperand({0x8A}, AL, vy); // mov al, [Vy]
+          e.rbpOperand({0x88}, AL, vx); // mov [Vx], al
+          break;
+        case 0x0001: // OR Vx, Vy
+          e.rbpOperand({0x8A}, AL, vy);
+          e.rbpOperand({0x08}, AL, vx); // or [Vx], al
+          break;
+        case 0x0002: // AND Vx, Vy
+          e.rbpOperand({0x8A}, AL, vy);
+          e.rbpOperand({0x20}, AL, vx); // and [Vx], al
+          break;
+        case 0x0003: // XOR Vx, Vy
+          e.rbpOperand({0x8A}, AL, vy);
+          e.rbpOperand({0x30}, AL, vx); // xor [Vx], al
+          break;
+        // the flag is written before the result like the interpreter does, so x or y == F behave the same
+        case 0x0004:                    // ADD Vx, Vy
+          e.rbpOperand({0x8A}, AL, vx); // mov al, [Vx]
+          e.rbpOperand({0x02}, AL, vy); // add al, [Vy]
+          e.bytes({0x0F, 0x92, 0xC1});  // setc cl
+          e.rbpOperand({0x88}, CL, vf); // mov [VF], cl
+          e.rbpOperand({0x8A}, AL, vy); // mov al, [Vy]
+          e.rbpOperand({0x00}, AL, vx); // add [Vx], al
+          break;
+        case 0x0005:                    // SUB Vx, Vy
+          e.rbpOperand({0x8A}, AL, vx); // mov al, [Vx]
+          e.rbpOperand({0x3A}, AL, vy); // cmp al, [Vy]
+          e.bytes({0x0F, 0x93, 0xC1});  // setae cl
+          e.rbpOperand({0x88}, CL, vf); // mov [VF], cl
+          e.rbpOperand({0x8A}, AL, vy); // mov al, [Vy]
+          e.rbpOperand({0x28}, AL, vx); // sub [Vx], al
+          break;
+        case 0x0006: // SHR Vx
+          if (layout.xo) // SHR Vx, Vy
+          {
+            e.rbpOperand({0x8A}, AL, vy); // mov al, [Vy]
+            e.bytes({0x88, 0xC1});        // mov cl, al
+            e.bytes({0x80, 0xE1, 0x01});  // and cl, 1
+            e.rbpOperand({0x88}, CL, vf); // mov [VF], cl
+            e.bytes({0xD0, 0xE8});        // shr al, 1
+            e.rbpOperand({0x88}, AL, vx); // mov [Vx], al
+            break;
+          }
+          e.rbpOperand({0x8A}, AL, vx); // mov al, [Vx]
+          e.bytes({0x24, 0x01});        // and al, 1
+          e.rbpOperand({0x88}, AL, vf); // mov [VF], al
+          e.rbpOperand({0xD0}, 5, vx);  // shr byte [Vx], 1
+          break;
+        case 0x0007:                    // SUBN Vx, Vy
+          e.rbpOperand({0x8A}, AL, vy); // mov al, [Vy]
+          e.rbpOperand({0x3A}, AL, vx); // cmp al, [Vx]
+          e.bytes({0x0F, 0x93, 0xC1});  // setae cl
+          e.rbpOperand({0x88}, CL, vf); // mov [VF], cl
+          e.rbpOperand({0x8A}, AL, vy); // mov al, [Vy]
+          e.rbpOperand({0x2A}, AL, vx); // sub al, [Vx]
+          e.rbpOperand({0x88}, AL, vx); // mov [Vx], al
+          break;
+        case 0x000E: // SHL Vx
+          if (layout.xo) // SHL Vx, Vy
+          {
+            e.rbpOperand({0x8A}, AL, vy);      // mov al, [Vy]
+            e.bytes({0x88, 0xC1});             // mov cl, al
+            e.bytes({0xC0, 0xE9, 0x07});       // shr cl, 7
+            e.rbpOperand({0x88}, CL, vf);      // mov [VF], cl
+            e.bytes({0xD0, 0xE0});             // shl al, 1
+            e.rbpOperand({0x88}, AL, vx);      // mov [Vx], al
+            break;
+          }
+          e.rbpOperand({0x8A}, AL, vx); // mov al, [Vx]
+          e.bytes({0xC0, 0xE8, 0x07});  // shr al, 7
+          e.rbpOperand({0x88}, AL, vf); // mov [VF], al
+          e.rbpOperand({0xD0}, 4, vx);  // shl byte [Vx], 1
+          break;
+        }
+        break;
+      case 0xA000:                              // LD I, addr
+        e.rbpOperand({0x66, 0xC7}, 0, layout.i); // mov word [I], nnn
+        e.u16(nnn);
+        break;
+      case 0xB000:                              // JP V0, addr
+        e.rbpOperand({0x0F, 0xB6}, AL, layout.reg(0)); // movzx eax, byte [V0]
+        e.bytes({0x05});                               // add eax, nnn
+        e.u32(nnn);
+        e.bytes({0x0F, 0xB7, 0xC0}); // movzx eax, ax
+        emitDynamicExit(e, layout, exit);
+        break;
+      case 0xF000:
+        switch (opcode & 0x00FF)
+        {
+        case 0x0007:                                      // LD Vx, DT
+          e.rbpOperand({0x8A}, AL, layout.delay_timer);  // mov al, [DT]
+          e.rbpOperand({0x88}, AL, vx);                  // mov [Vx], al
+          break;
+        case 0x0015:                                      // LD DT, Vx
+          e.rbpOperand({0x8A}, AL, vx);                  // mov al, [Vx]
+          e.rbpOperand({0x88}, AL, layout.delay_timer);  // mov [DT], al
+          break;
+        case 0x0018:                                      // LD ST, Vx
+          e.rbpOperand({0x8A}, AL, vx);                  // mov al, [Vx]
+          e.rbpOperand({0x88}, AL, layout.sound_timer);  // mov [ST], al
+          break;
+        case 0x001E:                                      // ADD I, Vx
+          e.rbpOperand({0x0F, 0xB6}, AL, vx);            // movzx eax, byte [Vx]
+          e.rbpOperand({0x66, 0x01}, AL, layout.i);      // add [I], ax
+          break;
+        case 0x0029:                                      // LD F, Vx
+          e.rbpOperand({0x0F, 0xB6}, AL, vx);            // movzx eax, byte [Vx]
+          e.bytes({0x8D, 0x04, 0x80});                   // lea eax, [rax + rax * 4]
+          e.rbpOperand({0x66, 0x89}, AL, layout.i);      // mov [I], ax
+          break;
+        }
+        break;
+      }
+    }
+  } // namespace
+
+  Jit::Jit(Chip8 &chip8) : chip8_(chip8)
+  {
+#ifdef CHIP8_JIT_SUPPORTED
+    // the cache is never writable and executable at once, see protect
+    void *code = mmap(nullptr, CODE_CACHE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED)
+    {
+      return;
+    }
+    code_ = static_cast<std::uint8_t *>(code);
+    code_size_ = CODE_CACHE_SIZE;
+    emitTrampolines();
+    if (!protect(0, code_size_, false))
+    {
+      munmap(code_, code_size_);
+      code_ = nullptr;
+      code_size_ = 0;
+      return;
+    }
+    entries_.assign(chip8_.addressSpace(), nullptr);
+    covered_.assign(chip8_.addressSpace(), 0);
+    invalidations_.assign(chip8_.addressSpace(), 0);
+#endif
+  }
+
+  Jit::~Jit()
+  {
+#ifdef CHIP8_JIT_SUPPORTED
+    if (code_ != nullptr)
+    {
+      munmap(code_, code_size_);
+    }
+#endif
+  }
+
+  bool Jit::available() const
+  {
+    return code_ != nullptr;
+  }
+
+  bool Jit::protect(const std::size_t begin, const std::size_t end, const bool writable)
+  {
+#ifdef CHIP8_JIT_SUPPORTED
+    static const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t first = begin / page * page;
+    const std::size_t last = std::min((end + page - 1) / page * page, code_size_);
+    return mprotect(code_ + first, last - first, writable ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC)) == 0;
+#else
+    return false;
+#endif
+  }
+
+  void Jit::emitTrampolines()
+  {
+    Emitter e(code_, 0);
+    enter_ = code_ + e.position();
+    e.bytes({0x53});             // push rbx
+    e.bytes({0x55});             // push rbp
+    e.bytes({0x41, 0x56});       // push r14
+    e.bytes({0x48, 0x89, 0xD5}); // mov rbp, rdx
+    e.bytes({0x48, 0x89, 0xCB}); // mov rbx, rcx
+    e.bytes({0x49, 0x89, 0xF6}); // mov r14, rsi
+    e.bytes({0xFF, 0xE7});       // jmp rdi
+    exit_ = code_ + e.position();
+    e.bytes({0x4C, 0x89, 0xF0}); // mov rax, r14
+    e.bytes({0x41, 0x5E});       // pop r14
+    e.bytes({0x5D});             // pop rbp
+    e.bytes({0x5B});             // pop rbx
+    e.bytes({0xC3});             // ret
+    code_start_ = code_used_ = e.position();
+  }
+
+  std::size_t Jit::run(const std::size_t budget)
+  {
+    const std::uint16_t pc = chip8_.pc;
+    if (!available() || pc >= entries_.size())
+    {
+      return 0;
+    }
+    const std::uint8_t *entry = entries_[pc];
+    if (entry == nullptr)
+    {
+      entry = compile(pc);
+    }
+    if (entry == exit_)
+    {
+      return 0;
+    }
+    EnterFunction enter;
+    std::memcpy(&enter, &enter_, sizeof(enter));
+    const std::uint64_t remaining = enter(entry, budget, reinterpret_cast<std::uintptr_t>(&chip8_), entries_.data());
+    return budget - remaining;
+  }
+
+  const std::uint8_t *Jit::compile(const std::uint16_t start)
+  {
+    if (code_size_ - code_used_ < MAX_BLOCK_CODE)
+    {
+      flush();
+    }
+    const auto base = reinterpret_cast<std::uintptr_t>(&chip8_);
+    const auto disp = [base](const void *member)
+    {
+      return static_cast<std::int32_t>(reinterpret_cast<std::uintptr_t>(member) - base);
+    };
+    const Layout layout{disp(chip8_.V), disp(&chip8_.I), disp(&chip8_.pc), disp(&chip8_.sp), disp(chip8_.stack),
+                        disp(&chip8_.delay_timer), disp(&chip8_.sound_timer), static_cast<std::uint32_t>(entries_.size()),
+                        chip8_.platform == utils::Platform::XoChip};
+    const std::size_t exit = static_cast<std::size_t>(exit_ - code_);
+    const auto opcodeAt = [this](const std::uint32_t address)
+    {
+      return static_cast<std::uint16_t>(chip8_.memory[address] << 8 | chip8_.memory[address + 1]);
+    };
+    // a jump that may close an idle loop goes through the interpreter, which skips the loop instead of spinning in it
+    const auto compilable = [&](const std::uint32_t address)
+    {
+      const std::uint16_t opcode = opcodeAt(address);
+      const std::uint16_t target = opcode & 0x0FFF;
+      const bool idle_jump = (opcode & 0xF000) == 0x1000 && (target == address || static_cast<std::uint16_t>(address - 4) == target);
+      return classify(opcode, chip8_.platform) != Kind::Unsupported && !idle_jump;
+    };
+
+    std::uint32_t address = start;
+    // one past the last byte the translation depends on, an XO-CHIP skip also reads the instruction it skips
+    std::uint32_t end = start;
+    std::uint32_t length = 0;
+    const std::uint8_t *block = exit_;
+    const bool self_modifying = (invalidations_[start] >= MAX_INVALIDATIONS);
+    // only the pages this block can reach are opened for writing, and only until it is emitted
+    const std::size_t writable_from = code_used_;
+    if (!self_modifying && start < layout.addresses - 1 && compilable(start) && protect(writable_from, writable_from + MAX_BLOCK_CODE, true))
+    {
+      Emitter e(code_, code_used_);
+      const std::size_t entry = e.position();
+      // bail out before touching anything when the whole block does not fit in the remaining budget
+      e.bytes({0x49, 0x81, 0xFE}); // cmp r14, length
+      const std::size_t check_at = e.position();
+      e.u32(0);
+      e.jcc(JB, exit);
+      e.bytes({0x49, 0x81, 0xEE}); // sub r14, length
+      const std::size_t charge_at = e.position();
+      e.u32(0);
+
+      bool terminated = false;
+      while (!terminated && length < MAX_BLOCK_INSTRUCTIONS && address < layout.addresses - 1 && compilable(address))
+      {
+        const std::uint16_t opcode = opcodeAt(address);
+        std::uint16_t skipped = 2;
+        if (layout.xo && address + 3 < layout.addresses)
+        {
+          skipped = (chip8_.memory[address + 2] == 0xF0 && chip8_.memory[address + 3] == 0x00) ? 4 : 2;
+          end = std::max(end, address + 4);
+        }
+        emitInstruction(e, layout, exit, opcode, static_cast<std::uint16_t>(address + 2), skipped);
+        terminated = (classify(opcode, chip8_.platform) == Kind::Terminator);
+        address += 2;
+        ++length;
+      }
+      if (!terminated)
+      {
+        emitStaticExit(e, layout, exit, static_cast<std::uint16_t>(address));
+      }
+      e.patchU32(check_at, length);
+      e.patchU32(charge_at, length);
+      if (!protect(writable_from, writable_from + MAX_BLOCK_CODE, false))
+      {
+        // the cache cannot be made executable again, nothing compiled may run from now on
+        munmap(code_, code_size_);
+        code_ = nullptr;
+        return exit_;
+      }
+      block = code_ + entry;
+      code_used_ = e.position();
+    }
+    if (length == 0)
+    {
+      // the interpreter handles this instruction, the entry points at the exit stub so chained blocks return too
+      address = std::min<std::uint32_t>(start + 2, layout.addresses);
+      end = address;
+    }
+    end = std::max(end, address);
+    entries_[start] = block;
+    blocks_.push_back({start, end});
+    std::fill(covered_.begin() + start, covered_.begin() + end, 1);
+    return block;
+  }
+
+  void Jit::invalidate(const std::size_t address)
+  {
+    if (covered_.empty() || !covered_[address])
+    {
+      return;
+    }
+    // the dropped blocks always contain address, so only their common neighbourhood needs its coverage rebuilt
+    std::size_t low = address;
+    std::size_t high = address + 1;
+    blocks_.erase(std::remove_if(blocks_.begin(), blocks_.end(),
+                                 [&](const Block &block)
+                                 {
+                                   if (address < block.start || address >= block.end)
+                                   {
+                                     return false;
+                                   }
+                                   entries_[block.start] = nullptr;
+                                   invalidations_[block.start] += (invalidations_[block.start] < MAX_INVALIDATIONS) ? 1 : 0;
+                                   low = std::min<std::size_t>(low, block.start);
+                                   high = std::max<std::size_t>(high, block.end);
+                                   return true;
+                                 }),
+                  blocks_.end());
+    std::fill(covered_.begin() + low, covered_.begin() + high, 0);
+    for (const auto &block : blocks_)
+    {
+      if (block.start < high && block.end > low)
+      {
+        std::fill(covered_.begin() + std::max<std::size_t>(low, block.start), covered_.begin() + std::min<std::size_t>(high, block.end), 1);
+      }
+    }
+  }
+
+  void Jit::flush()
+  {
+    if (!available())
+    {
+      return;
+    }
+    code_used_ = code_start_;
+    std::fill(entries_.begin(), entries_.end(), nullptr);
+    std::fill(covered_.begin(), covered_.end(), 0);
+    std::fill(invalidations_.begin(), invalidations_.end(), 0);
+    blocks_.clear();
+  }
+
+} // namespace emulator::interpreter
\ No newline at end of file
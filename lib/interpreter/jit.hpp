@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emulator::interpreter
+{
+  class Chip8;
+
+  // translates basic blocks of Chip8 code into native x86-64 code
+  // blocks run straight from a code cache keyed by pc and chain into each other without returning,
+  // instructions the compiler does not handle (drawing, keyboard, memory stores...) are left to the interpreter
+  class Jit
+  {
+  public:
+    explicit Jit(Chip8 &chip8);
+    ~Jit();
+
+    Jit(const Jit &) = delete;
+    Jit &operator=(const Jit &) = delete;
+
+    /**
+     * @brief Check if native code can be generated and run on this host
+     */
+    bool available() const;
+
+    /**
+     * @brief Run compiled blocks starting at the current pc, compiling the first one if needed
+     * @details Returns as soon as a block is not compiled, needs the interpreter or does not fit the budget
+     * @param budget The maximum number of instructions to execute
+     * @return The number of instructions executed, 0 if the interpreter has to handle the instruction at pc
+     */
+    std::size_t run(const std::size_t budget);
+
+    /**
+     * @brief Drop every block containing the given byte of memory
+     * @param address The address that was written to
+     */
+    void invalidate(const std::size_t address);
+
+    /**
+     * @brief Drop every compiled block
+     */
+    void flush();
+
+  private:
+    struct Block
+    {
+      std::uint32_t start;
+      std::uint32_t end; // one past the last byte of the block, up to the size of the address space
+    };
+
+    /**
+     * @brief Translate the block starting at the given address and register it in the entry table
+     * @return The block entry point, or the exit stub if the first instruction needs the interpreter
+     */
+    const std::uint8_t *compile(const std::uint16_t address);
+
+    /**
+     * @brief Emit the shared enter/exit trampolines at the start of the code cache
+     */
+    void emitTrampolines();
+
+    /**
+     * @brief Switch the pages of the code cache holding the given byte range between writable and executable
+     * @return false if the protection could not be changed
+     */
+    bool protect(const std::size_t begin, const std::size_t end, const bool writable);
+
+  private:
+    Chip8 &chip8_;
+    std::uint8_t *code_ = nullptr;
+    std::size_t code_size_ = 0;
+    std::size_t code_used_ = 0;
+    // start of the code emitted after the trampolines, flushing rewinds to here
+    std::size_t code_start_ = 0;
+    const std::uint8_t *enter_ = nullptr;
+    const std::uint8_t *exit_ = nullptr;
+    // block entry points by pc, null when not compiled yet
+    std::vector<const std::uint8_t *> entries_;
+    std::vector<Block> blocks_;
+    // one flag per byte of memory, set when the byte belongs to a compiled block
+    std::vector<std::uint8_t> covered_;
+    // how often the block starting at each address was thrown away, code that keeps rewriting itself stays interpreted
+    std::vector<std::uint8_t> invalidations_;
+  };
+
+} // namespace emulator::interpreter
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace emulator::interpreter
+{
+  namespace
+  {
+    constexpr const char *CLASS_NAMES[Profiler::OPCODE_CLASSES] = {
+        "SYS addr", "CLS", "RET", "JP addr", "CALL addr", "SE Vx, byte", "SNE Vx, byte", "SE Vx, Vy", "LD Vx, byte",
+        "ADD Vx, byte", "LD Vx, Vy", "OR Vx, Vy", "AND Vx, Vy", "XOR Vx, Vy", "ADD Vx, Vy", "SUB Vx, Vy", "SHR Vx",
+        "SUBN Vx, Vy", "SHL Vx", "SNE Vx, Vy", "LD I, addr", "JP V0, addr", "RND Vx, byte", "DRW Vx, Vy, n", "SKP Vx",
+        "SKNP Vx", "LD Vx, DT", "LD Vx, K", "LD DT, Vx", "LD ST, Vx", "ADD I, Vx", "LD F, Vx", "LD B, Vx", "LD [I], Vx",
+        "LD Vx, [I]", "unknown"};
+    constexpr std::size_t UNKNOWN = Profiler::OPCODE_CLASSES - 1;
+
+    // how many times the clock is read to find out what reading it costs
+    constexpr int CALIBRATION_ROUNDS = 1000;
+
+    std::string hex(const std::uint16_t value, const int digits)
+    {
+      std::ostringstream text;
+      text << "0x" << std::hex << std::uppercase << std::setw(digits) << std::setfill('0') << value;
+      return text.str();
+    }
+
+    double share(const std::uint64_t part, const std::uint64_t whole)
+    {
+      return (whole > 0) ? 100.0 * part / whole : 0.0;
+    }
+  } // namespace
+
+  Profiler::Profiler()
+  {
+    reset();
+    // a Scope reads the clock twice, the second read is what gets charged to every instruction
+    std::int64_t cheapest = INT64_MAX;
+    for (int i = 0; i < CALIBRATION_ROUNDS; ++i)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      const auto end = std::chrono::steady_clock::now();
+      cheapest = std::min<std::int64_t>(cheapest, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+    clock_overhead_ns_ = static_cast<double>(cheapest);
+  }
+
+  void Profiler::reset()
+  {
+    classes_.fill(Counter{});
+    addresses_.fill(Counter{});
+    opcodes_.fill(0);
+    back_edges_.clear();
+    sprites_ = 0;
+    collisions_ = 0;
+    sprite_rows_ = 0;
+    pixels_ = 0;
+    draw_polls_ = 0;
+    draws_ = 0;
+  }
+
+  void Profiler::recordInstruction(const std::uint16_t pc, const std::uint16_t opcode, const std::chrono::nanoseconds elapsed,
+                                   const std::uint16_t next_pc)
+  {
+    const std::uint64_t nanoseconds = static_cast<std::uint64_t>(elapsed.count());
+    Counter &type = classes_[classify(opcode)];
+    ++type.count;
+    type.nanoseconds += nanoseconds;
+    Counter &address = addresses_[pc % ADDRESSES];
+    ++address.count;
+    address.nanoseconds += nanoseconds;
+    opcodes_[pc % ADDRESSES] = opcode;
+    // only jumps make loops, calls and returns also go backwards but do not repeat anything by themselves
+    const std::uint16_t kind = opcode & 0xF000;
+    if ((kind == 0x1000 || kind == 0xB000) && next_pc <= pc)
+    {
+      ++back_edges_[static_cast<std::uint32_t>(pc) << 16 | next_pc];
+    }
+  }
+
+  void Profiler::recordSpriteRow(const std::uint8_t sprite, const int x)
+  {
+    // bit 7 lands on column x, anything that would land past column 63 is clipped
+    const std::uint8_t visible = (x > 56) ? static_cast<std::uint8_t>(0xFF << (x - 56)) : 0xFF;
+    ++sprite_rows_;
+    pixels_ += static_cast<std::uint64_t>(__builtin_popcount(sprite & visible));
+  }
+
+  void Profiler::recordSprite(const bool collided)
+  {
+    ++sprites_;
+    collisions_ += collided ? 1 : 0;
+  }
+
+  void Profiler::recordDrawPoll(const bool fired)
+  {
+    ++draw_polls_;
+    draws_ += fired ? 1 : 0;
+  }
+
+  std::uint64_t Profiler::instructions() const
+  {
+    std::uint64_t total = 0;
+    for (const Counter &counter : classes_)
+    {
+      total += counter.count;
+    }
+    return total;
+  }
+
+  const char *Profiler::className(const std::size_t index)
+  {
+    return CLASS_NAMES[std::min(index, UNKNOWN)];
+  }
+
+  std::size_t Profiler::classify(const std::uint16_t opcode)
+  {
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+      return (opcode == 0x00E0) ? 1 : (opcode == 0x00EE) ? 2
+                                                          : 0;
+    case 0x8000:
+    {
+      const std::size_t op = opcode & 0x000F;
+      // 8xy0-8xy7 map to LD..SUBN in order, 8xyE is SHL
+      return (op <= 0x7) ? 10 + op : (op == 0xE) ? 18
+                                                 : UNKNOWN;
+    }
+    case 0x5000:
+      return 7;
+    case 0x9000:
+      return 19;
+    case 0xE000:
+      return ((opcode & 0x00FF) == 0x9E) ? 24 : ((opcode & 0x00FF) == 0xA1) ? 25
+                                                                           : UNKNOWN;
+    case 0xF000:
+      switch (opcode & 0x00FF)
+      {
+      case 0x07:
+        return 26;
+      case 0x0A:
+        return 27;
+      case 0x15:
+        return 28;
+      case 0x18:
+        return 29;
+      case 0x1E:
+        return 30;
+      case 0x29:
+        return 31;
+      case 0x33:
+        return 32;
+      case 0x55:
+        return 33;
+      case 0x65:
+        return 34;
+      default:
+        return UNKNOWN;
+      }
+    default:
+    {
+      // 1nnn-4xkk, 6xkk-7xkk and Annn-Dxyn only depend on the top nibble
+      constexpr std::size_t BY_NIBBLE[16] = {0, 3, 4, 5, 6, 7, 8, 9, 0, 19, 20, 21, 22, 23, 0, 0};
+      return BY_NIBBLE[opcode >> 12];
+    }
+    }
+  }
+
+  double Profiler::netNanoseconds(const Counter &counter) const
+  {
+    return std::max(0.0, counter.nanoseconds - clock_overhead_ns_ * counter.count);
+  }
+
+  std::vector<Profiler::Loop> Profiler::hottestLoops(const std::size_t top) const
+  {
+    std::vector<Loop> loops;
+    for (const auto &[edge, iterations] : back_edges_)
+    {
+      Loop loop{static_cast<std::uint16_t>(edge & 0xFFFF), static_cast<std::uint16_t>(edge >> 16), iterations, 0};
+      for (std::size_t address = loop.start; address <= loop.end; ++address)
+      {
+        loop.instructions += addresses_[address].count;
+      }
+      loops.push_back(loop);
+    }
+    std::sort(loops.begin(), loops.end(), [](const Loop &a, const Loop &b)
+              { return a.instructions != b.instructions ? a.instructions > b.instructions : a.start < b.start; });
+    loops.resize(std::min(loops.size(), top));
+    return loops;
+  }
+
+  std::vector<std::uint16_t> Profiler::hottestAddresses(const std::size_t top) const
+  {
+    std::vector<std::uint16_t> addresses;
+    for (std::size_t address = 0; address < ADDRESSES; ++address)
+    {
+      if (addresses_[address].count > 0)
+      {
+        addresses.push_back(static_cast<std::uint16_t>(address));
+      }
+    }
+    const auto busier = [this](const std::uint16_t a, const std::uint16_t b)
+    { return addresses_[a].count != addresses_[b].count ? addresses_[a].count > addresses_[b].count : a < b; };
+    const std::size_t kept = std::min(addresses.size(), top);
+    std::partial_sort(addresses.begin(), addresses.begin() + kept, addresses.end(), busier);
+    addresses.resize(kept);
+    return addresses;
+  }
+
+  std::string Profiler::report(const std::size_t top) const
+  {
+    const std::uint64_t total = instructions();
+    double host_ns = 0.0;
+    for (const Counter &counter : classes_)
+    {
+      host_ns += netNanoseconds(counter);
+    }
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+    text << total << " instructions, " << std::setprecision(3) << host_ns / 1e6 << " ms of host time (" << std::setprecision(1)
+         << clock_overhead_ns_
+         << " ns of clock overhead taken out of every instruction)\n";
+
+    text << "\n"
+         << std::left << std::setw(16) << "opcode class" << std::right << std::setw(14) << "count" << std::setw(9) << "share"
+         << std::setw(10) << "time" << std::setw(12) << "ns/instr" << "\n";
+    std::vector<std::size_t> order(OPCODE_CLASSES);
+    for (std::size_t i = 0; i < OPCODE_CLASSES; ++i)
+    {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [this](const std::size_t a, const std::size_t b)
+              { return netNanoseconds(classes_[a]) > netNanoseconds(classes_[b]); });
+    for (const std::size_t i : order)
+    {
+      const Counter &counter = classes_[i];
+      if (counter.count == 0)
+      {
+        continue;
+      }
+      text << std::left << std::setw(16) << CLASS_NAMES[i] << std::right << std::setw(14) << counter.count << std::setw(8)
+           << share(counter.count, total) << "%" << std::setw(9) << ((host_ns > 0.0) ? 100.0 * netNanoseconds(counter) / host_ns : 0.0)
+           << "%" << std::setw(12) << netNanoseconds(counter) / counter.count << "\n";
+    }
+
+    text << "\n"
+         << std::left << std::setw(8) << "address" << std::setw(8) << "opcode" << std::setw(16) << "class" << std::right
+         << std::setw(14) << "count" << std::setw(9) << "share" << std::setw(12) << "ns/instr" << "\n";
+    for (const std::uint16_t address : hottestAddresses(top))
+    {
+      const Counter &counter = addresses_[address];
+      text << std::left << std::setw(8) << hex(address, 3) << std::setw(8) << hex(opcodes_[address], 4) << std::setw(16)
+           << CLASS_NAMES[classify(opcodes_[address])] << std::right << std::setw(14) << counter.count << std::setw(8)
+           << share(counter.count, total) << "%" << std::setw(12) << netNanoseconds(counter) / counter.count << "\n";
+    }
+
+    // a loop's instructions include those of every loop nested in it
+    text << "\n"
+         << std::left << std::setw(16) << "loop" << std::right << std::setw(14) << "iterations" << std::setw(14) << "instructions"
+         << std::setw(9) << "share" << "\n";
+    for (const Loop &loop : hottestLoops(top))
+    {
+      text << std::left << std::setw(16) << (hex(loop.start, 3) + "-" + hex(loop.end, 3)) << std::right << std::setw(14)
+           << loop.iterations << std::setw(14) << loop.instructions << std::setw(8) << share(loop.instructions, total) << "%\n";
+    }
+
+    text << "\nsprites: " << sprites_ << " drawn, " << sprite_rows_ << " rows, " << pixels_ << " pixels, " << collisions_
+         << " collisions (" << share(collisions_, sprites_) << "%)\n";
+    text << "draw flag: raised on " << draws_ << " of " << draw_polls_ << " polls (" << share(draws_, draw_polls_) << "%)";
+    return text.str();
+  }
+
+  std::string Profiler::toJson(const std::size_t top) const
+  {
+    const std::uint64_t total = instructions();
+    std::ostringstream json;
+    json << std::setprecision(6);
+    json << "{\"instructions\": " << total << ", \"clock_overhead_ns\": " << clock_overhead_ns_ << ", \"classes\": [";
+    bool first = true;
+    for (std::size_t i = 0; i < OPCODE_CLASSES; ++i)
+    {
+      const Counter &counter = classes_[i];
+      if (counter.count == 0)
+      {
+        continue;
+      }
+      json << (first ? "" : ", ") << "{\"name\": \"" << CLASS_NAMES[i] << "\", \"count\": " << counter.count
+           << ", \"ns\": " << netNanoseconds(counter) << "}";
+      first = false;
+    }
+    json << "], \"hot_addresses\": [";
+    first = true;
+    for (const std::uint16_t address : hottestAddresses(top))
+    {
+      const Counter &counter = addresses_[address];
+      json << (first ? "" : ", ") << "{\"address\": " << address << ", \"opcode\": " << opcodes_[address] << ", \"class\": \""
+           << CLASS_NAMES[classify(opcodes_[address])] << "\", \"count\": " << counter.count << ", \"ns\": " << netNanoseconds(counter)
+           << "}";
+      first = false;
+    }
+    json << "], \"loops\": [";
+    first = true;
+    for (const Loop &loop : hottestLoops(top))
+    {
+      json << (first ? "" : ", ") << "{\"start\": " << loop.start << ", \"end\": " << loop.end << ", \"iterations\": "
+           << loop.iterations << ", \"instructions\": " << loop.instructions << "}";
+      first = false;
+    }
+    json << "], \"sprites\": {\"drawn\": " << sprites_ << ", \"rows\": " << sprite_rows_ << ", \"pixels\": " << pixels_
+         << ", \"collisions\": " << collisions_ << "}, \"draw_flag\": {\"polls\": " << draw_polls_ << ", \"raised\": " << draws_
+         << "}}";
+    return json.str();
+  }
+
+} // namespace emulator::interpreter
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// the profiler is only compiled into Chip8 when the CHIP8_PROFILE CMake option is on,
+// otherwise every hook below expands to nothing and the interpreter is exactly as fast as without it
+#ifndef CHIP8_PROFILE
+#define CHIP8_PROFILE 0
+#endif
+
+#if CHIP8_PROFILE
+#define CHIP8_PROFILE_ONLY(...) __VA_ARGS__
+#else
+#define CHIP8_PROFILE_ONLY(...)
+#endif
+
+namespace emulator::interpreter
+{
+  static constexpr bool PROFILING_ENABLED = CHIP8_PROFILE != 0;
+
+  // counts what the interpreter spends its time on: instructions per opcode class and per guest address,
+  // backward branches (to find the loops a ROM lives in), sprite drawing and the draw flag
+  class Profiler
+  {
+  public:
+    // every instruction of the Chip8 set, plus one class for opcodes that do not decode
+    static constexpr std::size_t OPCODE_CLASSES = 36;
+    static constexpr std::size_t ADDRESSES = 4096;
+
+    // times a single instruction, from before it is fetched until pc has moved on
+    class Scope
+    {
+    public:
+      Scope(Profiler &profiler, const std::uint16_t &pc, const std::uint8_t *memory)
+          : profiler_(profiler), pc_(pc), start_pc_(pc),
+            opcode_(memory[pc % ADDRESSES] << 8 | memory[(pc + 1) % ADDRESSES]),
+            start_(std::chrono::steady_clock::now())
+      {
+      }
+
+      ~Scope()
+      {
+        profiler_.recordInstruction(start_pc_, opcode_, std::chrono::steady_clock::now() - start_, pc_);
+      }
+
+      Scope(const Scope &) = delete;
+      Scope &operator=(const Scope &) = delete;
+
+    private:
+      Profiler &profiler_;
+      const std::uint16_t &pc_;
+      const std::uint16_t start_pc_;
+      const std::uint16_t opcode_;
+      const std::chrono::steady_clock::time_point start_;
+    };
+
+    Profiler();
+
+    /**
+     * @brief Forget everything recorded so far
+     */
+    void reset();
+
+    /**
+     * @brief Count one executed instruction
+     * @param pc The address the instruction was fetched from
+     * @param opcode The instruction
+     * @param elapsed Host time spent on it
+     * @param next_pc Where execution continues, a value not past pc marks a backward branch
+     */
+    void recordInstruction(const std::uint16_t pc, const std::uint16_t opcode, const std::chrono::nanoseconds elapsed,
+                           const std::uint16_t next_pc);
+
+    /**
+     * @brief Count one sprite row xor-ed onto the screen
+     * @param sprite The row, most significant bit leftmost
+     * @param x The column of the leftmost pixel, pixels past the right edge are not counted
+     */
+    void recordSpriteRow(const std::uint8_t sprite, const int x);
+
+    /**
+     * @brief Count one Dxyn that finished drawing
+     * @param collided Whether it turned any pixel off
+     */
+    void recordSprite(const bool collided);
+
+    /**
+     * @brief Count one poll of the draw flag
+     * @param fired Whether the flag was raised
+     */
+    void recordDrawPoll(const bool fired);
+
+    /**
+     * @brief Number of instructions recorded
+     */
+    std::uint64_t instructions() const;
+
+    /**
+     * @brief Human readable report, most expensive opcode classes, hot addresses and loops first
+     * @param top How many addresses and loops to list
+     */
+    std::string report(const std::size_t top = 16) const;
+
+    /**
+     * @brief The same report as a JSON object
+     */
+    std::string toJson(const std::size_t top = 16) const;
+
+    /**
+     * @brief Name of the opcode class at the given index
+     */
+    static const char *className(const std::size_t index);
+
+    /**
+     * @brief Opcode class of an instruction, decoded the same way as Chip8::stepSwitch
+     */
+    static std::size_t classify(const std::uint16_t opcode);
+
+  private:
+    struct Counter
+    {
+      std::uint64_t count = 0;
+      std::uint64_t nanoseconds = 0;
+    };
+
+    // a backward branch and everything between its target and its source
+    struct Loop
+    {
+      std::uint16_t start;
+      std::uint16_t end;
+      std::uint64_t iterations;
+      std::uint64_t instructions;
+    };
+
+    /**
+     * @brief Host time spent on a counter with the cost of reading the clock taken out
+     */
+    double netNanoseconds(const Counter &counter) const;
+
+    /**
+     * @brief The loops that executed the most instructions, biggest first
+     */
+    std::vector<Loop> hottestLoops(const std::size_t top) const;
+
+    /**
+     * @brief The addresses that executed the most instructions, busiest first
+     */
+    std::vector<std::uint16_t> hottestAddresses(const std::size_t top) const;
+
+  private:
+    std::array<Counter, OPCODE_CLASSES> classes_;
+    std::array<Counter, ADDRESSES> addresses_;
+    // last opcode seen at each address, so the report can show what a hot spot is
+    std::array<std::uint16_t, ADDRESSES> opcodes_;
+    // taken backward branches keyed by source << 16 | target
+    std::unordered_map<std::uint32_t, std::uint64_t> back_edges_;
+    std::uint64_t sprites_ = 0;
+    std::uint64_t collisions_ = 0;
+    std::uint64_t sprite_rows_ = 0;
+    std::uint64_t pixels_ = 0;
+    std::uint64_t draw_polls_ = 0;
+    std::uint64_t draws_ = 0;
+    // measured once, what an empty Scope costs
+    double clock_overhead_ns_ = 0.0;
+  };
+
+} // namespace emulator::interpreter
@@ -0,0 +1,179 @@
+#include "input_log.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace emulator::replay
+{
+    namespace
+    {
+        constexpr char LOG_MAGIC[4] = {'C', '8', 'I', 'N'};
+        // bump whenever the layout changes, older logs are then refused
+        constexpr std::uint16_t LOG_VERSION = 3;
+        // set on the key byte of a release
+        constexpr std::uint8_t KEY_RELEASED = 0x80;
+
+        // start of a log file, followed by the ROM path and then the records
+        struct LogHeader
+        {
+            char magic[4];
+            std::uint16_t version;
+            std::uint16_t path_size;
+            std::uint64_t seed;
+            std::uint64_t rom_hash;
+            std::uint32_t cpu_hz;
+            std::uint32_t frames;
+            std::uint8_t platform;
+            std::uint8_t reserved[7];
+        };
+        static_assert(sizeof(LogHeader) == 40, "log headers are read and written as raw bytes");
+
+        void writeVarint(std::string &out, std::uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        // reads one varint and moves past it, nothing if the input ends in the middle of it or it is too long
+        std::optional<std::uint64_t> readVarint(const std::uint8_t *&at, const std::uint8_t *end)
+        {
+            std::uint64_t value = 0;
+            for (int shift = 0; shift < 64 && at != end; shift += 7)
+            {
+                const std::uint8_t byte = *at++;
+                value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return value;
+                }
+            }
+            return std::nullopt;
+        }
+    } // namespace
+
+    void InputLog::recordKey(const std::uint32_t frame, const std::uint8_t key, const bool pressed)
+    {
+        keys.push_back({frame, key, pressed});
+    }
+
+    void InputLog::recordCheckpoint(const std::uint32_t frame, const std::uint64_t hash)
+    {
+        checkpoints.push_back({frame, hash});
+    }
+
+    utils::Result InputLog::save(const std::string &path) const
+    {
+        LogHeader header{};
+        std::memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+        header.version = LOG_VERSION;
+        header.path_size = static_cast<std::uint16_t>(std::min<std::size_t>(rom_path.size(), UINT16_MAX));
+        header.seed = seed;
+        header.rom_hash = rom_hash;
+        header.cpu_hz = cpu_hz;
+        header.frames = frames;
+        header.platform = static_cast<std::uint8_t>(platform);
+
+        std::string out(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.append(rom_path, 0, header.path_size);
+        // keys and checkpoints are merged into a single stream ordered by frame
+        std::uint32_t previous = 0;
+        auto key = keys.begin();
+        auto checkpoint = checkpoints.begin();
+        while (key != keys.end() || checkpoint != checkpoints.end())
+        {
+            if (checkpoint == checkpoints.end() || (key != keys.end() && key->frame <= checkpoint->frame))
+            {
+                writeVarint(out, static_cast<std::uint64_t>(key->frame - previous) << 1);
+                out.push_back(static_cast<char>(key->pressed ? key->key : key->key | KEY_RELEASED));
+                previous = key->frame;
+                ++key;
+            }
+            else
+            {
+                writeVarint(out, static_cast<std::uint64_t>(checkpoint->frame - previous) << 1 | 1);
+                out.append(reinterpret_cast<const char *>(&checkpoint->hash), sizeof(checkpoint->hash));
+                previous = checkpoint->frame;
+                ++checkpoint;
+            }
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        return file ? utils::Result::Success : utils::Result::Failure;
+    }
+
+    std::optional<InputLog> InputLog::load(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return std::nullopt;
+        }
+        const std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        LogHeader header;
+        if (bytes.size() < sizeof(header))
+        {
+            return std::nullopt;
+        }
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 || header.version != LOG_VERSION ||
+            header.platform > static_cast<std::uint8_t>(utils::Platform::XoChip) || bytes.size() < sizeof(header) + header.path_size)
+        {
+            return std::nullopt;
+        }
+
+        InputLog log;
+        log.seed = header.seed;
+        log.rom_hash = header.rom_hash;
+        log.cpu_hz = header.cpu_hz;
+        log.frames = header.frames;
+        log.platform = static_cast<utils::Platform>(header.platform);
+        const std::uint8_t *at = bytes.data() + sizeof(header);
+        const std::uint8_t *end = bytes.data() + bytes.size();
+        log.rom_path.assign(reinterpret_cast<const char *>(at), header.path_size);
+        at += header.path_size;
+
+        std::uint64_t frame = 0;
+        while (at != end)
+        {
+            const auto tag = readVarint(at, end);
+            if (!tag)
+            {
+                return std::nullopt;
+            }
+            if ((*tag >> 1) > header.frames - frame)
+            {
+                return std::nullopt;
+            }
+            frame += *tag >> 1;
+            if ((*tag & 1) == 0)
+            {
+                if (at == end)
+                {
+                    return std::nullopt;
+                }
+                log.recordKey(static_cast<std::uint32_t>(frame), *at & 0xF, (*at & KEY_RELEASED) == 0);
+                ++at;
+            }
+            else
+            {
+                std::uint64_t hash;
+                if (static_cast<std::size_t>(end - at) < sizeof(hash))
+                {
+                    return std::nullopt;
+                }
+                std::memcpy(&hash, at, sizeof(hash));
+                at += sizeof(hash);
+                log.recordCheckpoint(static_cast<std::uint32_t>(frame), hash);
+            }
+        }
+        return log;
+    }
+
+} // namespace emulator::replay
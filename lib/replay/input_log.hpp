@@ -0,0 +1,69 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace emulator::replay
+{
+    // frames between two screen hashes in a recording
+    static constexpr std::uint32_t DEFAULT_CHECKPOINT_INTERVAL = 60;
+
+    // a key pressed or released right before the given frame ran
+    struct KeyEvent
+    {
+        std::uint32_t frame;
+        std::uint8_t key;
+        bool pressed;
+    };
+
+    // the screen hash once the given number of frames had run
+    struct Checkpoint
+    {
+        std::uint32_t frame;
+        std::uint64_t hash;
+    };
+
+    // everything needed to play a session again: which ROM, how it was clocked and seeded, and what was pressed when
+    // keys are indexed by emulated frame rather than wall time, so a replay runs identically at any speed
+    // on disk it is a fixed header followed by one record per key or checkpoint, each a varint of the frame distance
+    // to the previous record (shifted left once, the low bit telling the two apart) and the key byte (the top bit set for a
+    // release) or the hash
+    struct InputLog
+    {
+        std::uint64_t seed = 0;
+        std::uint64_t rom_hash = 0; // XXH64 of the ROM, as RomImage::hash
+        std::string rom_path;
+        std::uint32_t cpu_hz = 0;
+        utils::Platform platform = utils::Platform::Chip8; // the machine the ROM ran on
+        std::uint32_t frames = 0; // length of the session
+        std::vector<KeyEvent> keys;
+        std::vector<Checkpoint> checkpoints;
+
+        /**
+         * @brief Append a key press or release, frames must not go backwards
+         */
+        void recordKey(const std::uint32_t frame, const std::uint8_t key, const bool pressed);
+
+        /**
+         * @brief Append a screen hash, frames must not go backwards
+         */
+        void recordCheckpoint(const std::uint32_t frame, const std::uint64_t hash);
+
+        /**
+         * @brief Write the log to a file
+         */
+        utils::Result save(const std::string &path) const;
+
+        /**
+         * @brief Read a log written by save
+         * @return The log, or nothing if the file is missing, truncated or not a log
+         */
+        static std::optional<InputLog> load(const std::string &path);
+    };
+
+} // namespace emulator::replay
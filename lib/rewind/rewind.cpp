@@ -0,0 +1,264 @@
+#include "rewind.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace emulator::rewind
+{
+    namespace
+    {
+        static_assert(std::is_trivially_copyable_v<interpreter::Snapshot>, "snapshots are diffed as raw bytes");
+        static_assert(sizeof(interpreter::Snapshot) % sizeof(std::uint64_t) == 0, "snapshots are diffed a word at a time");
+
+        constexpr std::size_t WORDS = sizeof(interpreter::Snapshot) / sizeof(std::uint64_t);
+        static_assert(WORDS <= UINT16_MAX, "run lengths are stored in 16 bits");
+        // a run header is a 16-bit count of unchanged words to skip followed by a 16-bit count of changed words
+        constexpr std::size_t RUN_HEADER = 2 * sizeof(std::uint16_t);
+        // worst case is every other word changing
+        constexpr std::size_t MAX_RECORD = WORDS * sizeof(std::uint64_t) + (WORDS / 2 + 1) * RUN_HEADER;
+        // most of a state is the same from one frame to the next, equal words are skipped a cache line at a time
+        constexpr std::size_t SKIP_WORDS = 64 / sizeof(std::uint64_t);
+
+        std::uint64_t loadWord(const std::uint8_t *bytes, const std::size_t word)
+        {
+            std::uint64_t value;
+            std::memcpy(&value, bytes + word * sizeof(value), sizeof(value));
+            return value;
+        }
+
+        /**
+         * @brief The first word of a state past a number of bytes of its memory, rounded down
+         */
+        std::size_t memoryWord(const std::size_t bytes)
+        {
+            return (offsetof(interpreter::Snapshot, memory) + bytes) / sizeof(std::uint64_t);
+        }
+
+        /**
+         * @brief Run-length encode the XOR of two states, skipping the words that are equal
+         * @param state The new state
+         * @param previous The state to diff against, nullptr diffs against all zeroes
+         * @param out Destination holding at least MAX_RECORD bytes
+         * @param zero_from Memory past this many bytes is zero in both states and not looked at
+         * @return The number of bytes written
+         */
+        std::size_t encode(const interpreter::Snapshot &state, const interpreter::Snapshot *previous, std::uint8_t *out,
+                           const std::size_t zero_from)
+        {
+            // the words wholly inside the zeroed memory
+            const std::size_t skip_from = memoryWord(zero_from + sizeof(std::uint64_t) - 1);
+            const std::size_t skip_to = memoryWord(interpreter::MEMORY_SIZE);
+            const auto *now = reinterpret_cast<const std::uint8_t *>(&state);
+            const auto *before = reinterpret_cast<const std::uint8_t *>(previous);
+            std::uint8_t *cursor = out;
+            std::size_t word = 0;
+            std::size_t run_end = 0;
+            while (word < WORDS)
+            {
+                const auto delta = [&](const std::size_t w)
+                { return loadWord(now, w) ^ (before ? loadWord(before, w) : 0); };
+                if (word >= skip_from && word < skip_to)
+                {
+                    word = skip_to;
+                    continue;
+                }
+                if (before && word + SKIP_WORDS <= WORDS &&
+                    std::memcmp(now + word * sizeof(std::uint64_t), before + word * sizeof(std::uint64_t), SKIP_WORDS * sizeof(std::uint64_t)) == 0)
+                {
+                    word += SKIP_WORDS;
+                    continue;
+                }
+                if (delta(word) == 0)
+                {
+                    ++word;
+                    continue;
+                }
+                std::size_t end = word + 1;
+                while (end < WORDS && delta(end) != 0)
+                {
+                    ++end;
+                }
+                const auto skip = static_cast<std::uint16_t>(word - run_end);
+                const auto length = static_cast<std::uint16_t>(end - word);
+                std::memcpy(cursor, &skip, sizeof(skip));
+                std::memcpy(cursor + sizeof(skip), &length, sizeof(length));
+                cursor += RUN_HEADER;
+                for (; word < end; ++word)
+                {
+                    const std::uint64_t value = delta(word);
+                    std::memcpy(cursor, &value, sizeof(value));
+                    cursor += sizeof(value);
+                }
+                run_end = end;
+            }
+            return cursor - out;
+        }
+
+        /**
+         * @brief XOR an encoded record into a state
+         */
+        void apply(const std::uint8_t *record, const std::size_t size, interpreter::Snapshot &state)
+        {
+            auto *bytes = reinterpret_cast<std::uint8_t *>(&state);
+            const std::uint8_t *cursor = record;
+            const std::uint8_t *end = record + size;
+            std::size_t word = 0;
+            while (cursor < end)
+            {
+                std::uint16_t skip;
+                std::uint16_t length;
+                std::memcpy(&skip, cursor, sizeof(skip));
+                std::memcpy(&length, cursor + sizeof(skip), sizeof(length));
+                cursor += RUN_HEADER;
+                word += skip;
+                for (std::size_t i = 0; i < length; ++i, ++word, cursor += sizeof(std::uint64_t))
+                {
+                    const std::uint64_t value = loadWord(bytes, word) ^ loadWord(cursor, 0);
+                    std::memcpy(bytes + word * sizeof(value), &value, sizeof(value));
+                }
+            }
+        }
+    } // namespace
+
+    RewindBuffer::RewindBuffer(const std::size_t capacity, const std::size_t max_frames, const std::size_t keyframe_interval)
+        : arena_(std::max(capacity, 2 * MAX_RECORD)), entries_(std::max<std::size_t>(max_frames, 1)),
+          keyframe_interval_(std::max<std::size_t>(keyframe_interval, 1)), delta_(MAX_RECORD), key_(MAX_RECORD)
+    {
+    }
+
+    void RewindBuffer::capture(const interpreter::Chip8 &chip8)
+    {
+        interpreter::Snapshot &next = states_[newest_ ^ 1];
+        chip8.saveState(next);
+        // the very first frame is diffed against nothing, so it always holds the full state in its delta too
+        const interpreter::Snapshot *previous = (count_ == 0) ? nullptr : &states_[newest_];
+        // saveState zeroes the memory past the platform's address space, which for CHIP-8 is most of the state,
+        // the previous state's is only known to be zero past the larger of the two spaces
+        const std::size_t space = chip8.addressSpace();
+        const std::size_t delta_size = encode(next, previous, delta_.data(), previous ? std::max(space, space_) : space);
+        const bool keyframe = (count_ == 0) || (++since_keyframe_ >= keyframe_interval_);
+        const std::size_t key_size = keyframe ? encode(next, nullptr, key_.data(), space) : 0;
+        space_ = space;
+        since_keyframe_ = keyframe ? 0 : since_keyframe_;
+
+        const std::size_t offset = reserve(delta_size + key_size);
+        std::memcpy(arena_.data() + offset, delta_.data(), delta_size);
+        std::memcpy(arena_.data() + offset + delta_size, key_.data(), key_size);
+        if (count_ == entries_.size())
+        {
+            dropOldest();
+        }
+        entries_[(oldest_ + count_) % entries_.size()] = Entry{static_cast<std::uint32_t>(offset), static_cast<std::uint32_t>(delta_size),
+                                                               static_cast<std::uint32_t>(key_size)};
+        ++count_;
+        head_ = offset + delta_size + key_size;
+        bytes_used_ += delta_size + key_size;
+        newest_ ^= 1;
+    }
+
+    bool RewindBuffer::rewind(interpreter::Chip8 &chip8, const std::size_t frames)
+    {
+        if (frames >= count_)
+        {
+            return false;
+        }
+        const std::size_t target = count_ - 1 - frames;
+        interpreter::Snapshot &state = states_[newest_];
+        // going forward from a keyframe costs one full decode plus a delta per frame, only worth it when that beats walking back
+        std::size_t keyframe = target + 1;
+        for (std::size_t i = target + 1; i-- > 0 && target - i + 1 < frames;)
+        {
+            if (entry(i).key_size != 0)
+            {
+                keyframe = i;
+                break;
+            }
+        }
+        if (keyframe <= target)
+        {
+            const Entry &key = entry(keyframe);
+            std::memset(static_cast<void *>(&state), 0, sizeof(state));
+            apply(arena_.data() + key.offset + key.delta_size, key.key_size, state);
+            for (std::size_t i = keyframe + 1; i <= target; ++i)
+            {
+                apply(arena_.data() + entry(i).offset, entry(i).delta_size, state);
+            }
+        }
+        else
+        {
+            for (std::size_t i = count_ - 1; i > target; --i)
+            {
+                apply(arena_.data() + entry(i).offset, entry(i).delta_size, state);
+            }
+        }
+        // the frames after the target are gone, the next capture continues right after it
+        for (std::size_t i = target + 1; i < count_; ++i)
+        {
+            bytes_used_ -= entry(i).delta_size + entry(i).key_size;
+        }
+        count_ = target + 1;
+        head_ = entry(target).offset + entry(target).delta_size + entry(target).key_size;
+        since_keyframe_ = 0;
+        for (std::size_t i = target + 1; i-- > 0 && entry(i).key_size == 0;)
+        {
+            ++since_keyframe_;
+        }
+        chip8.loadState(state);
+        // the frame rewound to may have been captured with another address space
+        space_ = interpreter::MEMORY_SIZE;
+        return true;
+    }
+
+    std::size_t RewindBuffer::frames() const
+    {
+        return count_;
+    }
+
+    std::size_t RewindBuffer::bytesUsed() const
+    {
+        return bytes_used_;
+    }
+
+    void RewindBuffer::clear()
+    {
+        oldest_ = 0;
+        count_ = 0;
+        head_ = 0;
+        bytes_used_ = 0;
+        since_keyframe_ = 0;
+    }
+
+    const RewindBuffer::Entry &RewindBuffer::entry(const std::size_t index) const
+    {
+        return entries_[(oldest_ + index) % entries_.size()];
+    }
+
+    void RewindBuffer::dropOldest()
+    {
+        bytes_used_ -= entry(0).delta_size + entry(0).key_size;
+        oldest_ = (oldest_ + 1) % entries_.size();
+        --count_;
+    }
+
+    std::size_t RewindBuffer::reserve(const std::size_t size)
+    {
+        // records live in write order around the arena, so whatever sits right after the write position is the oldest
+        if (head_ + size > arena_.size())
+        {
+            // not enough room before the end, drop everything still stored there and start over at the front
+            while (count_ > 0 && entry(0).offset >= head_)
+            {
+                dropOldest();
+            }
+            head_ = 0;
+        }
+        while (count_ > 0 && entry(0).offset >= head_ && entry(0).offset < head_ + size)
+        {
+            dropOldest();
+        }
+        return head_;
+    }
+
+} // namespace emulator::rewind
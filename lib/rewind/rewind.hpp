@@ -0,0 +1,94 @@
+#pragma once
+
+#include "interpreter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emulator::rewind
+{
+    static constexpr std::size_t DEFAULT_CAPACITY = 8 * 1024 * 1024;
+    static constexpr std::size_t DEFAULT_MAX_FRAMES = 60 * 60 * 60; // an hour at 60 frames per second
+    static constexpr std::size_t DEFAULT_KEYFRAME_INTERVAL = 600;
+
+    // bounded history of Chip8 states, one per captured frame
+    // every frame is stored as the XOR of its state with the previous frame's, run-length encoded so unchanged bytes cost nothing,
+    // and every keyframe_interval frames the full state is stored too; all storage is allocated up front and the oldest frames
+    // are dropped once it fills up
+    // XOR deltas work in both directions: short rewinds walk back from the newest state, long ones forward from a keyframe
+    class RewindBuffer
+    {
+    public:
+        /**
+         * @param capacity Bytes of encoded history to keep
+         * @param max_frames The most frames to keep, however small they encode
+         * @param keyframe_interval Frames between two full states
+         */
+        explicit RewindBuffer(const std::size_t capacity = DEFAULT_CAPACITY, const std::size_t max_frames = DEFAULT_MAX_FRAMES,
+                              const std::size_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+
+        /**
+         * @brief Record the current state of the interpreter as the newest frame
+         */
+        void capture(const interpreter::Chip8 &chip8);
+
+        /**
+         * @brief Put the interpreter back to an earlier frame and forget every frame after it
+         * @param chip8 The interpreter to restore
+         * @param frames How many frames back from the newest one to go, 0 restores the newest frame itself
+         * @return false if not that many frames are held, in which case nothing changes
+         */
+        bool rewind(interpreter::Chip8 &chip8, const std::size_t frames = 1);
+
+        /**
+         * @brief The number of frames held, the newest one included
+         */
+        std::size_t frames() const;
+
+        /**
+         * @brief The number of bytes taken by the encoded frames
+         */
+        std::size_t bytesUsed() const;
+
+        /**
+         * @brief Forget every frame
+         */
+        void clear();
+
+    private:
+        struct Entry
+        {
+            std::uint32_t offset;     // where the record starts in the arena
+            std::uint32_t delta_size; // bytes of XOR delta against the previous frame
+            std::uint32_t key_size;   // bytes of full state following the delta, 0 when not a keyframe
+        };
+
+        const Entry &entry(const std::size_t index) const;
+        void dropOldest();
+
+        /**
+         * @brief Make room for a record at the write position, dropping the oldest frames in the way
+         * @return The offset to write the record at
+         */
+        std::size_t reserve(const std::size_t size);
+
+    private:
+        std::vector<std::uint8_t> arena_;
+        std::vector<Entry> entries_;
+        std::size_t keyframe_interval_;
+        std::size_t oldest_ = 0; // index of the oldest entry in entries_
+        std::size_t count_ = 0;
+        std::size_t head_ = 0; // next free byte of the arena
+        std::size_t bytes_used_ = 0;
+        std::size_t since_keyframe_ = 0;
+        // state of the newest frame and scratch space for the next capture, swapped by flipping newest_
+        interpreter::Snapshot states_[2]{};
+        std::size_t newest_ = 0;
+        // address space of the machine the newest state was captured from, saveState zeroes the memory past it
+        std::size_t space_ = interpreter::MEMORY_SIZE;
+        std::vector<std::uint8_t> delta_;
+        std::vector<std::uint8_t> key_;
+    };
+
+} // namespace emulator::rewind
@@ -0,0 +1,459 @@
+#include "recompiler.hpp"
+
+#include <cstdio>
+#include <set>
+#include <vector>
+
+namespace emulator::rom
+{
+    namespace
+    {
+        // longest block written out, loops and long straight runs are split into blocks of at most this many
+        constexpr std::size_t MAX_BLOCK_INSTRUCTIONS = 64;
+
+        // what one instruction becomes
+        struct Translation
+        {
+            std::string code;       // statements, empty for an instruction that does nothing
+            bool translated = true; // false leaves the instruction to the interpreter, and ends the block before it
+            bool ends = false;      // nothing after it belongs to the block: control flow leaves or memory changed
+            bool sets_pc = false;   // the statements leave pc set, otherwise the block sets it to the next instruction
+            bool uses_i = false;
+            std::uint16_t size = 2;
+            // where control flow goes next when it is known
+            std::vector<std::uint16_t> targets;
+        };
+
+        std::string hex(const unsigned value, const int digits = 1)
+        {
+            char text[16];
+            std::snprintf(text, sizeof(text), "0x%0*X", digits, value);
+            return text;
+        }
+
+        std::string hex64(const std::uint64_t value)
+        {
+            char text[24];
+            std::snprintf(text, sizeof(text), "0x%016llX", static_cast<unsigned long long>(value));
+            return text;
+        }
+
+        std::string reg(const unsigned index)
+        {
+            return "V[" + std::to_string(index) + "]";
+        }
+
+        class Translator
+        {
+        public:
+            Translator(const RomImage &image, const Platform platform) : image_(image), platform_(platform)
+            {
+            }
+
+            // whether a whole word starting here lies inside the ROM
+            bool inRom(const std::size_t address) const
+            {
+                return address >= interpreter::PROGRAM_START && address + 1 < interpreter::PROGRAM_START + image_.bytes.size();
+            }
+
+            std::uint16_t word(const std::size_t address) const
+            {
+                const std::size_t offset = address - interpreter::PROGRAM_START;
+                return static_cast<std::uint16_t>(image_.bytes[offset] << 8 | image_.bytes[offset + 1]);
+            }
+
+            Translation translate(const std::uint16_t address) const
+            {
+                const std::uint16_t opcode = word(address);
+                const std::uint8_t x = (opcode & 0x0F00) >> 8;
+                const std::uint8_t y = (opcode & 0x00F0) >> 4;
+                const std::uint8_t n = opcode & 0x000F;
+                const std::uint8_t kk = opcode & 0x00FF;
+                const std::uint16_t nnn = opcode & 0x0FFF;
+                const std::uint16_t next = address + 2;
+                const bool xo = platform_ == Platform::XoChip;
+
+                Translation out;
+                const auto untranslated = [&out] {
+                    out.translated = false;
+                    return out;
+                };
+                // a conditional skip, ending the block on either way out
+                const auto branch = [&](const std::string &condition) {
+                    // XO-CHIP skips the long I load whole, which the interpreter decides by looking at memory
+                    std::uint16_t skipped = next + 2;
+                    if (xo)
+                    {
+                        if (!image_.analysis.isCode(next) || !inRom(next))
+                        {
+                            return untranslated();
+                        }
+                        skipped = (word(next) == 0xF000) ? next + 4 : next + 2;
+                    }
+                    out.code = "pc = (" + condition + ") ? " + hex(skipped, 3) + " : " + hex(next, 3) + ";";
+                    out.ends = true;
+                    out.sets_pc = true;
+                    out.targets = {next, skipped};
+                    return out;
+                };
+                const auto store = [&](const std::string &code) {
+                    out.code = code;
+                    out.ends = true;
+                    return out;
+                };
+
+                switch (opcode & 0xF000)
+                {
+                case 0x0000:
+                    if (opcode == 0x00E0)
+                    {
+                        out.code = "Aot::clearScreen(chip8);";
+                    }
+                    else if (opcode == 0x00EE)
+                    {
+                        out.code = "pc = Aot::stack(chip8)[--Aot::sp(chip8) & 0xF];";
+                        out.ends = true;
+                        out.sets_pc = true;
+                    }
+                    else if (platform_ != Platform::Chip8 && opcode == 0x00FD)
+                    {
+                        out.code = "pc = " + hex(next, 3) + ";\nAot::screenControl(chip8, " + hex(opcode, 4) + ");";
+                        out.ends = true;
+                        out.sets_pc = true;
+                    }
+                    else if (platform_ != Platform::Chip8)
+                    {
+                        out.code = "Aot::screenControl(chip8, " + hex(opcode, 4) + ");";
+                    }
+                    return out;
+                case 0x1000:
+                    // only a jump onto itself or back to a timer poll can start an idle loop
+                    if (nnn == address || nnn == static_cast<std::uint16_t>(address - 4))
+                    {
+                        out.code = "pc = " + hex(next, 3) + ";\nAot::detectIdleLoop(chip8, " + hex(nnn, 3) + ");\n";
+                    }
+                    out.code += "pc = " + hex(nnn, 3) + ";";
+                    out.ends = true;
+                    out.sets_pc = true;
+                    out.targets = {nnn};
+                    return out;
+                case 0x2000:
+                    out.code = "Aot::stack(chip8)[Aot::sp(chip8)++ & 0xF] = " + hex(next, 3) + ";\npc = " + hex(nnn, 3) + ";";
+                    out.ends = true;
+                    out.sets_pc = true;
+                    out.targets = {nnn, next};
+                    return out;
+                case 0x3000:
+                    return branch(reg(x) + " == " + hex(kk, 2));
+                case 0x4000:
+                    return branch(reg(x) + " != " + hex(kk, 2));
+                case 0x5000:
+                    if (!xo || n == 0x0)
+                    {
+                        // a register compared with itself is written as the constant it is, not as a self-comparison
+                        return branch((x == y) ? "true" : reg(x) + " == " + reg(y));
+                    }
+                    if (n == 0x2)
+                    {
+                        return store("Aot::storeRange(chip8, " + std::to_string(x) + ", " + std::to_string(y) + ");");
+                    }
+                    if (n == 0x3)
+                    {
+                        out.code = "Aot::loadRange(chip8, " + std::to_string(x) + ", " + std::to_string(y) + ");";
+                        return out;
+                    }
+                    return untranslated();
+                case 0x6000:
+                    out.code = reg(x) + " = " + hex(kk, 2) + ";";
+                    return out;
+                case 0x7000:
+                    out.code = reg(x) + " += " + hex(kk, 2) + ";";
+                    return out;
+                case 0x8000:
+                    // written like the switch engine has them, VF first, so x or y being F works out the same
+                    switch (n)
+                    {
+                    case 0x0:
+                        out.code = reg(x) + " = " + reg(y) + ";";
+                        return out;
+                    case 0x1:
+                        out.code = reg(x) + " |= " + reg(y) + ";";
+                        return out;
+                    case 0x2:
+                        out.code = reg(x) + " &= " + reg(y) + ";";
+                        return out;
+                    case 0x3:
+                        out.code = reg(x) + " ^= " + reg(y) + ";";
+                        return out;
+                    case 0x4:
+                        out.code = "V[15] = (" + reg(y) + " > (0xFF - " + reg(x) + ")) ? 1 : 0;\n" + reg(x) + " += " + reg(y) + ";";
+                        return out;
+                    case 0x5:
+                        out.code = "V[15] = (" + reg(y) + " > " + reg(x) + ") ? 0 : 1;\n" + reg(x) + " -= " + reg(y) + ";";
+                        return out;
+                    case 0x6:
+                        out.code = xo ? "{\n  const std::uint8_t source = " + reg(y) + ";\n  V[15] = source & 0x1;\n  " + reg(x) + " = source >> 1;\n}"
+                                      : "V[15] = " + reg(x) + " & 0x1;\n" + reg(x) + " >>= 1;";
+                        return out;
+                    case 0x7:
+                        out.code = "V[15] = (" + reg(x) + " > " + reg(y) + ") ? 0 : 1;\n" + reg(x) + " = " + reg(y) + " - " + reg(x) + ";";
+                        return out;
+                    case 0xE:
+                        out.code = xo ? "{\n  const std::uint8_t source = " + reg(y) + ";\n  V[15] = source >> 7;\n  " + reg(x) + " = source << 1;\n}"
+                                      : "V[15] = " + reg(x) + " >> 7;\n" + reg(x) + " <<= 1;";
+                        return out;
+                    default:
+                        return untranslated();
+                    }
+                case 0x9000:
+                    return branch((x == y) ? "false" : reg(x) + " != " + reg(y));
+                case 0xA000:
+                    out.code = "I = " + hex(nnn, 3) + ";";
+                    out.uses_i = true;
+                    return out;
+                case 0xB000:
+                    // the target is only known at run time, the interpreter takes it
+                    return untranslated();
+                case 0xC000:
+                    out.code = reg(x) + " = Aot::random(chip8) & " + hex(kk, 2) + ";";
+                    return out;
+                case 0xD000:
+                    out.code = "Aot::drawSprite(chip8, " + std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(n) + ");";
+                    return out;
+                case 0xE000:
+                    if (kk == 0x9E)
+                    {
+                        return branch("Aot::keyboard(chip8)[" + reg(x) + " & 0xF] == 1");
+                    }
+                    if (kk == 0xA1)
+                    {
+                        return branch("Aot::keyboard(chip8)[" + reg(x) + " & 0xF] == 0");
+                    }
+                    return untranslated();
+                default:
+                    return translateMisc(address, x, kk);
+                }
+            }
+
+        private:
+            Translation translateMisc(const std::uint16_t address, const std::uint8_t x, const std::uint8_t kk) const
+            {
+                const std::uint16_t next = address + 2;
+                const bool xo = platform_ == Platform::XoChip;
+                Translation out;
+                switch (kk)
+                {
+                case 0x07:
+                    out.code = reg(x) + " = Aot::delayTimer(chip8);";
+                    return out;
+                case 0x0A:
+                    out.code = "pc = " + hex(next, 3) + ";\nAot::waitForKey(chip8, " + std::to_string(x) + ");";
+                    out.ends = true;
+                    out.sets_pc = true;
+                    out.targets = {next};
+                    return out;
+                case 0x15:
+                    out.code = "Aot::delayTimer(chip8) = " + reg(x) + ";";
+                    return out;
+                case 0x18:
+                    out.code = "Aot::soundTimer(chip8) = " + reg(x) + ";";
+                    return out;
+                case 0x1E:
+                    out.code = "I += " + reg(x) + ";";
+                    out.uses_i = true;
+                    return out;
+                case 0x29:
+                    out.code = "I = " + reg(x) + " * 5;";
+                    out.uses_i = true;
+                    return out;
+                case 0x33:
+                    out.code = "Aot::storeBcd(chip8, " + std::to_string(x) + ");";
+                    out.ends = true;
+                    return out;
+                case 0x55:
+                    out.code = "Aot::storeRegisters(chip8, " + std::to_string(x) + ");";
+                    out.ends = true;
+                    return out;
+                case 0x65:
+                    out.code = "Aot::loadRegisters(chip8, " + std::to_string(x) + ");";
+                    return out;
+                case 0x00:
+                    // XO-CHIP long I load, the address is the word after it
+                    if (!xo || x != 0 || !inRom(next))
+                    {
+                        break;
+                    }
+                    out.code = "I = " + hex(word(next), 4) + ";";
+                    out.uses_i = true;
+                    out.size = 4;
+                    return out;
+                case 0x30:
+                case 0x75:
+                case 0x85:
+                    if (platform_ == Platform::Chip8)
+                    {
+                        break;
+                    }
+                    out.code = "Aot::extendedMisc(chip8, " + std::to_string(x) + ", " + hex(kk, 2) + ");";
+                    return out;
+                case 0x01:
+                case 0x02:
+                case 0x3A:
+                    if (!xo || (kk == 0x02 && x != 0))
+                    {
+                        break;
+                    }
+                    out.code = "Aot::extendedMisc(chip8, " + std::to_string(x) + ", " + hex(kk, 2) + ");";
+                    return out;
+                default:
+                    break;
+                }
+                Translation unknown;
+                unknown.translated = false;
+                return unknown;
+            }
+
+        private:
+            const RomImage &image_;
+            const Platform platform_;
+        };
+
+        void appendIndented(std::string &out, const std::string &code, const std::string &indent)
+        {
+            std::size_t start = 0;
+            while (start < code.size())
+            {
+                const std::size_t end = code.find('\n', start);
+                const std::size_t stop = (end == std::string::npos) ? code.size() : end;
+                out += indent + code.substr(start, stop - start) + "\n";
+                start = stop + 1;
+            }
+        }
+
+        void appendBytes(std::string &out, const std::string &name, const std::vector<std::uint8_t> &bytes)
+        {
+            out += "  constexpr std::uint8_t " + name + "[] = {";
+            for (std::size_t i = 0; i < bytes.size(); ++i)
+            {
+                out += (i % 16 == 0) ? "\n      " : " ";
+                out += hex(bytes[i], 2) + ",";
+            }
+            out += "\n  };\n\n";
+        }
+
+        const char *platformEnumerator(const Platform platform)
+        {
+            switch (platform)
+            {
+            case Platform::SuperChip:
+                return "SuperChip";
+            case Platform::XoChip:
+                return "XoChip";
+            default:
+                return "Chip8";
+            }
+        }
+    } // namespace
+
+    RecompiledRom recompile(const RomImage &image, const RecompileOptions &options)
+    {
+        const Platform platform = options.platform ? *options.platform : image.analysis.platform;
+        const Translator translator(image, platform);
+        const std::size_t end = interpreter::PROGRAM_START + image.bytes.size();
+        RecompiledRom result;
+
+        // every reachable instruction once, and the bytes they are made of
+        std::vector<Translation> translations(end);
+        std::vector<std::uint8_t> code(image.bytes.size(), 0);
+        std::set<std::uint16_t> leaders{static_cast<std::uint16_t>(interpreter::PROGRAM_START)};
+        for (std::size_t address = interpreter::PROGRAM_START; address < end; ++address)
+        {
+            if (!image.analysis.isCode(address) || !translator.inRom(address))
+            {
+                continue;
+            }
+            Translation &translation = translations[address] = translator.translate(static_cast<std::uint16_t>(address));
+            const std::size_t size = translation.translated ? translation.size : 2;
+            for (std::size_t i = 0; i < size && address + i < end; ++i)
+            {
+                code[address + i - interpreter::PROGRAM_START] = 1;
+            }
+            (translation.translated ? result.translated : result.interpreted) += 1;
+            // a block starts wherever control flow can arrive other than by falling through
+            for (const std::uint16_t target : translation.targets)
+            {
+                leaders.insert(target);
+            }
+            if (translation.ends || !translation.translated)
+            {
+                leaders.insert(static_cast<std::uint16_t>(address + size));
+            }
+        }
+
+        std::string &out = result.source;
+        out += "// generated by chip8_recompile";
+        out += options.source_name.empty() ? "" : " from " + options.source_name;
+        out += ", do not edit\n// " + std::string(platformName(platform)) + ", " + std::to_string(image.bytes.size()) + " bytes, XXH64 " + hex(static_cast<unsigned>(image.hash >> 32), 8) +
+               hex(static_cast<unsigned>(image.hash), 8).substr(2) + "\n";
+        out += "#include \"aot.hpp\"\n#include \"interpreter.hpp\"\n\n#include <cstdint>\n\nnamespace\n{\n";
+        out += "  using emulator::interpreter::Aot;\n  using emulator::interpreter::Chip8;\n\n";
+        appendBytes(out, "ROM", image.bytes.empty() ? std::vector<std::uint8_t>{0} : image.bytes);
+        appendBytes(out, "CODE", code.empty() ? std::vector<std::uint8_t>{0} : code);
+
+        std::string table;
+        for (const std::uint16_t leader : leaders)
+        {
+            if (leader >= end || !image.analysis.isCode(leader) || !translations[leader].translated)
+            {
+                continue;
+            }
+            // straight through to the first branch, store, untranslated instruction or start of another block
+            std::string body;
+            bool uses_i = false;
+            bool sets_pc = false;
+            std::size_t length = 0;
+            std::size_t address = leader;
+            while (length < MAX_BLOCK_INSTRUCTIONS && address < end && image.analysis.isCode(address) && translations[address].translated)
+            {
+                const Translation &translation = translations[address];
+                appendIndented(body, "// " + hex(address, 3) + ": " + hex(translator.word(address), 4), "    ");
+                appendIndented(body, translation.code, "    ");
+                uses_i |= translation.uses_i;
+                sets_pc = translation.sets_pc;
+                ++length;
+                address += translation.size;
+                if (translation.ends || leaders.count(static_cast<std::uint16_t>(address)) != 0)
+                {
+                    break;
+                }
+            }
+            const std::string function = "block_" + hex(leader, 3).substr(2);
+            out += "  // " + hex(leader, 3) + " - " + hex(static_cast<unsigned>(address - 1), 3) + ", " + std::to_string(length) + " instructions\n";
+            out += "  void " + function + "(Chip8 &chip8)\n  {\n";
+            out += (body.find("V[") != std::string::npos) ? "    std::uint8_t *const V = Aot::V(chip8);\n" : "";
+            out += uses_i ? "    std::uint16_t &I = Aot::I(chip8);\n" : "";
+            out += "    std::uint16_t &pc = Aot::pc(chip8);\n";
+            out += body;
+            out += sets_pc ? "" : "    pc = " + hex(static_cast<unsigned>(address), 3) + ";\n";
+            out += "  }\n\n";
+            table += "      {" + hex(leader, 3) + ", " + std::to_string(length) + ", &" + function + "},\n";
+            ++result.blocks;
+        }
+        // an array cannot be empty, a ROM without any code the blocks could take gets a placeholder nobody looks at
+        out += "  constexpr emulator::interpreter::AotBlock BLOCKS[] = {\n" + (table.empty() ? "      {0, 0, nullptr},\n" : table) + "  };\n} // namespace\n\n";
+
+        out += "extern const emulator::interpreter::AotProgram " + options.name + ";\n";
+        out += "const emulator::interpreter::AotProgram " + options.name + " = {\n";
+        out += "    \"" + options.name + "\",\n";
+        out += "    emulator::utils::Platform::" + std::string(platformEnumerator(platform)) + ",\n";
+        out += "    " + hex64(image.hash) + "ull,\n";
+        out += "    ROM,\n    " + std::to_string(image.bytes.size()) + ",\n    CODE,\n    BLOCKS,\n    " + std::to_string(result.blocks) + ",\n};\n";
+        if (options.main)
+        {
+            out += "\n#include \"aot_runner.hpp\"\n\nint main(int argc, char **argv)\n{\n";
+            out += "  return emulator::recompile::runProgram(" + options.name + ", argc, argv);\n}\n";
+        }
+        return result;
+    }
+
+} // namespace emulator::rom
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "rom_store.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+namespace emulator::rom
+{
+    struct RecompileOptions
+    {
+        // the C++ name the interpreter::AotProgram is defined under
+        std::string name = "chip8_aot_program";
+        // the platform whose rules the blocks follow, the one the analysis found when not given
+        std::optional<Platform> platform;
+        // where the ROM came from, only mentioned in the generated file's header
+        std::string source_name;
+        // also define a main() that hands the program to the runner in tools/recompile
+        bool main = false;
+    };
+
+    struct RecompiledRom
+    {
+        std::string source;
+        std::size_t blocks = 0;
+        // reachable instructions translated into blocks, and those left to the interpreter (Bnnn and unknown opcodes)
+        std::size_t translated = 0;
+        std::size_t interpreted = 0;
+    };
+
+    /**
+     * @brief Translate a ROM's code into C++, one function per basic block, for Chip8::setProgram
+     * @details The blocks are found from the analysis, which follows every branch from PROGRAM_START. Register
+     * arithmetic is written out inline, everything else calls the instruction bodies both engines use, so the
+     * result matches the interpreter instruction for instruction. A block ends at every branch, at every store,
+     * which could rewrite the code after it, and where another block starts
+     * @param image The ROM and its analysis
+     */
+    RecompiledRom recompile(const RomImage &image, const RecompileOptions &options);
+
+} // namespace emulator::rom
@@ -0,0 +1,174 @@
+#include "rom_analysis.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace emulator::rom
+{
+    namespace
+    {
+        // what one instruction does to control flow, and what it says about the ROM
+        struct Successors
+        {
+            std::uint16_t next[2];
+            int count;
+        };
+
+        // XO-CHIP extends SUPER-CHIP which extends CHIP-8, a ROM is for the newest machine it needs
+        void require(RomAnalysis &analysis, const Platform platform)
+        {
+            if (static_cast<int>(platform) > static_cast<int>(analysis.platform))
+            {
+                analysis.platform = platform;
+            }
+        }
+
+        // following is the instruction after this one, a skip over an XO-CHIP long I load jumps its address word too
+        Successors successors(const std::uint16_t address, const std::uint16_t opcode, const std::uint16_t following, RomAnalysis &analysis)
+        {
+            const std::uint16_t after = address + 2;
+            const std::uint16_t skipped = after + ((following == 0xF000) ? 4 : 2);
+            const std::uint16_t nnn = opcode & 0x0FFF;
+            const std::uint8_t low = opcode & 0x00FF;
+            switch (opcode & 0xF000)
+            {
+            case 0x0000:
+                if (opcode == 0x00EE) // RET
+                {
+                    return {{0, 0}, 0};
+                }
+                if (opcode == 0x00FD) // SUPER-CHIP EXIT
+                {
+                    require(analysis, Platform::SuperChip);
+                    return {{0, 0}, 0};
+                }
+                if ((opcode & 0xFFF0) == 0x00D0) // XO-CHIP scroll up
+                {
+                    require(analysis, Platform::XoChip);
+                }
+                else if ((opcode & 0xFFF0) == 0x00C0 || (opcode >= 0x00FB && opcode <= 0x00FF)) // SUPER-CHIP scrolls and resolution
+                {
+                    require(analysis, Platform::SuperChip);
+                }
+                return {{after, 0}, 1};
+            case 0x1000: // JP addr
+                return {{nnn, 0}, 1};
+            case 0x2000: // CALL addr, the subroutine returns to the next instruction
+                return {{nnn, after}, 2};
+            case 0x3000:
+            case 0x4000:
+            case 0x9000:
+                return {{after, skipped}, 2};
+            case 0x5000:
+                if ((opcode & 0x000F) == 0x2 || (opcode & 0x000F) == 0x3) // XO-CHIP register ranges
+                {
+                    require(analysis, Platform::XoChip);
+                }
+                return {{after, skipped}, 2};
+            case 0x8000:
+                switch (opcode & 0x000F)
+                {
+                case 0x1:
+                case 0x2:
+                case 0x3:
+                    analysis.quirks |= quirk::LOGIC;
+                    break;
+                case 0x6:
+                case 0xE:
+                    analysis.quirks |= quirk::SHIFT;
+                    break;
+                }
+                return {{after, 0}, 1};
+            case 0xB000: // JP V0, addr
+                analysis.quirks |= quirk::JUMP;
+                analysis.indirect_jumps = true;
+                return {{0, 0}, 0};
+            case 0xD000:
+                analysis.quirks |= quirk::SPRITE;
+                if ((opcode & 0x000F) == 0) // 16x16 sprite
+                {
+                    require(analysis, Platform::SuperChip);
+                }
+                return {{after, 0}, 1};
+            case 0xE000:
+                return {{after, skipped}, 2};
+            case 0xF000:
+                if (opcode == 0xF000) // XO-CHIP long I load, skips the address word that follows
+                {
+                    require(analysis, Platform::XoChip);
+                    return {{static_cast<std::uint16_t>(after + 2), 0}, 1};
+                }
+                switch (low)
+                {
+                case 0x0A:
+                    analysis.quirks |= quirk::KEY_WAIT;
+                    break;
+                case 0x55:
+                case 0x65:
+                    analysis.quirks |= quirk::LOAD_STORE;
+                    break;
+                case 0x01:
+                case 0x02:
+                case 0x3A:
+                    require(analysis, Platform::XoChip);
+                    break;
+                case 0x30:
+                case 0x75:
+                case 0x85:
+                    require(analysis, Platform::SuperChip);
+                    break;
+                }
+                return {{after, 0}, 1};
+            default:
+                return {{after, 0}, 1};
+            }
+        }
+    } // namespace
+
+    bool RomAnalysis::isCode(const std::size_t address) const
+    {
+        return address < interpreter::MEMORY_SIZE && ((code[address / 64] >> (address % 64)) & 1) != 0;
+    }
+
+    RomAnalysis analyse(const std::uint8_t *rom, const std::size_t size)
+    {
+        RomAnalysis analysis;
+        const std::size_t end = interpreter::PROGRAM_START + std::min(size, interpreter::MAX_ROM_SIZE);
+        std::vector<std::uint16_t> pending{static_cast<std::uint16_t>(interpreter::PROGRAM_START)};
+        while (!pending.empty())
+        {
+            const std::uint16_t address = pending.back();
+            pending.pop_back();
+            // only whole instructions inside the ROM are followed, code in the font area or past the end is not the ROM's
+            if (address < interpreter::PROGRAM_START || std::size_t{address} + 1 >= end || analysis.isCode(address))
+            {
+                continue;
+            }
+            analysis.code[address / 64] |= std::uint64_t{1} << (address % 64);
+            ++analysis.instructions;
+            const std::size_t offset = address - interpreter::PROGRAM_START;
+            const std::uint16_t opcode = static_cast<std::uint16_t>(rom[offset] << 8 | rom[offset + 1]);
+            const std::uint16_t following = (std::size_t{address} + 3 < end) ? static_cast<std::uint16_t>(rom[offset + 2] << 8 | rom[offset + 3]) : 0;
+            const Successors next = successors(address, opcode, following, analysis);
+            for (int i = 0; i < next.count; ++i)
+            {
+                pending.push_back(next.next[i]);
+            }
+        }
+        return analysis;
+    }
+
+    const char *platformName(const Platform platform)
+    {
+        switch (platform)
+        {
+        case Platform::SuperChip:
+            return "SUPER-CHIP";
+        case Platform::XoChip:
+            return "XO-CHIP";
+        default:
+            return "CHIP-8";
+        }
+    }
+
+} // namespace emulator::rom
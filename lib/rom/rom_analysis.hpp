@@ -0,0 +1,53 @@
+#pragma once
+
+#include "interpreter.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace emulator::rom
+{
+    // the machine a ROM was written for, judged by the instructions it uses
+    using Platform = utils::Platform;
+
+    // instructions whose behaviour differs between interpreters, one bit each when the ROM's code uses them
+    namespace quirk
+    {
+        static constexpr std::uint8_t SHIFT = 1 << 0;      // 8xy6 / 8xyE shift Vx or Vy
+        static constexpr std::uint8_t LOAD_STORE = 1 << 1; // Fx55 / Fx65 leave I alone or advance it
+        static constexpr std::uint8_t JUMP = 1 << 2;       // Bnnn adds V0 or Vx
+        static constexpr std::uint8_t LOGIC = 1 << 3;      // 8xy1 / 8xy2 / 8xy3 reset VF or not
+        static constexpr std::uint8_t KEY_WAIT = 1 << 4;   // Fx0A finishes on press or on release
+        static constexpr std::uint8_t SPRITE = 1 << 5;     // Dxyn clips or wraps at the screen edges
+    } // namespace quirk
+
+    // what a static pass over a ROM found out, cheap to keep and to store next to the image
+    struct RomAnalysis
+    {
+        Platform platform = Platform::Chip8;
+        std::uint8_t quirks = 0;
+        // number of instructions reachable from PROGRAM_START
+        std::uint32_t instructions = 0;
+        // set if control flow leaves through Bnnn, whose target is only known at run time
+        bool indirect_jumps = false;
+        // one bit per address of memory, set where a reachable instruction starts
+        std::array<std::uint64_t, interpreter::MEMORY_SIZE / 64> code{};
+
+        bool isCode(const std::size_t address) const;
+    };
+
+    /**
+     * @brief Follow every branch from PROGRAM_START to find the ROM's code, then look at what it uses
+     * @details Data is never mistaken for code this way, except past an indirect jump's target which stays unknown
+     * @param rom The program as loaded at PROGRAM_START
+     * @param size Its size, at most MAX_ROM_SIZE
+     */
+    RomAnalysis analyse(const std::uint8_t *rom, const std::size_t size);
+
+    /**
+     * @brief Name of a platform for messages
+     */
+    const char *platformName(const Platform platform);
+
+} // namespace emulator::rom
@@ -0,0 +1,208 @@
+#include "rom_store.hpp"
+
+#include "hash.hpp"
+#include "mapped_file.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+namespace emulator::rom
+{
+    namespace
+    {
+        constexpr char CACHE_MAGIC[8] = {'C', '8', 'R', 'O', 'M', 'I', 'M', 'G'};
+        // bump whenever the layout or the analysis changes, older entries are then redone
+        constexpr std::uint32_t CACHE_VERSION = 2;
+
+        // start of a cache entry, followed by the ROM bytes and then the code bitmap
+        struct CacheHeader
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t size;
+            std::uint64_t hash;
+            std::uint32_t instructions;
+            std::uint8_t platform;
+            std::uint8_t quirks;
+            std::uint8_t indirect_jumps;
+            std::uint8_t reserved;
+        };
+        static_assert(sizeof(CacheHeader) == 32, "cache entries are read and written as raw bytes");
+    } // namespace
+
+    utils::Result RomImage::loadInto(interpreter::Chip8 &chip8, const std::optional<utils::Platform> platform) const
+    {
+        chip8.setPlatform(platform.value_or(analysis.platform));
+        return chip8.loadRom(bytes.data(), bytes.size());
+    }
+
+    RomStore::RomStore(std::filesystem::path cache_directory) : cache_directory_(std::move(cache_directory))
+    {
+    }
+
+    std::filesystem::path RomStore::defaultCacheDirectory()
+    {
+        if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+        {
+            return std::filesystem::path(xdg) / "chip8_emu";
+        }
+        if (const char *home = std::getenv("HOME"); home && *home)
+        {
+            return std::filesystem::path(home) / ".cache" / "chip8_emu";
+        }
+        return {};
+    }
+
+    std::shared_ptr<const RomImage> RomStore::load(const std::string &path, utils::Messenger &messenger)
+    {
+        messenger.printMessage("Loading game ", path, "...");
+        const auto file = utils::MappedFile::open(path.c_str());
+        if (!file)
+        {
+            messenger.log<utils::Level::Error>("Failed to open ", path);
+            return nullptr;
+        }
+        if (file->size() > interpreter::MAX_ROM_SIZE)
+        {
+            messenger.log<utils::Level::Error>(path, " is ", file->size(), " bytes, only ", interpreter::MAX_ROM_SIZE, " fit in memory");
+            return nullptr;
+        }
+        const std::uint64_t hash = utils::xxh64(file->data(), file->size());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (const auto found = images_.find(hash); found != images_.end())
+            {
+                return found->second;
+            }
+        }
+
+        // other threads may be doing the same ROM right now, whichever finishes first is kept
+        std::shared_ptr<RomImage> image = readCached(hash, file->data(), file->size());
+        if (!image)
+        {
+            image = std::make_shared<RomImage>();
+            image->hash = hash;
+            image->bytes.assign(file->data(), file->data() + file->size());
+            image->analysis = analyse(image->bytes.data(), image->bytes.size());
+            writeCached(*image);
+        }
+        messenger.printMessage("Found a ", platformName(image->analysis.platform), " game of ", image->bytes.size(), " bytes, ",
+                               image->analysis.instructions, " reachable instructions",
+                               image->from_cache ? " (analysis cached)" : "");
+        std::lock_guard<std::mutex> lock(mutex_);
+        return images_.emplace(hash, std::move(image)).first->second;
+    }
+
+    std::filesystem::path RomStore::cachePath(const std::uint64_t hash) const
+    {
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << hash << ".c8rom";
+        return cache_directory_ / name.str();
+    }
+
+    std::shared_ptr<RomImage> RomStore::readCached(const std::uint64_t hash, const std::uint8_t *bytes, const std::size_t size) const
+    {
+        if (cache_directory_.empty())
+        {
+            return nullptr;
+        }
+        const auto entry = utils::MappedFile::open(cachePath(hash).c_str());
+        const std::size_t expected = sizeof(CacheHeader) + size + sizeof(RomAnalysis::code);
+        if (!entry || entry->size() != expected)
+        {
+            return nullptr;
+        }
+        CacheHeader header;
+        std::memcpy(&header, entry->data(), sizeof(header));
+        const std::uint8_t *cached_bytes = entry->data() + sizeof(header);
+        // a hash collision or a damaged entry must never stand in for the real ROM
+        if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION ||
+            header.hash != hash || header.size != size || header.platform > static_cast<std::uint8_t>(Platform::XoChip) ||
+            (size > 0 && std::memcmp(cached_bytes, bytes, size) != 0))
+        {
+            return nullptr;
+        }
+        auto image = std::make_shared<RomImage>();
+        image->hash = hash;
+        image->bytes.assign(cached_bytes, cached_bytes + size);
+        image->analysis.platform = static_cast<Platform>(header.platform);
+        image->analysis.quirks = header.quirks;
+        image->analysis.instructions = header.instructions;
+        image->analysis.indirect_jumps = header.indirect_jumps != 0;
+        std::memcpy(image->analysis.code.data(), cached_bytes + size, sizeof(image->analysis.code));
+        image->from_cache = true;
+        return image;
+    }
+
+    void RomStore::writeCached(const RomImage &image) const
+    {
+        if (cache_directory_.empty())
+        {
+            return;
+        }
+        std::error_code error;
+        std::filesystem::create_directories(cache_directory_, error);
+        if (error)
+        {
+            return;
+        }
+        CacheHeader header{};
+        std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.version = CACHE_VERSION;
+        header.size = static_cast<std::uint32_t>(image.bytes.size());
+        header.hash = image.hash;
+        header.instructions = image.analysis.instructions;
+        header.platform = static_cast<std::uint8_t>(image.analysis.platform);
+        header.quirks = image.analysis.quirks;
+        header.indirect_jumps = image.analysis.indirect_jumps ? 1 : 0;
+
+        // written under a name of its own and renamed into place, readers never see half an entry; mkstemp picks a name
+        // no other thread or process is using, so two writers of the same entry never share a temporary file
+        const std::filesystem::path final_path = cachePath(image.hash);
+        std::string name = final_path.string() + ".XXXXXX";
+        const int fd = ::mkstemp(name.data());
+        if (fd < 0)
+        {
+            return;
+        }
+        const std::filesystem::path temporary = name;
+        const auto writeAll = [fd](const void *data, std::size_t size)
+        {
+            const auto *bytes = static_cast<const char *>(data);
+            while (size > 0)
+            {
+                const ssize_t count = ::write(fd, bytes, size);
+                if (count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (count <= 0)
+                {
+                    return false;
+                }
+                bytes += count;
+                size -= static_cast<std::size_t>(count);
+            }
+            return true;
+        };
+        const bool written = writeAll(&header, sizeof(header)) && writeAll(image.bytes.data(), image.bytes.size()) &&
+                             writeAll(image.analysis.code.data(), sizeof(image.analysis.code));
+        if (::close(fd) != 0 || !written)
+        {
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+        std::filesystem::rename(temporary, final_path, error);
+        if (error)
+        {
+            std::filesystem::remove(temporary, error);
+        }
+    }
+
+} // namespace emulator::rom
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "interpreter.hpp"
+#include "messages.hpp"
+#include "rom_analysis.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace emulator::rom
+{
+    // a validated ROM and everything learnt about it, shared read-only between every machine running it
+    struct RomImage
+    {
+        std::uint64_t hash = 0; // XXH64 of the bytes
+        std::vector<std::uint8_t> bytes;
+        RomAnalysis analysis;
+        bool from_cache = false; // analysis came from the disk cache instead of being redone
+
+        /**
+         * @brief Set the machine up for the image's platform and put the image into its memory
+         * @param platform The platform to emulate, the one the analysis found when not given
+         */
+        utils::Result loadInto(interpreter::Chip8 &chip8, const std::optional<utils::Platform> platform = std::nullopt) const;
+    };
+
+    // loads ROM files by mapping them, and remembers them by content hash in memory and in a cache directory
+    // a ROM seen before, under any name, skips validation and analysis; safe to use from several threads at once
+    class RomStore
+    {
+    public:
+        /**
+         * @param cache_directory Where analysed images are kept between runs, empty keeps them in memory only
+         */
+        explicit RomStore(std::filesystem::path cache_directory = defaultCacheDirectory());
+
+        /**
+         * @brief $XDG_CACHE_HOME/chip8_emu, or ~/.cache/chip8_emu, or nothing if neither is set
+         */
+        static std::filesystem::path defaultCacheDirectory();
+
+        /**
+         * @brief Load a ROM file
+         * @param path The file to load
+         * @param messenger Where to report what went wrong
+         * @return The image, or nullptr if the file cannot be read or does not fit in memory
+         */
+        std::shared_ptr<const RomImage> load(const std::string &path, utils::Messenger &messenger);
+
+    private:
+        /**
+         * @brief Read an image back from the cache directory
+         * @return The image, or nullptr if it is not there or does not match the ROM any more
+         */
+        std::shared_ptr<RomImage> readCached(const std::uint64_t hash, const std::uint8_t *bytes, const std::size_t size) const;
+
+        /**
+         * @brief Store an image in the cache directory, failures only cost the next run its head start
+         */
+        void writeCached(const RomImage &image) const;
+
+        std::filesystem::path cachePath(const std::uint64_t hash) const;
+
+    private:
+        std::filesystem::path cache_directory_;
+        std::mutex mutex_;
+        std::unordered_map<std::uint64_t, std::shared_ptr<const RomImage>> images_;
+    };
+
+} // namespace emulator::rom
@@ -0,0 +1,245 @@
+#include "emulation_thread.hpp"
+
+#include <algorithm>
+
+namespace emulator::scheduler
+{
+    namespace
+    {
+        // how long the speed readout averages over
+        constexpr std::chrono::milliseconds SPEED_WINDOW{500};
+    } // namespace
+
+    EmulationThread::EmulationThread(interpreter::Chip8 &chip8, utils::TripleBuffer<interpreter::FrameBuffer> &frames, utils::KeyMailbox &keys,
+                                     const std::size_t cpu_hz, const bool throttled, const std::size_t turbo, rewind::RewindBuffer *history,
+                                     audio::AudioOutput *audio, replay::InputLog *recording, share::SharedFrameWriter *shared,
+                                     capture::FrameCapture *capture)
+        : chip8_(chip8), frames_(frames), keys_(keys), scheduler_(cpu_hz), throttled_(throttled), turbo_(turbo),
+          turbo_pacer_(FRAME_PERIOD / static_cast<std::int64_t>(std::max<std::size_t>(turbo, 1))), history_(history), audio_(audio),
+          recording_(recording), shared_(shared), capture_(capture)
+    {
+    }
+
+    EmulationThread::~EmulationThread()
+    {
+        stop();
+    }
+
+    void EmulationThread::start(std::function<void()> on_frame)
+    {
+        on_frame_ = std::move(on_frame);
+        thread_ = std::thread(&EmulationThread::loop, this);
+    }
+
+    void EmulationThread::stop()
+    {
+        stop_.store(true, std::memory_order_relaxed);
+        keys_.wake();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    bool EmulationThread::finished() const
+    {
+        return finished_.load(std::memory_order_acquire);
+    }
+
+    const FrameStats &EmulationThread::stats() const
+    {
+        return pacer_.stats();
+    }
+
+    double EmulationThread::speed() const
+    {
+        return speed_.load(std::memory_order_relaxed);
+    }
+
+    const Histogram &EmulationThread::inputLatency() const
+    {
+        return input_latency_;
+    }
+
+    void EmulationThread::loop()
+    {
+        speed_since_ = std::chrono::steady_clock::now();
+        while (!stop_.load(std::memory_order_relaxed) && chip8_.shouldTerminate() == utils::Flag::Lowered)
+        {
+            if (keys_.fastForward() != fast_forwarding_)
+            {
+                // whichever pacer takes over starts from now instead of chasing the deadlines it missed
+                fast_forwarding_ = !fast_forwarding_;
+                (fast_forwarding_ ? turbo_pacer_ : pacer_).restart();
+            }
+            if (!fast_forwarding_ && chip8_.waitingForKey() && waitForInput())
+            {
+                // look at whatever woke the thread from the top
+                continue;
+            }
+            applyInput();
+            if (history_ && keys_.rewindHeld())
+            {
+                // stays on the oldest frame once history runs out, rewinding is silent
+                history_->rewind(chip8_, (history_->frames() > 1) ? 1 : 0);
+                if (audio_)
+                {
+                    audio_->pushTick(false);
+                }
+            }
+            else
+            {
+                scheduler_.runFrame(chip8_);
+                if (history_)
+                {
+                    history_->capture(chip8_);
+                }
+                if (audio_)
+                {
+                    audio_->pushTick(chip8_.shouldBuzz() == utils::Flag::Raised, chip8_.audioPattern(), chip8_.audioPitch());
+                }
+                if (recording_ && scheduler_.frame() % replay::DEFAULT_CHECKPOINT_INTERVAL == 0)
+                {
+                    recording_->recordCheckpoint(static_cast<std::uint32_t>(scheduler_.frame()), chip8_.hashGraphicsBuffer());
+                }
+            }
+            const bool drawn = chip8_.shouldDraw() == utils::Flag::Raised;
+            stale_ |= drawn;
+            if (capture_ && drawn)
+            {
+                capture_->push(chip8_.getFrameBuffer(), scheduler_.frame());
+            }
+            present(fast_forwarding_);
+            measureSpeed();
+            if (shared_)
+            {
+                publishShared();
+            }
+            if (fast_forwarding_ && turbo_ == 0)
+            {
+                continue;
+            }
+            if (fast_forwarding_)
+            {
+                turbo_pacer_.wait();
+            }
+            else if (throttled_)
+            {
+                pacer_.wait();
+            }
+        }
+        if (recording_)
+        {
+            // the session always ends on a checkpoint, however short it was
+            recording_->frames = static_cast<std::uint32_t>(scheduler_.frame());
+            if (recording_->checkpoints.empty() || recording_->checkpoints.back().frame != recording_->frames)
+            {
+                recording_->recordCheckpoint(recording_->frames, chip8_.hashGraphicsBuffer());
+            }
+        }
+        if (capture_)
+        {
+            // so the capture runs as long as the session did
+            capture_->push(chip8_.getFrameBuffer(), scheduler_.frame());
+        }
+        finished_.store(true, std::memory_order_release);
+        if (on_frame_)
+        {
+            on_frame_();
+        }
+    }
+
+    bool EmulationThread::waitForInput()
+    {
+        // read the count first, whatever arrives after it cuts the wait short
+        const std::uint64_t seen = keys_.signals();
+        if (stop_.load(std::memory_order_relaxed) || deferred_ || keys_.pending() || keys_.rewindHeld() || keys_.fastForward())
+        {
+            return false;
+        }
+        keys_.waitForSignal(seen);
+        // no time passed for the machine, pacing and the speed readout pick up from here
+        pacer_.restart();
+        speed_since_ = std::chrono::steady_clock::now();
+        speed_frames_ = 0;
+        return true;
+    }
+
+    void EmulationThread::applyInput()
+    {
+        if (deferred_)
+        {
+            applyKey(*deferred_);
+            deferred_.reset();
+        }
+        // keys pressed during this call, one bit each
+        std::uint16_t pressed = 0;
+        utils::InputEvent event;
+        while (keys_.take(event))
+        {
+            if (!event.pressed && (pressed >> event.key & 1))
+            {
+                deferred_ = event;
+                return;
+            }
+            if (event.pressed)
+            {
+                pressed |= static_cast<std::uint16_t>(1 << event.key);
+            }
+            applyKey(event);
+        }
+    }
+
+    void EmulationThread::applyKey(const utils::InputEvent &event)
+    {
+        chip8_.setKey(event.key, event.pressed);
+        if (recording_)
+        {
+            recording_->recordKey(static_cast<std::uint32_t>(scheduler_.frame()), event.key, event.pressed);
+        }
+        input_latency_.add(std::chrono::steady_clock::now() - event.time);
+    }
+
+    void EmulationThread::present(const bool fast_forward)
+    {
+        // fast forward makes far more frames than a window can show, only the newest one when it is ready for it
+        // matters, timers and sound still advance every frame
+        if (!stale_ || (fast_forward && frames_.pending()))
+        {
+            return;
+        }
+        frames_.write() = chip8_.getFrameBuffer();
+        frames_.publish();
+        stale_ = false;
+        if (on_frame_)
+        {
+            on_frame_();
+        }
+    }
+
+    void EmulationThread::measureSpeed()
+    {
+        ++speed_frames_;
+        const auto now = std::chrono::steady_clock::now();
+        const std::chrono::duration<double> elapsed = now - speed_since_;
+        if (elapsed >= SPEED_WINDOW)
+        {
+            speed_.store(speed_frames_ / elapsed.count() / FRAME_RATE, std::memory_order_relaxed);
+            speed_frames_ = 0;
+            speed_since_ = now;
+        }
+    }
+
+    void EmulationThread::publishShared()
+    {
+        share::FrameInfo info{};
+        info.frame = scheduler_.frame();
+        info.screen_hash = chip8_.hashGraphicsBuffer();
+        info.speed = speed_.load(std::memory_order_relaxed);
+        info.platform = static_cast<std::uint8_t>(chip8_.getPlatform());
+        info.buzzing = chip8_.shouldBuzz() == utils::Flag::Raised ? 1 : 0;
+        info.waiting_for_key = chip8_.waitingForKey() ? 1 : 0;
+        shared_->publish(chip8_.getFrameBuffer(), info);
+    }
+
+} // namespace emulator::scheduler
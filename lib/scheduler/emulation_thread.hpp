@@ -0,0 +1,150 @@
+#pragma once
+
+#include "audio_output.hpp"
+#include "frame_capture.hpp"
+#include "frame_stats.hpp"
+#include "input_log.hpp"
+#include "interpreter.hpp"
+#include "key_mailbox.hpp"
+#include "rewind.hpp"
+#include "scheduler.hpp"
+#include "shared_frame.hpp"
+#include "triple_buffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <thread>
+
+namespace emulator::scheduler
+{
+    // runs the interpreter frame by frame on its own thread
+    // finished screens are published into a triple buffer and key events are picked up from a mailbox at the start
+    // of every frame, so a window thread stuck in a vsync'd swap never holds up emulation
+    class EmulationThread
+    {
+    public:
+        /**
+         * @param chip8 The interpreter to run, it must not be touched by anyone else while the thread runs
+         * @param frames Where finished screens are published
+         * @param keys Where key presses and releases are picked up from
+         * @param cpu_hz Instructions per second of emulated time
+         * @param throttled Pace frames to 60 Hz of real time, otherwise run as fast as possible
+         * @param turbo Speed multiple while fast forward is toggled on in the mailbox, 0 runs uncapped
+         * @param history Where every frame is captured, and rewound from while the rewind key is held (optional)
+         * @param audio Where the buzzer samples of every frame go (optional)
+         * @param recording Where keys and periodic screen hashes are logged for replaying (optional), leave history out
+         * when recording since a rewound session cannot be replayed
+         * @param shared Where every frame and its stats are published for other processes (optional)
+         * @param capture Where every frame that drew something, and the last one, is recorded (optional, started by the caller)
+         */
+        EmulationThread(interpreter::Chip8 &chip8, utils::TripleBuffer<interpreter::FrameBuffer> &frames, utils::KeyMailbox &keys,
+                        const std::size_t cpu_hz, const bool throttled, const std::size_t turbo, rewind::RewindBuffer *history = nullptr,
+                        audio::AudioOutput *audio = nullptr, replay::InputLog *recording = nullptr,
+                        share::SharedFrameWriter *shared = nullptr, capture::FrameCapture *capture = nullptr);
+        ~EmulationThread();
+
+        EmulationThread(const EmulationThread &) = delete;
+        EmulationThread &operator=(const EmulationThread &) = delete;
+
+        /**
+         * @brief Start emulating
+         * @param on_frame Called from the emulation thread after every published frame and once when it finishes
+         */
+        void start(std::function<void()> on_frame);
+
+        /**
+         * @brief Ask the thread to stop after the current frame and wait for it
+         */
+        void stop();
+
+        /**
+         * @brief Check if the emulation loop has ended, either stopped or out of instructions
+         */
+        bool finished() const;
+
+        /**
+         * @brief Frame pacing statistics, only meaningful once the thread has stopped
+         */
+        const FrameStats &stats() const;
+
+        /**
+         * @brief Emulated time per real time over the last half second, 1 at normal speed
+         */
+        double speed() const;
+
+        /**
+         * @brief Time from the window thread seeing a key event to the machine getting it, only meaningful once the thread has stopped
+         */
+        const Histogram &inputLatency() const;
+
+    private:
+        void loop();
+
+        /**
+         * @brief Sleep until a key, the rewind key, fast forward or stop, while the machine waits for a key and nothing else changes
+         * @return False if there was something to act on already and the thread did not sleep
+         */
+        bool waitForInput();
+
+        /**
+         * @brief Hand the queued key events to the machine before a frame runs
+         * @details A key released in the same frame it was pressed stays down for that frame, the release and everything
+         * after it wait for the next one, so even the shortest tap is seen by a game that polls once a frame
+         */
+        void applyInput();
+
+        /**
+         * @brief Press or release a key on the machine, and log and time it
+         */
+        void applyKey(const utils::InputEvent &event);
+
+        /**
+         * @brief Hand the screen to the window thread, at fast forward speeds only once it took the previous one
+         */
+        void present(const bool fast_forward);
+
+        /**
+         * @brief Count a frame towards the speed readout
+         */
+        void measureSpeed();
+
+        /**
+         * @brief Copy the screen and the frame stats into the shared memory segment
+         */
+        void publishShared();
+
+    private:
+        interpreter::Chip8 &chip8_;
+        utils::TripleBuffer<interpreter::FrameBuffer> &frames_;
+        utils::KeyMailbox &keys_;
+        Scheduler scheduler_;
+        FramePacer pacer_;
+        bool throttled_;
+        std::size_t turbo_;
+        // paces fast forward at turbo_ times normal speed, kept apart so its frames stay out of pacer_'s statistics
+        FramePacer turbo_pacer_;
+        bool fast_forwarding_ = false;
+        // a frame was drawn but not published yet
+        bool stale_ = false;
+        std::chrono::steady_clock::time_point speed_since_;
+        std::uint64_t speed_frames_ = 0;
+        std::atomic<double> speed_{1.0};
+        // a release held back by applyInput for the next frame
+        std::optional<utils::InputEvent> deferred_;
+        // per 250 us up to 50 ms, a few frames
+        Histogram input_latency_{std::chrono::microseconds(250), 200};
+        rewind::RewindBuffer *history_;
+        audio::AudioOutput *audio_;
+        replay::InputLog *recording_;
+        share::SharedFrameWriter *shared_;
+        capture::FrameCapture *capture_;
+        std::function<void()> on_frame_;
+        std::atomic<bool> stop_{false};
+        std::atomic<bool> finished_{false};
+        std::thread thread_;
+    };
+
+} // namespace emulator::scheduler
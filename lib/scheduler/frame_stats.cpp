@@ -0,0 +1,145 @@
+#include "frame_stats.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace emulator::scheduler
+{
+    namespace
+    {
+        double toMilliseconds(const std::chrono::nanoseconds duration)
+        {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        }
+    } // namespace
+
+    Histogram::Histogram(const std::chrono::nanoseconds bucket_width, const std::size_t bucket_count)
+        : bucket_width_(bucket_width), buckets_(bucket_count + 1, 0)
+    {
+    }
+
+    void Histogram::add(const std::chrono::nanoseconds sample)
+    {
+        const auto clamped = std::max(sample, std::chrono::nanoseconds{0});
+        const std::size_t bucket = std::min<std::size_t>(clamped / bucket_width_, buckets_.size() - 1);
+        ++buckets_[bucket];
+        ++count_;
+        total_ += clamped;
+        max_ = std::max(max_, clamped);
+    }
+
+    void Histogram::reset()
+    {
+        std::fill(buckets_.begin(), buckets_.end(), 0);
+        count_ = 0;
+        total_ = std::chrono::nanoseconds{0};
+        max_ = std::chrono::nanoseconds{0};
+    }
+
+    std::size_t Histogram::count() const
+    {
+        return count_;
+    }
+
+    std::chrono::nanoseconds Histogram::mean() const
+    {
+        return (count_ == 0) ? std::chrono::nanoseconds{0} : total_ / static_cast<std::int64_t>(count_);
+    }
+
+    std::chrono::nanoseconds Histogram::max() const
+    {
+        return max_;
+    }
+
+    std::chrono::nanoseconds Histogram::percentile(const double fraction) const
+    {
+        if (count_ == 0)
+        {
+            return std::chrono::nanoseconds{0};
+        }
+        const auto wanted = static_cast<std::uint64_t>(std::clamp(fraction, 0.0, 1.0) * (count_ - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i + 1 < buckets_.size(); ++i)
+        {
+            seen += buckets_[i];
+            if (seen >= wanted)
+            {
+                return std::min(bucket_width_ * static_cast<std::int64_t>(i + 1), max_);
+            }
+        }
+        return max_;
+    }
+
+    std::chrono::nanoseconds Histogram::bucketWidth() const
+    {
+        return bucket_width_;
+    }
+
+    const std::vector<std::uint64_t> &Histogram::buckets() const
+    {
+        return buckets_;
+    }
+
+    std::string Histogram::report(const char *name) const
+    {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3);
+        out << name << ": mean " << toMilliseconds(mean())
+            << " ms, p50 " << toMilliseconds(percentile(0.50))
+            << " ms, p99 " << toMilliseconds(percentile(0.99))
+            << " ms, max " << toMilliseconds(max()) << " ms\n";
+        for (std::size_t i = 0; i < buckets_.size(); ++i)
+        {
+            if (buckets_[i] == 0)
+            {
+                continue;
+            }
+            const auto low = bucket_width_ * static_cast<std::int64_t>(i);
+            out << "  " << std::setw(8) << toMilliseconds(low)
+                << ((i + 1 == buckets_.size()) ? " ms+      " : " ms       ")
+                << std::setw(8) << buckets_[i] << '\n';
+        }
+        return out.str();
+    }
+
+    // frame times are bucketed per 250 us up to twice the period, jitter per 50 us up to 5 ms
+    FrameStats::FrameStats(const std::chrono::nanoseconds period)
+        : period_(period),
+          frame_times_(std::chrono::microseconds(250), static_cast<std::size_t>(2 * period / std::chrono::microseconds(250))),
+          jitter_(std::chrono::microseconds(50), 100)
+    {
+    }
+
+    void FrameStats::record(const std::chrono::nanoseconds frame_time)
+    {
+        frame_times_.add(frame_time);
+        jitter_.add((frame_time > period_) ? frame_time - period_ : period_ - frame_time);
+    }
+
+    void FrameStats::reset()
+    {
+        frame_times_.reset();
+        jitter_.reset();
+    }
+
+    const Histogram &FrameStats::frameTimes() const
+    {
+        return frame_times_;
+    }
+
+    const Histogram &FrameStats::jitter() const
+    {
+        return jitter_;
+    }
+
+    std::string FrameStats::report() const
+    {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3);
+        out << frame_times_.count() << " frames, target " << toMilliseconds(period_) << " ms\n";
+        out << frame_times_.report("frame time") << jitter_.report("jitter");
+        return out.str();
+    }
+
+} // namespace emulator::scheduler
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace emulator::scheduler
+{
+    // fixed-width bucket histogram of durations, anything past the last bucket lands in the overflow bucket
+    class Histogram
+    {
+    public:
+        Histogram(const std::chrono::nanoseconds bucket_width, const std::size_t bucket_count);
+
+        /**
+         * @brief Record one sample
+         */
+        void add(const std::chrono::nanoseconds sample);
+
+        /**
+         * @brief Drop every sample
+         */
+        void reset();
+
+        std::size_t count() const;
+        std::chrono::nanoseconds mean() const;
+        std::chrono::nanoseconds max() const;
+
+        /**
+         * @brief Estimate a percentile from the buckets
+         * @param fraction The percentile as a fraction in [0, 1]
+         * @return The upper edge of the bucket holding the percentile
+         */
+        std::chrono::nanoseconds percentile(const double fraction) const;
+
+        std::chrono::nanoseconds bucketWidth() const;
+
+        /**
+         * @brief Sample counts per bucket, the last entry is the overflow bucket
+         */
+        const std::vector<std::uint64_t> &buckets() const;
+
+        /**
+         * @brief Summarise the histogram as text, one line for the statistics and one per non-empty bucket
+         * @param name What the samples are, starts the first line
+         */
+        std::string report(const char *name) const;
+
+    private:
+        std::chrono::nanoseconds bucket_width_;
+        std::vector<std::uint64_t> buckets_;
+        std::uint64_t count_ = 0;
+        std::chrono::nanoseconds total_{0};
+        std::chrono::nanoseconds max_{0};
+    };
+
+    // frame time and jitter (distance from the target period) of every paced frame
+    class FrameStats
+    {
+    public:
+        explicit FrameStats(const std::chrono::nanoseconds period);
+
+        /**
+         * @brief Record the time between two consecutive frames
+         */
+        void record(const std::chrono::nanoseconds frame_time);
+
+        void reset();
+
+        const Histogram &frameTimes() const;
+        const Histogram &jitter() const;
+
+        /**
+         * @brief Summarise both histograms as text, one line per statistic and per non-empty bucket
+         */
+        std::string report() const;
+
+    private:
+        std::chrono::nanoseconds period_;
+        Histogram frame_times_;
+        Histogram jitter_;
+    };
+
+} // namespace emulator::scheduler
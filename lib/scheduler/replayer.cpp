@@ -0,0 +1,37 @@
+#include "replayer.hpp"
+#include "scheduler.hpp"
+
+namespace emulator::scheduler
+{
+    ReplayReport replay(interpreter::Chip8 &chip8, const replay::InputLog &log)
+    {
+        ReplayReport report;
+        Scheduler scheduler(log.cpu_hz);
+        chip8.seed(log.seed);
+        auto key = log.keys.begin();
+        auto checkpoint = log.checkpoints.begin();
+        while (scheduler.frame() < log.frames && chip8.shouldTerminate() == utils::Flag::Lowered)
+        {
+            for (; key != log.keys.end() && key->frame == scheduler.frame(); ++key)
+            {
+                chip8.setKey(key->key, key->pressed);
+            }
+            report.instructions += scheduler.runFrame(chip8);
+            for (; checkpoint != log.checkpoints.end() && checkpoint->frame == scheduler.frame(); ++checkpoint)
+            {
+                const std::uint64_t hash = chip8.hashGraphicsBuffer();
+                if (hash != checkpoint->hash)
+                {
+                    report.frames = static_cast<std::uint32_t>(scheduler.frame());
+                    report.mismatch = *checkpoint;
+                    report.actual = hash;
+                    return report;
+                }
+                ++report.checkpoints;
+            }
+        }
+        report.frames = static_cast<std::uint32_t>(scheduler.frame());
+        return report;
+    }
+
+} // namespace emulator::scheduler
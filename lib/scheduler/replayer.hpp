@@ -0,0 +1,32 @@
+#pragma once
+
+#include "input_log.hpp"
+#include "interpreter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace emulator::scheduler
+{
+    // how a recorded session played back
+    struct ReplayReport
+    {
+        std::uint32_t frames = 0;
+        std::uint64_t instructions = 0;
+        std::size_t checkpoints = 0; // checkpoints whose hash matched
+        // the first checkpoint that did not match, with the hash the replay got there instead
+        std::optional<replay::Checkpoint> mismatch;
+        std::uint64_t actual = 0;
+    };
+
+    /**
+     * @brief Play a recorded session back as fast as possible and check the screen at every checkpoint
+     * @details The frames are cut up and the keys handed over exactly like EmulationThread does, so an unchanged
+     * interpreter reproduces every hash. Stops at the first mismatch
+     * @param chip8 A machine with the recorded ROM freshly loaded, it is seeded from the log
+     * @param log The session to play
+     */
+    ReplayReport replay(interpreter::Chip8 &chip8, const replay::InputLog &log);
+
+} // namespace emulator::scheduler
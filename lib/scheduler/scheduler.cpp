@@ -0,0 +1,81 @@
+#include "scheduler.hpp"
+
+#include <thread>
+
+namespace emulator::scheduler
+{
+    namespace
+    {
+        // frames the pacer may fall behind before it gives up on catching up
+        constexpr int MAX_LAG_FRAMES = 4;
+    } // namespace
+
+    Scheduler::Scheduler(const std::size_t cpu_hz, const std::uint64_t frame) : cpu_hz_(cpu_hz), frame_(frame)
+    {
+    }
+
+    std::size_t Scheduler::runFrame(interpreter::Chip8 &chip8)
+    {
+        const std::size_t executed = chip8.run(budget());
+        chip8.tickTimers();
+        ++frame_;
+        return executed;
+    }
+
+    std::size_t Scheduler::budget() const
+    {
+        return static_cast<std::size_t>((frame_ + 1) * cpu_hz_ / FRAME_RATE - frame_ * cpu_hz_ / FRAME_RATE);
+    }
+
+    std::size_t Scheduler::cpuHz() const
+    {
+        return cpu_hz_;
+    }
+
+    std::uint64_t Scheduler::frame() const
+    {
+        return frame_;
+    }
+
+    FramePacer::FramePacer(const std::chrono::nanoseconds period, const std::chrono::nanoseconds spin_window)
+        : period_(period), spin_window_(spin_window), deadline_(Clock::now()), last_frame_(deadline_), stats_(period)
+    {
+    }
+
+    void FramePacer::wait()
+    {
+        deadline_ += period_;
+        const auto now = Clock::now();
+        if (now > deadline_ + period_ * MAX_LAG_FRAMES)
+        {
+            // too far behind (debugger, suspended process...), start counting from now
+            deadline_ = now;
+        }
+        else
+        {
+            if (deadline_ - now > spin_window_)
+            {
+                std::this_thread::sleep_until(deadline_ - spin_window_);
+            }
+            while (Clock::now() < deadline_)
+            {
+                std::this_thread::yield();
+            }
+        }
+        const auto frame_end = Clock::now();
+        stats_.record(frame_end - last_frame_);
+        last_frame_ = frame_end;
+    }
+
+    void FramePacer::restart()
+    {
+        deadline_ = Clock::now();
+        last_frame_ = deadline_;
+    }
+
+    const FrameStats &FramePacer::stats() const
+    {
+        return stats_;
+    }
+
+} // namespace emulator::scheduler
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "frame_stats.hpp"
+#include "interpreter.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace emulator::scheduler
+{
+    // the delay and sound timers always count down at this rate, whatever the instruction rate is
+    static constexpr std::size_t FRAME_RATE = 60;
+    static constexpr std::size_t DEFAULT_CPU_HZ = 700;
+    static constexpr std::chrono::nanoseconds FRAME_PERIOD{std::chrono::nanoseconds(std::chrono::seconds(1)) / FRAME_RATE};
+
+    // splits a CPU clock into per-frame instruction budgets and ticks the timers once per frame
+    // budgets carry the remainder over, so 700 Hz runs 11 or 12 instructions a frame and exactly 700 a second
+    class Scheduler
+    {
+    public:
+        /**
+         * @param cpu_hz Instructions per second of emulated time
+         * @param frame The frame to count from, to pick up a machine forked or saved that many frames in
+         */
+        explicit Scheduler(const std::size_t cpu_hz = DEFAULT_CPU_HZ, const std::uint64_t frame = 0);
+
+        /**
+         * @brief Run one frame worth of instructions, then tick the timers
+         * @param chip8 The interpreter to drive
+         * @return The number of instructions executed
+         */
+        std::size_t runFrame(interpreter::Chip8 &chip8);
+
+        /**
+         * @brief The number of instructions the next frame gets
+         */
+        std::size_t budget() const;
+
+        std::size_t cpuHz() const;
+        std::uint64_t frame() const;
+
+    private:
+        std::size_t cpu_hz_;
+        std::uint64_t frame_;
+    };
+
+    // holds a loop to a fixed period using absolute steady_clock deadlines
+    // sleeps until shortly before each deadline and spins the rest of the way, since sleeps tend to overshoot
+    class FramePacer
+    {
+    public:
+        /**
+         * @param period The target time between frames
+         * @param spin_window How long before the deadline to stop sleeping and start spinning
+         */
+        explicit FramePacer(const std::chrono::nanoseconds period = FRAME_PERIOD,
+                            const std::chrono::nanoseconds spin_window = std::chrono::microseconds(1500));
+
+        /**
+         * @brief Block until the next deadline and record how long the frame took
+         * @details Deadlines are dropped rather than chased when the loop falls several frames behind
+         */
+        void wait();
+
+        /**
+         * @brief Start counting deadlines from now, after the loop was paced by something else for a while
+         */
+        void restart();
+
+        const FrameStats &stats() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::chrono::nanoseconds period_;
+        std::chrono::nanoseconds spin_window_;
+        Clock::time_point deadline_;
+        Clock::time_point last_frame_;
+        FrameStats stats_;
+    };
+
+} // namespace emulator::scheduler
@@ -0,0 +1,418 @@
+#include "search.hpp"
+
+#include "hash.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <unordered_set>
+
+namespace emulator::search
+{
+    namespace
+    {
+        constexpr std::uint32_t NO_NODE = std::numeric_limits<std::uint32_t>::max();
+
+        // a machine per worker, only ever touched by the tasks that worker runs
+        struct alignas(64) Worker
+        {
+            std::unique_ptr<interpreter::Chip8> chip8;
+            std::uint64_t frames = 0;
+        };
+
+        // what both strategies work with
+        struct Context
+        {
+            Context(const Scorer &score, const SearchOptions &options) : score(score), options(options), pool(options.threads), workers(pool.size())
+            {
+                actions = options.actions;
+                if (actions.empty())
+                {
+                    actions.push_back(0);
+                    for (std::size_t key = 0; key < 16; ++key)
+                    {
+                        actions.push_back(static_cast<KeyMask>(1u << key));
+                    }
+                }
+            }
+
+            Worker &worker()
+            {
+                return workers[pool.currentWorker()];
+            }
+
+            const Scorer &score;
+            const SearchOptions &options;
+            std::vector<KeyMask> actions;
+            utils::WorkStealingPool pool;
+            std::vector<Worker> workers;
+            // the machine as the ROM left it, before the first step
+            interpreter::MachineState root{};
+        };
+
+        utils::Result loadMachine(interpreter::Chip8 &chip8, const rom::RomImage &rom, const SearchOptions &options)
+        {
+            chip8.setEngine(options.engine);
+            if (rom.loadInto(chip8, options.platform) == utils::Result::Failure)
+            {
+                return utils::Result::Failure;
+            }
+            chip8.seed(options.seed);
+            return utils::Result::Success;
+        }
+
+        /**
+         * @brief Hold a set of keys down for a step, releasing the others
+         * @param frame The frame the step starts at, which decides the instruction budget of its frames
+         */
+        void hold(Worker &worker, const SearchOptions &options, const KeyMask keys, const std::uint64_t frame)
+        {
+            for (std::uint8_t key = 0; key < 16; ++key)
+            {
+                worker.chip8->setKey(key, (keys >> key & 1) != 0);
+            }
+            scheduler::Scheduler scheduler(options.cpu_hz, frame);
+            for (std::size_t i = 0; i < options.frames_per_step; ++i)
+            {
+                scheduler.runFrame(*worker.chip8);
+            }
+            worker.frames += options.frames_per_step;
+        }
+
+        // two states that agree on this are taken to be the same position: the registers but the keyboard, which
+        // the next step overwrites anyway, the screen and the score
+        std::uint64_t identity(const interpreter::MachineState &state, const std::uint64_t screen_hash, const double score)
+        {
+            const interpreter::Registers &registers = state.registers;
+            std::uint64_t hash = utils::xxh64(&registers, offsetof(interpreter::Registers, keyboard), screen_hash);
+            hash = utils::xxh64(registers.flags, offsetof(interpreter::Registers, pattern_loaded) + 1 - offsetof(interpreter::Registers, flags), hash);
+            return utils::xxh64(&score, sizeof(score), hash);
+        }
+
+        std::uint64_t hashScreen(const interpreter::FrameBuffer &screen)
+        {
+            return utils::xxh64(screen.words(), interpreter::FrameBuffer::WORDS * sizeof(std::uint64_t));
+        }
+
+        SearchResult beamSearch(Context &context)
+        {
+            struct Node
+            {
+                interpreter::MachineState state{};
+                double score = 0.0;
+                std::uint64_t screen_hash = 0;
+                std::uint64_t identity = 0;
+                std::uint32_t parent = NO_NODE;
+                KeyMask keys = 0;
+            };
+            const SearchOptions &options = context.options;
+            const std::size_t action_count = context.actions.size();
+
+            // the nodes kept at every step, only the newest step still holds its states so unshared pages are freed
+            std::vector<std::vector<Node>> steps(1);
+            Node &root = steps.front().emplace_back();
+            root.state = context.root;
+            root.score = context.score(root.state);
+            root.screen_hash = hashScreen(*root.state.screen);
+            for (std::size_t depth = 0; depth < options.horizon; ++depth)
+            {
+                const std::vector<Node> &frontier = steps.back();
+                std::vector<Node> children(frontier.size() * action_count);
+                const std::uint64_t frame = depth * options.frames_per_step;
+                for (std::size_t parent = 0; parent < frontier.size(); ++parent)
+                {
+                    context.pool.submit([&, parent] {
+                        Worker &worker = context.worker();
+                        for (std::size_t action = 0; action < action_count; ++action)
+                        {
+                            // loading the parent again only restores the pages the previous action wrote to
+                            worker.chip8->loadState(frontier[parent].state);
+                            hold(worker, options, context.actions[action], frame);
+                            Node &child = children[parent * action_count + action];
+                            worker.chip8->fork(child.state);
+                            child.score = context.score(child.state);
+                            child.screen_hash = child.state.screen == frontier[parent].state.screen ? frontier[parent].screen_hash : hashScreen(*child.state.screen);
+                            child.identity = identity(child.state, child.screen_hash, child.score);
+                            child.parent = static_cast<std::uint32_t>(parent);
+                            child.keys = context.actions[action];
+                        }
+                    });
+                }
+                context.pool.wait();
+
+                // the first of every set of duplicates in submission order, then the best of those, ties going to the
+                // earlier one, so the outcome does not depend on how the tasks were spread over the workers
+                std::vector<std::uint32_t> kept;
+                kept.reserve(children.size());
+                std::unordered_set<std::uint64_t> seen;
+                for (std::size_t i = 0; i < children.size(); ++i)
+                {
+                    if (seen.insert(children[i].identity).second)
+                    {
+                        kept.push_back(static_cast<std::uint32_t>(i));
+                    }
+                }
+                std::stable_sort(kept.begin(), kept.end(), [&](const std::uint32_t a, const std::uint32_t b) { return children[a].score > children[b].score; });
+                kept.resize(std::min(kept.size(), std::max<std::size_t>(options.beam_width, 1)));
+                std::vector<Node> next;
+                next.reserve(kept.size());
+                for (const std::uint32_t i : kept)
+                {
+                    next.push_back(std::move(children[i]));
+                }
+                for (Node &node : steps.back())
+                {
+                    node.state = {};
+                }
+                steps.push_back(std::move(next));
+            }
+
+            // the nodes are sorted best first, walk the best one's parents back to the root
+            SearchResult result;
+            result.score = steps.back().front().score;
+            result.inputs.resize(options.horizon);
+            std::uint32_t at = 0;
+            for (std::size_t depth = options.horizon; depth > 0; --depth)
+            {
+                result.inputs[depth - 1] = steps[depth][at].keys;
+                at = steps[depth][at].parent;
+            }
+            return result;
+        }
+
+        SearchResult treeSearch(Context &context)
+        {
+            struct Node
+            {
+                interpreter::MachineState state{};
+                std::uint32_t parent = NO_NODE;
+                KeyMask keys = 0;
+                std::uint32_t depth = 0;
+                std::uint32_t tried = 0; // actions expanded or being expanded, in order
+                std::vector<std::uint32_t> children;
+                std::uint32_t visits = 0;
+                // playouts still running below the node, counted as losses so concurrent playouts spread out
+                std::uint32_t virtual_visits = 0;
+                double total = 0.0;
+            };
+            const SearchOptions &options = context.options;
+            const std::size_t action_count = context.actions.size();
+
+            // the tree, behind one lock; a deque keeps nodes in place as it grows, and a node's state is written
+            // before the node is added and never after, so playouts read it without the lock
+            std::mutex mutex;
+            std::deque<Node> nodes(1);
+            nodes.front().state = context.root;
+            // the range of the scores seen, to bring the averages the selection compares into 0..1
+            double lowest = std::numeric_limits<double>::infinity();
+            double highest = -std::numeric_limits<double>::infinity();
+            SearchResult result;
+            result.score = -std::numeric_limits<double>::infinity();
+
+            // upper confidence bound of a child, the running playouts through it counted as scoring the lowest
+            const auto bound = [&](const Node &child, const double log_parent_visits) {
+                const double visits = child.visits + child.virtual_visits;
+                const double mean = (child.total + child.virtual_visits * lowest) / visits;
+                const double range = highest > lowest ? highest - lowest : 1.0;
+                return (mean - lowest) / range + options.exploration * std::sqrt(log_parent_visits / visits);
+            };
+
+            const auto playout = [&](const std::size_t number) {
+                Worker &worker = context.worker();
+                std::vector<std::uint32_t> path;
+                std::vector<KeyMask> inputs;
+                inputs.reserve(options.horizon);
+                const Node *leaf = nullptr;
+                std::size_t action = action_count;
+                {
+                    // select down to a node with an action left to try, or to the horizon
+                    std::lock_guard lock(mutex);
+                    std::uint32_t at = 0;
+                    path.push_back(at);
+                    while (nodes[at].depth < options.horizon)
+                    {
+                        Node &node = nodes[at];
+                        if (node.tried < action_count)
+                        {
+                            action = node.tried++;
+                            break;
+                        }
+                        if (node.children.empty())
+                        {
+                            // every action is still being expanded by another playout
+                            break;
+                        }
+                        const double log_visits = std::log(static_cast<double>(node.visits + node.virtual_visits));
+                        at = *std::max_element(node.children.begin(), node.children.end(), [&](const std::uint32_t a, const std::uint32_t b) {
+                            return bound(nodes[a], log_visits) < bound(nodes[b], log_visits);
+                        });
+                        path.push_back(at);
+                        inputs.push_back(nodes[at].keys);
+                    }
+                    for (const std::uint32_t node : path)
+                    {
+                        ++nodes[node].virtual_visits;
+                    }
+                    leaf = &nodes[at];
+                }
+
+                // expand the chosen action, then play random ones to the horizon
+                worker.chip8->loadState(leaf->state);
+                std::size_t depth = leaf->depth;
+                interpreter::MachineState expanded{};
+                if (action < action_count)
+                {
+                    hold(worker, options, context.actions[action], depth * options.frames_per_step);
+                    worker.chip8->fork(expanded);
+                    inputs.push_back(context.actions[action]);
+                    ++depth;
+                }
+                std::mt19937_64 random(options.seed + number);
+                for (; depth < options.horizon; ++depth)
+                {
+                    const KeyMask keys = context.actions[random() % action_count];
+                    hold(worker, options, keys, depth * options.frames_per_step);
+                    inputs.push_back(keys);
+                }
+                interpreter::MachineState end{};
+                worker.chip8->fork(end);
+                const double value = context.score(end);
+
+                std::lock_guard lock(mutex);
+                if (action < action_count)
+                {
+                    Node &child = nodes.emplace_back();
+                    child.state = std::move(expanded);
+                    child.parent = path.back();
+                    child.keys = context.actions[action];
+                    child.depth = leaf->depth + 1;
+                    child.visits = 1;
+                    child.total = value;
+                    nodes[path.back()].children.push_back(static_cast<std::uint32_t>(nodes.size() - 1));
+                }
+                for (const std::uint32_t node : path)
+                {
+                    --nodes[node].virtual_visits;
+                    ++nodes[node].visits;
+                    nodes[node].total += value;
+                }
+                lowest = std::min(lowest, value);
+                highest = std::max(highest, value);
+                if (value > result.score)
+                {
+                    result.score = value;
+                    result.inputs = std::move(inputs);
+                }
+            };
+
+            for (std::size_t number = 0; number < std::max<std::size_t>(options.playouts, 1); ++number)
+            {
+                context.pool.submit([&playout, number] { playout(number); });
+            }
+            context.pool.wait();
+            return result;
+        }
+    } // namespace
+
+    std::uint8_t peek(const interpreter::MachineState &state, const std::size_t address)
+    {
+        const std::size_t space = state.platform == utils::Platform::XoChip ? interpreter::MEMORY_SIZE : interpreter::CHIP8_MEMORY_SIZE;
+        const std::size_t wrapped = address & (space - 1);
+        return state.page(wrapped / interpreter::PAGE_SIZE)->bytes[wrapped % interpreter::PAGE_SIZE];
+    }
+
+    Scorer scoreAt(const std::size_t address, const std::size_t bytes)
+    {
+        const std::size_t count = std::clamp<std::size_t>(bytes, 1, sizeof(std::uint64_t));
+        return [address, count](const interpreter::MachineState &state) {
+            std::uint64_t value = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                value = value << 8 | peek(state, address + i);
+            }
+            return static_cast<double>(value);
+        };
+    }
+
+    std::optional<SearchResult> search(const rom::RomImage &rom, const Scorer &score, const SearchOptions &options, utils::Messenger &messenger)
+    {
+        Context context(score, options);
+        for (Worker &worker : context.workers)
+        {
+            worker.chip8 = std::make_unique<interpreter::Chip8>(messenger);
+            if (loadMachine(*worker.chip8, rom, options) == utils::Result::Failure)
+            {
+                return std::nullopt;
+            }
+        }
+        context.workers.front().chip8->fork(context.root);
+        if (options.horizon == 0)
+        {
+            SearchResult result;
+            result.score = score(context.root);
+            return result;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        SearchResult result = options.strategy == Strategy::Beam ? beamSearch(context) : treeSearch(context);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.frames = std::accumulate(context.workers.begin(), context.workers.end(), std::uint64_t{0},
+                                        [](const std::uint64_t sum, const Worker &worker) { return sum + worker.frames; });
+        result.steals = context.pool.steals();
+        return result;
+    }
+
+    std::optional<replay::InputLog> recordSession(const rom::RomImage &rom, const std::vector<KeyMask> &inputs, const SearchOptions &options, utils::Messenger &messenger)
+    {
+        interpreter::Chip8 chip8(messenger);
+        if (loadMachine(chip8, rom, options) == utils::Result::Failure)
+        {
+            return std::nullopt;
+        }
+        replay::InputLog log;
+        log.seed = options.seed;
+        log.rom_hash = rom.hash;
+        log.cpu_hz = static_cast<std::uint32_t>(options.cpu_hz);
+        log.platform = chip8.getPlatform();
+
+        // only the keys that change between steps are logged, at the first frame of the step
+        scheduler::Scheduler scheduler(options.cpu_hz);
+        KeyMask held = 0;
+        for (const KeyMask keys : inputs)
+        {
+            for (std::uint8_t key = 0; key < 16; ++key)
+            {
+                const bool pressed = (keys >> key & 1) != 0;
+                if (pressed != ((held >> key & 1) != 0))
+                {
+                    log.recordKey(static_cast<std::uint32_t>(scheduler.frame()), key, pressed);
+                    chip8.setKey(key, pressed);
+                }
+            }
+            held = keys;
+            for (std::size_t i = 0; i < options.frames_per_step; ++i)
+            {
+                scheduler.runFrame(chip8);
+                if (scheduler.frame() % replay::DEFAULT_CHECKPOINT_INTERVAL == 0)
+                {
+                    log.recordCheckpoint(static_cast<std::uint32_t>(scheduler.frame()), chip8.hashGraphicsBuffer());
+                }
+            }
+        }
+        log.frames = static_cast<std::uint32_t>(scheduler.frame());
+        if (log.frames % replay::DEFAULT_CHECKPOINT_INTERVAL != 0)
+        {
+            log.recordCheckpoint(log.frames, chip8.hashGraphicsBuffer());
+        }
+        return log;
+    }
+
+} // namespace emulator::search
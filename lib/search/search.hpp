@@ -0,0 +1,85 @@
+#pragma once
+
+#include "common.hpp"
+#include "input_log.hpp"
+#include "interpreter.hpp"
+#include "messages.hpp"
+#include "rom_store.hpp"
+#include "scheduler.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace emulator::search
+{
+    // the Chip8 keys held down during a step, bit k for key k
+    using KeyMask = std::uint16_t;
+
+    // rates a machine, higher is better; called from every worker at once, so it must not change state of its own
+    using Scorer = std::function<double(const interpreter::MachineState &)>;
+
+    enum class Strategy
+    {
+        Beam, // keep the best states after every step, each expanded by every action
+        Mcts  // grow a tree towards the actions whose random playouts scored best
+    };
+
+    struct SearchOptions
+    {
+        Strategy strategy = Strategy::Beam;
+        std::size_t horizon = 60;        // steps to look ahead
+        std::size_t frames_per_step = 4; // frames every step holds its keys for
+        std::size_t cpu_hz = scheduler::DEFAULT_CPU_HZ;
+        std::size_t beam_width = 64;     // states the beam search keeps per step
+        std::size_t playouts = 20000;    // playouts of the tree search
+        double exploration = 1.4;        // how strongly the tree search favours actions tried less often
+        std::vector<KeyMask> actions;    // the key combinations to choose from, no key and every single key when empty
+        std::size_t threads = 0;         // 0 picks one per hardware thread
+        utils::Engine engine = utils::Engine::Cached;
+        std::uint64_t seed = interpreter::DEFAULT_SEED;
+        std::optional<utils::Platform> platform; // the one the ROM's analysis found when not given
+    };
+
+    struct SearchResult
+    {
+        std::vector<KeyMask> inputs; // the best sequence found, one entry per step
+        double score = 0.0;          // of the machine after the last step
+        std::uint64_t frames = 0;    // emulated by all workers together
+        double seconds = 0.0;
+        std::size_t steals = 0;      // tasks that ran on another worker than the one they were queued on
+    };
+
+    /**
+     * @brief Read a byte of a state's memory, wrapping around its address space like the machine does
+     */
+    std::uint8_t peek(const interpreter::MachineState &state, const std::size_t address);
+
+    /**
+     * @brief A scorer reading a big-endian unsigned number from memory, such as a game's score or distance
+     * @param address Where the number starts
+     * @param bytes Its size, 1 to 8
+     */
+    Scorer scoreAt(const std::size_t address, const std::size_t bytes = 1);
+
+    /**
+     * @brief Look for the key sequence that leaves a ROM with the highest score after a number of steps
+     * @details Every step holds a set of keys down for frames_per_step frames, starting from a freshly loaded
+     * machine at frame 0. States are branched with Chip8::fork, so trying a move costs its frames and the pages
+     * it writes, and the work is spread over a work-stealing pool with a machine per worker
+     * @param rom The ROM to play
+     * @param score Rates the machine after a step
+     * @param options The strategy and its limits
+     * @return The best sequence, or nothing if the ROM could not be loaded
+     */
+    std::optional<SearchResult> search(const rom::RomImage &rom, const Scorer &score, const SearchOptions &options, utils::Messenger &messenger);
+
+    /**
+     * @brief Turn a key sequence into an input log that chip8_emulator --replay and chip8_headless --replay play back
+     * @details The sequence is run once more to record screen hashes, rom_path is left for the caller to fill in
+     */
+    std::optional<replay::InputLog> recordSession(const rom::RomImage &rom, const std::vector<KeyMask> &inputs, const SearchOptions &options, utils::Messenger &messenger);
+
+} // namespace emulator::search
@@ -0,0 +1,192 @@
+#include "shared_frame.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace emulator::share
+{
+    std::optional<SharedFrameWriter> SharedFrameWriter::create(const std::string &name)
+    {
+        // a segment left behind by a crashed run is dropped, readers still mapping it keep their copy
+        ::shm_unlink(name.c_str());
+        const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return std::nullopt;
+        }
+        if (::ftruncate(fd, sizeof(SharedFrameSegment)) != 0)
+        {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            return std::nullopt;
+        }
+        void *data = ::mmap(nullptr, sizeof(SharedFrameSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            ::shm_unlink(name.c_str());
+            return std::nullopt;
+        }
+        // the segment starts out zeroed, only the sequence needs constructing; the magic goes in last so a reader
+        // attaching early sees no segment rather than a half made one
+        auto *segment = static_cast<SharedFrameSegment *>(data);
+        new (&segment->sequence) std::atomic<std::uint64_t>(0);
+        segment->version = SHARED_FRAME_VERSION;
+        std::atomic_thread_fence(std::memory_order_release);
+        segment->magic = SHARED_FRAME_MAGIC;
+        return SharedFrameWriter(name, segment);
+    }
+
+    SharedFrameWriter::SharedFrameWriter(std::string name, SharedFrameSegment *segment) : name_(std::move(name)), segment_(segment)
+    {
+    }
+
+    SharedFrameWriter::SharedFrameWriter(SharedFrameWriter &&other) noexcept
+        : name_(std::move(other.name_)), segment_(std::exchange(other.segment_, nullptr))
+    {
+    }
+
+    SharedFrameWriter &SharedFrameWriter::operator=(SharedFrameWriter &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            name_ = std::move(other.name_);
+            segment_ = std::exchange(other.segment_, nullptr);
+        }
+        return *this;
+    }
+
+    SharedFrameWriter::~SharedFrameWriter()
+    {
+        release();
+    }
+
+    void SharedFrameWriter::release()
+    {
+        if (segment_)
+        {
+            ::munmap(segment_, sizeof(SharedFrameSegment));
+            ::shm_unlink(name_.c_str());
+            segment_ = nullptr;
+        }
+    }
+
+    void SharedFrameWriter::publish(const interpreter::FrameBuffer &screen, const FrameInfo &info)
+    {
+        // only this thread writes the sequence, odd marks the frame as torn until the copy is done
+        const std::uint64_t sequence = segment_->sequence.load(std::memory_order_relaxed);
+        segment_->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(static_cast<void *>(&segment_->info), &info, sizeof(info));
+        std::memcpy(static_cast<void *>(&segment_->screen), &screen, sizeof(screen));
+        segment_->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    const std::string &SharedFrameWriter::name() const
+    {
+        return name_;
+    }
+
+    std::optional<SharedFrameReader> SharedFrameReader::attach(const std::string &name)
+    {
+        const int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            return std::nullopt;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(SharedFrameSegment))
+        {
+            ::close(fd);
+            return std::nullopt;
+        }
+        void *data = ::mmap(nullptr, sizeof(SharedFrameSegment), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            return std::nullopt;
+        }
+        SharedFrameReader reader(static_cast<const SharedFrameSegment *>(data));
+        const std::uint32_t magic = reader.segment_->magic;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (magic != SHARED_FRAME_MAGIC || reader.segment_->version != SHARED_FRAME_VERSION)
+        {
+            return std::nullopt;
+        }
+        return reader;
+    }
+
+    SharedFrameReader::SharedFrameReader(const SharedFrameSegment *segment) : segment_(segment)
+    {
+    }
+
+    SharedFrameReader::SharedFrameReader(SharedFrameReader &&other) noexcept : segment_(std::exchange(other.segment_, nullptr))
+    {
+    }
+
+    SharedFrameReader &SharedFrameReader::operator=(SharedFrameReader &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            segment_ = std::exchange(other.segment_, nullptr);
+        }
+        return *this;
+    }
+
+    SharedFrameReader::~SharedFrameReader()
+    {
+        release();
+    }
+
+    void SharedFrameReader::release()
+    {
+        if (segment_)
+        {
+            ::munmap(const_cast<SharedFrameSegment *>(segment_), sizeof(SharedFrameSegment));
+            segment_ = nullptr;
+        }
+    }
+
+    std::uint64_t SharedFrameReader::sequence() const
+    {
+        // two steps per frame, halving rounds a frame in progress down to the one before it
+        return segment_->sequence.load(std::memory_order_acquire) / 2;
+    }
+
+    std::uint64_t SharedFrameReader::read(interpreter::FrameBuffer &screen, FrameInfo &info) const
+    {
+        while (true)
+        {
+            const std::uint64_t before = segment_->sequence.load(std::memory_order_acquire);
+            if (before == 0)
+            {
+                return 0;
+            }
+            if (before % 2 != 0)
+            {
+                continue;
+            }
+            std::memcpy(&info, &segment_->info, sizeof(info));
+            std::memcpy(static_cast<void *>(&screen), &segment_->screen, sizeof(screen));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (segment_->sequence.load(std::memory_order_relaxed) == before)
+            {
+                return before / 2;
+            }
+        }
+    }
+
+    const SharedFrameSegment &SharedFrameReader::segment() const
+    {
+        return *segment_;
+    }
+
+} // namespace emulator::share
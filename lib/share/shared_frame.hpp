@@ -0,0 +1,119 @@
+#pragma once
+
+#include "common.hpp"
+#include "framebuffer.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace emulator::share
+{
+    // "C8FR", the first word of every segment
+    static constexpr std::uint32_t SHARED_FRAME_MAGIC = 0x52463843;
+    // bumped whenever the segment layout changes, readers refuse segments of another version
+    static constexpr std::uint32_t SHARED_FRAME_VERSION = 1;
+
+    // what is published next to every screen
+    struct FrameInfo
+    {
+        std::uint64_t frame;       // frames emulated so far
+        std::uint64_t screen_hash; // FNV-1a of the screen, equal for identical screens
+        double speed;              // emulated time per real time, 1 at normal speed
+        std::uint8_t platform;     // utils::Platform
+        std::uint8_t buzzing;      // the sound timer was running
+        std::uint8_t waiting_for_key;
+        std::uint8_t reserved[5]; // always zero
+    };
+
+    // the layout of the shared memory segment, mapped as is by readers in other processes
+    // sequence is odd while the writer is halfway through a frame, a reader copying the frame out retries when
+    // sequence was odd or changed while it copied; the writer never waits for readers
+    struct SharedFrameSegment
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::atomic<std::uint64_t> sequence;
+        FrameInfo info;
+        interpreter::FrameBuffer screen;
+    };
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the sequence is shared between processes");
+
+    // publishes frames into a POSIX shared memory segment, removed again when the writer goes away
+    class SharedFrameWriter
+    {
+    public:
+        /**
+         * @brief Create the segment, replacing a stale one of the same name
+         * @param name The shm_open name, a single slash followed by up to 255 characters (e.g. "/chip8")
+         * @return The writer, or nothing if the segment cannot be created or mapped
+         */
+        static std::optional<SharedFrameWriter> create(const std::string &name);
+
+        SharedFrameWriter(SharedFrameWriter &&other) noexcept;
+        SharedFrameWriter &operator=(SharedFrameWriter &&other) noexcept;
+        SharedFrameWriter(const SharedFrameWriter &) = delete;
+        SharedFrameWriter &operator=(const SharedFrameWriter &) = delete;
+        ~SharedFrameWriter();
+
+        /**
+         * @brief Copy a finished frame and its stats into the segment
+         */
+        void publish(const interpreter::FrameBuffer &screen, const FrameInfo &info);
+
+        const std::string &name() const;
+
+    private:
+        SharedFrameWriter(std::string name, SharedFrameSegment *segment);
+        void release();
+
+    private:
+        std::string name_;
+        SharedFrameSegment *segment_ = nullptr;
+    };
+
+    // attaches to a segment published by a SharedFrameWriter, read-only
+    class SharedFrameReader
+    {
+    public:
+        /**
+         * @brief Map an existing segment
+         * @param name The name the writer was created with
+         * @return The reader, or nothing if there is no such segment or it has another layout
+         */
+        static std::optional<SharedFrameReader> attach(const std::string &name);
+
+        SharedFrameReader(SharedFrameReader &&other) noexcept;
+        SharedFrameReader &operator=(SharedFrameReader &&other) noexcept;
+        SharedFrameReader(const SharedFrameReader &) = delete;
+        SharedFrameReader &operator=(const SharedFrameReader &) = delete;
+        ~SharedFrameReader();
+
+        /**
+         * @brief Sequence number of the newest complete frame, cheap enough to poll for new frames
+         * @return 0 until the first frame is published
+         */
+        std::uint64_t sequence() const;
+
+        /**
+         * @brief Copy the newest complete frame out, retrying while the writer is in the middle of one
+         * @return Its sequence number, 0 (with screen and info left alone) until the first frame is published
+         */
+        std::uint64_t read(interpreter::FrameBuffer &screen, FrameInfo &info) const;
+
+        /**
+         * @brief The mapped segment, for readers that look at a frame in place and check sequence themselves
+         */
+        const SharedFrameSegment &segment() const;
+
+    private:
+        explicit SharedFrameReader(const SharedFrameSegment *segment);
+        void release();
+
+    private:
+        const SharedFrameSegment *segment_ = nullptr;
+    };
+
+} // namespace emulator::share
@@ -18,4 +18,20 @@ namespace emulator::utils
         Success,
         Failure
     };
+
+    // how the interpreter executes instructions
+    enum class Engine
+    {
+        Switch, // decode every instruction as it is fetched
+        Cached, // dispatch through a table of pre-decoded instructions
+        Jit     // run basic blocks translated to native code, falls back to Cached where unsupported
+    };
+
+    // the machine a program was written for, each one extends the previous
+    enum class Platform : std::uint8_t
+    {
+        Chip8,
+        SuperChip, // 128x64 high resolution, scrolling and 16x16 sprites
+        XoChip     // SUPER-CHIP plus 64K of memory, two bit-planes and an audio pattern buffer
+    };
 } // namespace emulator::utils
\ No newline at end of file
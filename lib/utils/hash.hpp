@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace emulator::utils
+{
+    static constexpr std::uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325ULL;
+    static constexpr std::uint64_t FNV_PRIME = 0x100000001B3ULL;
+
+    /**
+     * @brief Hash a block of bytes with 64-bit FNV-1a
+     * @param data The bytes to hash
+     * @param size The number of bytes to hash
+     * @param hash The hash to continue from, allows hashing several blocks as one
+     */
+    inline std::uint64_t fnv1a(const void *data, std::size_t size, std::uint64_t hash = FNV_OFFSET_BASIS)
+    {
+        const auto *bytes = static_cast<const std::uint8_t *>(data);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    namespace detail
+    {
+        static constexpr std::uint64_t XXH_PRIME_1 = 0x9E3779B185EBCA87ULL;
+        static constexpr std::uint64_t XXH_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+        static constexpr std::uint64_t XXH_PRIME_3 = 0x165667B19E3779F9ULL;
+        static constexpr std::uint64_t XXH_PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+        static constexpr std::uint64_t XXH_PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+        inline std::uint64_t rotl(const std::uint64_t value, const int bits)
+        {
+            return (value << bits) | (value >> (64 - bits));
+        }
+
+        inline std::uint64_t read64(const std::uint8_t *bytes)
+        {
+            std::uint64_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+
+        inline std::uint32_t read32(const std::uint8_t *bytes)
+        {
+            std::uint32_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+
+        inline std::uint64_t xxhRound(std::uint64_t accumulator, const std::uint64_t input)
+        {
+            accumulator += input * XXH_PRIME_2;
+            return rotl(accumulator, 31) * XXH_PRIME_1;
+        }
+
+        inline std::uint64_t xxhMerge(const std::uint64_t hash, const std::uint64_t accumulator)
+        {
+            return (hash ^ xxhRound(0, accumulator)) * XXH_PRIME_1 + XXH_PRIME_4;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Hash a block of bytes with XXH64, much faster than FNV-1a on anything longer than a few bytes
+     * @details Reads input as little-endian words, hashes are only comparable between little-endian hosts
+     * @param data The bytes to hash
+     * @param size The number of bytes to hash
+     * @param seed Different seeds give unrelated hashes of the same bytes
+     */
+    inline std::uint64_t xxh64(const void *data, const std::size_t size, const std::uint64_t seed = 0)
+    {
+        using namespace detail;
+        const auto *bytes = static_cast<const std::uint8_t *>(data);
+        const std::uint8_t *const end = bytes + size;
+        std::uint64_t hash;
+        if (size >= 32)
+        {
+            // four independent lanes over 32-byte stripes
+            std::uint64_t lanes[4] = {seed + XXH_PRIME_1 + XXH_PRIME_2, seed + XXH_PRIME_2, seed, seed - XXH_PRIME_1};
+            for (; bytes + 32 <= end; bytes += 32)
+            {
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    lanes[lane] = xxhRound(lanes[lane], read64(bytes + 8 * lane));
+                }
+            }
+            hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+            for (const std::uint64_t lane : lanes)
+            {
+                hash = xxhMerge(hash, lane);
+            }
+        }
+        else
+        {
+            hash = seed + XXH_PRIME_5;
+        }
+        hash += size;
+        for (; bytes + 8 <= end; bytes += 8)
+        {
+            hash = rotl(hash ^ xxhRound(0, read64(bytes)), 27) * XXH_PRIME_1 + XXH_PRIME_4;
+        }
+        if (bytes + 4 <= end)
+        {
+            hash = rotl(hash ^ (read32(bytes) * XXH_PRIME_1), 23) * XXH_PRIME_2 + XXH_PRIME_3;
+            bytes += 4;
+        }
+        for (; bytes < end; ++bytes)
+        {
+            hash = rotl(hash ^ (*bytes * XXH_PRIME_5), 11) * XXH_PRIME_1;
+        }
+        // final avalanche
+        hash ^= hash >> 33;
+        hash *= XXH_PRIME_2;
+        hash ^= hash >> 29;
+        hash *= XXH_PRIME_3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+} // namespace emulator::utils
\ No newline at end of file
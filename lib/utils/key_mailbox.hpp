@@ -0,0 +1,144 @@
+#pragma once
+
+#include "spsc_ring.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace emulator::utils
+{
+    // a Chip8 key going down or up, stamped with the time the window thread saw it
+    struct InputEvent
+    {
+        std::chrono::steady_clock::time_point time;
+        std::uint8_t key;
+        bool pressed;
+    };
+
+    // hands key presses and releases, the rewind key state and the fast forward toggle from the window thread over to the emulation thread
+    // without locking, an emulation thread with nothing to do until one of them changes can sleep on the mailbox instead of polling it
+    // keys go through a queue in the order they happened, so a press and release between two frames are both seen
+    class KeyMailbox
+    {
+    public:
+        // key events the emulation thread can fall behind by, far more than anyone types in a frame
+        static constexpr std::size_t QUEUE_EVENTS = 256;
+
+        /**
+         * @brief Queue a key press or release for the emulation thread, window thread only
+         * @param key The Chip8 key (0x0-0xF)
+         * @param pressed Whether the key went down or up
+         * @return false if the queue is full and the event was dropped
+         */
+        bool post(const std::uint8_t key, const bool pressed)
+        {
+            if (!events_.push(InputEvent{std::chrono::steady_clock::now(), static_cast<std::uint8_t>(key & 0xF), pressed}))
+            {
+                return false;
+            }
+            signal();
+            return true;
+        }
+
+        /**
+         * @brief Check if a key event is waiting to be picked up, without taking it, emulation thread only
+         */
+        bool pending() const
+        {
+            return events_.size() != 0;
+        }
+
+        /**
+         * @brief Pick up the oldest key event, emulation thread only
+         * @return false if there is none
+         */
+        bool take(InputEvent &event)
+        {
+            return events_.pop(event);
+        }
+
+        /**
+         * @brief Set whether the rewind key is held down
+         */
+        void holdRewind(const bool held)
+        {
+            // key repeats keep reporting the key as held, only a change is worth waking anyone for
+            if (rewind_.exchange(held, std::memory_order_relaxed) != held)
+            {
+                signal();
+            }
+        }
+
+        bool rewindHeld() const
+        {
+            return rewind_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Switch fast forward on or off
+         */
+        void toggleFastForward()
+        {
+            // only the window thread toggles, so load and store need not be one atomic step
+            fast_forward_.store(!fast_forward_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            signal();
+        }
+
+        bool fastForward() const
+        {
+            return fast_forward_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Count of everything posted, toggled or woken so far, read it before deciding to wait
+         */
+        std::uint64_t signals() const
+        {
+            return signals_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Sleep until the signal count moves past the one read earlier
+         * @details Returns straight away if anything happened in between, so nothing posted after the read is missed
+         * @param seen What signals returned
+         */
+        void waitForSignal(const std::uint64_t seen)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [&]
+                          { return signals_.load(std::memory_order_acquire) != seen; });
+        }
+
+        /**
+         * @brief Wake a thread sleeping in waitForSignal without posting anything, for instance to let it stop
+         */
+        void wake()
+        {
+            signal();
+        }
+
+    private:
+        void signal()
+        {
+            signals_.fetch_add(1, std::memory_order_acq_rel);
+            // taking the lock orders the notification after a waiter's last look at the count
+            {
+                const std::lock_guard<std::mutex> lock(mutex_);
+            }
+            changed_.notify_all();
+        }
+
+    private:
+        SpscRing<InputEvent> events_{QUEUE_EVENTS};
+        std::atomic<bool> rewind_{false};
+        std::atomic<bool> fast_forward_{false};
+        std::atomic<std::uint64_t> signals_{0};
+        std::mutex mutex_;
+        std::condition_variable changed_;
+    };
+
+} // namespace emulator::utils
@@ -0,0 +1,83 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace emulator::utils
+{
+    std::optional<MappedFile> MappedFile::open(const char *path)
+    {
+        const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return std::nullopt;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            ::close(fd);
+            return std::nullopt;
+        }
+        const std::size_t size = static_cast<std::size_t>(info.st_size);
+        if (size == 0)
+        {
+            // nothing to map, mmap refuses zero lengths
+            ::close(fd);
+            return MappedFile(nullptr, 0);
+        }
+        void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps the file alive on its own
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            return std::nullopt;
+        }
+        return MappedFile(static_cast<const std::uint8_t *>(data), size);
+    }
+
+    MappedFile::MappedFile(const std::uint8_t *data, const std::size_t size) : data_(data), size_(size)
+    {
+    }
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (data_)
+            {
+                ::munmap(const_cast<std::uint8_t *>(data_), size_);
+            }
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (data_)
+        {
+            ::munmap(const_cast<std::uint8_t *>(data_), size_);
+        }
+    }
+
+    const std::uint8_t *MappedFile::data() const
+    {
+        return data_;
+    }
+
+    std::size_t MappedFile::size() const
+    {
+        return size_;
+    }
+
+} // namespace emulator::utils
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace emulator::utils
+{
+    // a whole file mapped read-only into memory, unmapped when the last owner goes away
+    class MappedFile
+    {
+    public:
+        /**
+         * @brief Map a file
+         * @param path The file to map
+         * @return The mapping, or nothing if the file cannot be opened or mapped
+         */
+        static std::optional<MappedFile> open(const char *path);
+
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        ~MappedFile();
+
+        /**
+         * @brief The file contents, null for an empty file
+         */
+        const std::uint8_t *data() const;
+
+        std::size_t size() const;
+
+    private:
+        MappedFile(const std::uint8_t *data, const std::size_t size);
+
+    private:
+        const std::uint8_t *data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+} // namespace emulator::utils
@@ -1,10 +1,117 @@
 #include "messages.hpp"
 
+#include <chrono>
+
 namespace emulator::utils
 {
+    namespace
+    {
+        // the writer also wakes up on its own this often, covering a wake up that raced with it going to sleep
+        constexpr std::chrono::milliseconds WRITER_POLL{10};
+    } // namespace
+
+    Messenger::Messenger(std::ostream &out, const Level level)
+        : out_(&out), level_(level), queue_(QUEUE_CAPACITY), writer_([this]
+                                                                    { drain(); })
+    {
+    }
+
+    Messenger::~Messenger()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_.store(true, std::memory_order_release);
+        }
+        wake_.notify_one();
+        writer_.join();
+    }
+
+    void Messenger::setLevel(const Level level)
+    {
+        level_.store(level, std::memory_order_relaxed);
+    }
+
+    bool Messenger::enabled(const Level level) const
+    {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+
+    void Messenger::push(std::string &&line)
+    {
+        if (!queue_.tryPush(line))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // no lock taken here, a wake up lost to the writer just going to sleep is caught by its poll
+        wake_.notify_one();
+    }
+
+    void Messenger::flush()
+    {
+        const std::size_t target = queue_.pushed();
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.notify_one();
+        drained_.wait(lock, [&]
+                      { return written_.load(std::memory_order_acquire) >= target; });
+    }
+
+    std::ostream &Messenger::setOutput(std::ostream &out)
+    {
+        flush();
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        return *std::exchange(out_, &out);
+    }
+
+    std::size_t Messenger::outputs() const
+    {
+        return outputs_.load(std::memory_order_acquire);
+    }
+
+    void Messenger::drain()
+    {
+        std::string line;
+        std::size_t written = 0;
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> output_lock(output_mutex_);
+                bool wrote = false;
+                while (queue_.tryPop(line))
+                {
+                    *out_ << line << "\n";
+                    ++written;
+                    wrote = true;
+                }
+                if (const std::uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed); dropped > 0)
+                {
+                    *out_ << "(" << dropped << " messages dropped, the message queue was full)\n";
+                    wrote = true;
+                }
+                if (wrote)
+                {
+                    out_->flush();
+                    outputs_.fetch_add(1, std::memory_order_release);
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            written_.store(written, std::memory_order_release);
+            drained_.notify_all();
+            // only stop once everything queued before the destructor ran is out
+            if (stopping_.load(std::memory_order_acquire) && queue_.pushed() == written)
+            {
+                return;
+            }
+            wake_.wait_for(lock, WRITER_POLL, [&]
+                           { return stopping_.load(std::memory_order_acquire) || queue_.pushed() != written; });
+        }
+    }
 
     std::string Messenger::gamePrompt()
     {
+        // the prompt is interactive, everything queued before it has to be on screen first
+        flush();
         std::cout << "Welcome to my Chip8 emulator!"
                   << "\n"
                   << "Which game (or file) would you like to use today?"
@@ -18,34 +125,29 @@ namespace emulator::utils
 
     void Messenger::printUnsuccessfulLoadMessage()
     {
-        std::cout << "Error: Exiting program due to unsuccessful file load"
-                  << "\n"
-                  << "Ensure file name is correct and file is present in the files folder!"
-                  << "\n";
+        log<Level::Error>("Error: Exiting program due to unsuccessful file load"
+                          "\n"
+                          "Ensure file name is correct and file is present in the files folder!");
     }
 
     void Messenger::printUnsuccessfulGraphicsInitMessage()
     {
-        std::cout << "Error: Exiting program due to unsuccessful graphics initialisation"
-                  << "\n";
+        log<Level::Error>("Error: Exiting program due to unsuccessful graphics initialisation");
     }
 
     void Messenger::printUnsuccessfulWindowCreationMessage()
     {
-        std::cout << "Error: Exiting program due to unsuccessful window creation"
-                  << "\n";
+        log<Level::Error>("Error: Exiting program due to unsuccessful window creation");
     }
 
     void Messenger::printUnsuccessfulDrawMessage()
     {
-        std::cout << "Error: Exiting program due to unsuccessful window draw"
-                  << "\n";
+        log<Level::Error>("Error: Exiting program due to unsuccessful window draw");
     }
 
     void Messenger::printSuccessfulTerminationMessage()
     {
-        std::cout << "Successfully terminated program"
-                  << "\n";
+        log<Level::Info>("Successfully terminated program");
     }
 
-} // namespace emulator::utils
\ No newline at end of file
+} // namespace emulator::utils
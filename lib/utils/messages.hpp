@@ -1,25 +1,104 @@
 #pragma once
 
+#include "mpsc_ring.hpp"
+#include "rate_limiter.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <iostream>
-#include <utility>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
+
+// messages below this level are compiled out entirely, 0 keeps debug messages, 1 (the default) starts at info
+#ifndef CHIP8_LOG_LEVEL
+#define CHIP8_LOG_LEVEL 1
+#endif
 
 namespace emulator::utils
 {
+    enum class Level
+    {
+        Debug,
+        Info,
+        Warning,
+        Error
+    };
+
+    static constexpr Level COMPILED_LEVEL = static_cast<Level>(CHIP8_LOG_LEVEL);
+
+    // messages are formatted by the caller and queued, a background thread does the actual writing,
+    // so printing from the emulation thread never waits on the console
     class Messenger
     {
     public:
-        Messenger() = default;
-        ~Messenger() = default;
+        // messages that can wait to be written, more than this and new ones are dropped
+        static constexpr std::size_t QUEUE_CAPACITY = 1024;
+
+        /**
+         * @param out Where messages are written
+         * @param level Messages below this level are discarded
+         */
+        explicit Messenger(std::ostream &out = std::cout, const Level level = Level::Info);
 
         /**
-         * @brief Print a message to the console
+         * @brief Write every queued message before returning
+         */
+        ~Messenger();
+
+        Messenger(const Messenger &) = delete;
+        Messenger &operator=(const Messenger &) = delete;
+
+        /**
+         * @brief Change the lowest level written from now on, levels compiled out stay out
+         */
+        void setLevel(const Level level);
+
+        /**
+         * @brief Queue a message made of all arguments streamed one after the other
+         * @details Messages below CHIP8_LOG_LEVEL cost nothing, not even the formatting
+         * @param args The parts of the message
+         */
+        template <Level level, typename... Args>
+        void log(Args &&...args);
+
+        /**
+         * @brief Queue a message unless the limiter says too many went out recently
+         * @details Once messages get through again, the number that did not is appended
+         * @param limiter The limiter of this call site
+         * @param args The parts of the message
+         */
+        template <Level level, typename... Args>
+        void log(RateLimiter &limiter, Args &&...args);
+
+        /**
+         * @brief Print an info message to the console
          * @param arg The first argument to print
          * @param args The rest of the arguments to print
          */
         template <typename Arg, typename... Args>
         void printMessage(Arg &&arg, Args &&...args);
 
+        /**
+         * @brief Wait until every message queued so far has been written
+         */
+        void flush();
+
+        /**
+         * @brief Write every queued message, then send the ones after them somewhere else
+         * @param out Where messages are written from now on
+         * @return Where they were written until now
+         */
+        std::ostream &setOutput(std::ostream &out);
+
+        /**
+         * @brief How many times the writer has put something out, it only changes when the output did
+         */
+        std::size_t outputs() const;
+
         /**
          * @brief Prompt the user to enter a game to load
          * @return The name of the game to load
@@ -50,14 +129,79 @@ namespace emulator::utils
          * @brief Print a message to the console when the window is closed
          */
         void printSuccessfulTerminationMessage();
+
+    private:
+        /**
+         * @brief Check the runtime level, the compile-time one is checked by the callers
+         */
+        bool enabled(const Level level) const;
+
+        /**
+         * @brief Hand a finished line to the writer thread, dropping it if the queue is full
+         */
+        void push(std::string &&line);
+
+        /**
+         * @brief Body of the writer thread
+         */
+        void drain();
+
+    private:
+        std::ostream *out_;
+        // held by the writer while it writes, so the output is never swapped halfway through
+        std::mutex output_mutex_;
+        std::atomic<Level> level_;
+        MpscRing<std::string> queue_;
+        // messages written so far, flush waits for this to catch up with the queue
+        std::atomic<std::size_t> written_{0};
+        std::atomic<std::size_t> outputs_{0};
+        // messages that did not fit in the queue since the writer last reported them
+        std::atomic<std::uint64_t> dropped_{0};
+        std::atomic<bool> stopping_{false};
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable drained_;
+        std::thread writer_;
     };
 
+    template <Level level, typename... Args>
+    void Messenger::log(Args &&...args)
+    {
+        if constexpr (level >= COMPILED_LEVEL)
+        {
+            if (!enabled(level))
+            {
+                return;
+            }
+            std::ostringstream line;
+            ((line << std::forward<Args>(args)), ...);
+            push(line.str());
+        }
+    }
+
+    template <Level level, typename... Args>
+    void Messenger::log(RateLimiter &limiter, Args &&...args)
+    {
+        if constexpr (level >= COMPILED_LEVEL)
+        {
+            if (!enabled(level) || !limiter.admit())
+            {
+                return;
+            }
+            std::ostringstream line;
+            ((line << std::forward<Args>(args)), ...);
+            if (const std::uint64_t suppressed = limiter.takeSuppressed(); suppressed > 0)
+            {
+                line << " (" << suppressed << " more suppressed)";
+            }
+            push(line.str());
+        }
+    }
+
     template <typename Arg, typename... Args>
     void Messenger::printMessage(Arg &&arg, Args &&...args)
     {
-        std::cout << std::forward<Arg>(arg);
-        ((std::cout << std::forward<Args>(args)), ...);
-        std::cout << "\n";
+        log<Level::Info>(std::forward<Arg>(arg), std::forward<Args>(args)...);
     }
 
-} // namespace emulator::utils
\ No newline at end of file
+} // namespace emulator::utils
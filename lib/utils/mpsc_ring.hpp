@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace emulator::utils
+{
+    // bounded lock-free multi producer / single consumer queue
+    // every slot carries a sequence number telling producers and the consumer whose turn it is,
+    // producers only race each other on the head index and never wait, a full ring makes push fail instead
+    template <typename T>
+    class MpscRing
+    {
+    public:
+        /**
+         * @param capacity Number of slots, rounded up to a power of two
+         */
+        explicit MpscRing(const std::size_t capacity)
+        {
+            std::size_t size = 1;
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            mask_ = size - 1;
+            slots_ = std::make_unique<Slot[]>(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscRing(const MpscRing &) = delete;
+        MpscRing &operator=(const MpscRing &) = delete;
+
+        /**
+         * @brief Append a value, safe to call from any number of threads
+         * @return false if the ring is full, the value is left untouched then
+         */
+        bool tryPush(T &value)
+        {
+            std::size_t position = head_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Slot &slot = slots_[position & mask_];
+                const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                const std::intptr_t lag = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+                if (lag == 0)
+                {
+                    // the slot is free for this position, claim it before filling it in
+                    if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        slot.value = std::move(value);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (lag < 0)
+                {
+                    // the consumer has not emptied this slot since the last lap
+                    return false;
+                }
+                else
+                {
+                    // another producer claimed the position first
+                    position = head_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief Take the oldest value out, only the single consumer thread may call this
+         * @return false if nothing has been published yet
+         */
+        bool tryPop(T &value)
+        {
+            Slot &slot = slots_[tail_ & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1)
+            {
+                return false;
+            }
+            value = std::move(slot.value);
+            // hand the slot to whichever producer reaches it on the next lap
+            slot.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+            ++tail_;
+            return true;
+        }
+
+        /**
+         * @brief How many values have been claimed by producers so far, published or not
+         */
+        std::size_t pushed() const
+        {
+            return head_.load(std::memory_order_acquire);
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<std::size_t> sequence{0};
+            T value{};
+        };
+
+        std::unique_ptr<Slot[]> slots_;
+        std::size_t mask_ = 0;
+        // producers and the consumer write different indices, keep them on different cache lines
+        alignas(64) std::atomic<std::size_t> head_{0};
+        alignas(64) std::size_t tail_ = 0;
+    };
+} // namespace emulator::utils
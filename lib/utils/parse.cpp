@@ -0,0 +1,36 @@
+#include "parse.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+
+namespace emulator::utils
+{
+    std::optional<std::size_t> parseNumber(const char *text, const int base)
+    {
+        // strtoull skips spaces and takes a minus sign, wrapping -1 around to the largest value, a digit has to come first
+        if (!std::isdigit(static_cast<unsigned char>(text[0])))
+        {
+            return std::nullopt;
+        }
+        char *end = nullptr;
+        errno = 0;
+        const unsigned long long value = std::strtoull(text, &end, base);
+        if (*end != '\0' || errno == ERANGE || value > std::numeric_limits<std::size_t>::max())
+        {
+            return std::nullopt;
+        }
+        return static_cast<std::size_t>(value);
+    }
+
+    std::optional<std::size_t> parseCount(const char *text, const int base)
+    {
+        const auto value = parseNumber(text, base);
+        if (!value || *value == 0)
+        {
+            return std::nullopt;
+        }
+        return value;
+    }
+} // namespace emulator::utils
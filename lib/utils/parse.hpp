@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+namespace emulator::utils
+{
+    /**
+     * @brief Parse a whole command line value as an unsigned number
+     * @param text The value
+     * @param base The base, 0 lets a 0x or 0 prefix pick hexadecimal or octal
+     * @return The number, or nothing for empty input, a sign, leading spaces, trailing garbage or a number too large
+     */
+    std::optional<std::size_t> parseNumber(const char *text, const int base = 10);
+
+    /**
+     * @brief Parse a whole command line value as a strictly positive number, such as a count of frames or threads
+     * @param text The value
+     * @param base The base, 0 lets a 0x or 0 prefix pick hexadecimal or octal
+     * @return The number, or nothing when parseNumber rejects the value or it is 0
+     */
+    std::optional<std::size_t> parseCount(const char *text, const int base = 10);
+} // namespace emulator::utils
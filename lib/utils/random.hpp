@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+namespace emulator::utils
+{
+    // small seedable generator for RND, one per machine so runs are reproducible and machines never share state
+    // xorshift64* with its state scrambled out of the seed by splitmix64, the whole state is a single word so it
+    // fits into snapshots and vector lanes as is
+    class Random
+    {
+    public:
+        explicit Random(const std::uint64_t seed = 0)
+        {
+            reseed(seed);
+        }
+
+        /**
+         * @brief Restart the sequence from a seed, equal seeds give equal sequences
+         */
+        void reseed(const std::uint64_t seed)
+        {
+            std::uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31;
+            // xorshift never leaves an all zero state
+            state_ = (z != 0) ? z : 0x9E3779B97F4A7C15ULL;
+        }
+
+        /**
+         * @brief Next byte of the sequence, taken from the best mixed top bits
+         */
+        std::uint8_t nextByte()
+        {
+            state_ ^= state_ >> 12;
+            state_ ^= state_ << 25;
+            state_ ^= state_ >> 27;
+            return static_cast<std::uint8_t>((state_ * 0x2545F4914F6CDD1DULL) >> 56);
+        }
+
+        /**
+         * @brief The whole generator state, for saving it alongside the machine
+         */
+        std::uint64_t state() const
+        {
+            return state_;
+        }
+
+        /**
+         * @brief Continue from a state taken with state()
+         */
+        void restore(const std::uint64_t state)
+        {
+            state_ = (state != 0) ? state : 0x9E3779B97F4A7C15ULL;
+        }
+
+    private:
+        std::uint64_t state_ = 0;
+    };
+} // namespace emulator::utils
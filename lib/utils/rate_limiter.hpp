@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace emulator::utils
+{
+    // lets a message through at most `per_second` times a second on average, with bursts of up to `burst` messages
+    // kept as a single "next allowed time" so any thread can check it with one compare-and-swap
+    class RateLimiter
+    {
+    public:
+        RateLimiter(const std::uint32_t per_second, const std::uint32_t burst = 1)
+            : interval_ns_(1'000'000'000 / std::max<std::uint32_t>(per_second, 1)),
+              tolerance_ns_(interval_ns_ * static_cast<std::int64_t>(std::max<std::uint32_t>(burst, 1)))
+        {
+        }
+
+        RateLimiter(const RateLimiter &) = delete;
+        RateLimiter &operator=(const RateLimiter &) = delete;
+
+        /**
+         * @brief Check whether a message may go out now, counting it as suppressed otherwise
+         * @return true if it may
+         */
+        bool admit()
+        {
+            const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count();
+            std::int64_t allowed = next_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                const std::int64_t next = std::max(allowed, now) + interval_ns_;
+                if (next - now > tolerance_ns_)
+                {
+                    suppressed_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                if (next_.compare_exchange_weak(allowed, next, std::memory_order_relaxed))
+                {
+                    return true;
+                }
+            }
+        }
+
+        /**
+         * @brief Number of messages turned away since the last call, resets the count
+         */
+        std::uint64_t takeSuppressed()
+        {
+            return suppressed_.exchange(0, std::memory_order_relaxed);
+        }
+
+    private:
+        const std::int64_t interval_ns_;
+        const std::int64_t tolerance_ns_;
+        std::atomic<std::int64_t> next_{0};
+        std::atomic<std::uint64_t> suppressed_{0};
+    };
+} // namespace emulator::utils
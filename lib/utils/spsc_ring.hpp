@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace emulator::utils
+{
+    // bounded lock-free single producer / single consumer queue
+    // each side only writes its own index and keeps a stale copy of the other one, so the shared cache lines
+    // are only touched when the ring looks full (producer) or empty (consumer)
+    template <typename T>
+    class SpscRing
+    {
+    public:
+        /**
+         * @param capacity Number of values the ring holds, rounded up to a power of two
+         */
+        explicit SpscRing(const std::size_t capacity)
+        {
+            std::size_t size = 1;
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            mask_ = size - 1;
+            values_ = std::make_unique<T[]>(size);
+        }
+
+        SpscRing(const SpscRing &) = delete;
+        SpscRing &operator=(const SpscRing &) = delete;
+
+        std::size_t capacity() const
+        {
+            return mask_ + 1;
+        }
+
+        /**
+         * @brief Append as many of the values as fit, producer only
+         * @return The number of values appended
+         */
+        std::size_t push(const T *values, const std::size_t count)
+        {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head - tail_cache_ + count > capacity())
+            {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+            }
+            const std::size_t accepted = std::min(count, capacity() - (head - tail_cache_));
+            for (std::size_t i = 0; i < accepted; ++i)
+            {
+                values_[(head + i) & mask_] = values[i];
+            }
+            head_.store(head + accepted, std::memory_order_release);
+            return accepted;
+        }
+
+        /**
+         * @brief Append a single value, producer only
+         * @return false if the ring is full
+         */
+        bool push(const T &value)
+        {
+            return push(&value, 1) == 1;
+        }
+
+        /**
+         * @brief The slot the next value goes in, to be filled in place and handed over with commit, producer only
+         * @details Saves copying a large value twice
+         * @return nullptr if the ring is full
+         */
+        T *claim()
+        {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head - tail_cache_ == capacity())
+            {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                if (head - tail_cache_ == capacity())
+                {
+                    return nullptr;
+                }
+            }
+            return &values_[head & mask_];
+        }
+
+        /**
+         * @brief Hand the slot returned by claim over to the consumer, producer only
+         */
+        void commit()
+        {
+            head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Take up to count of the oldest values out, consumer only
+         * @return The number of values taken
+         */
+        std::size_t pop(T *values, const std::size_t count)
+        {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (head_cache_ - tail < count)
+            {
+                head_cache_ = head_.load(std::memory_order_acquire);
+            }
+            const std::size_t taken = std::min(count, head_cache_ - tail);
+            for (std::size_t i = 0; i < taken; ++i)
+            {
+                values[i] = values_[(tail + i) & mask_];
+            }
+            tail_.store(tail + taken, std::memory_order_release);
+            return taken;
+        }
+
+        /**
+         * @brief Take the oldest value out, consumer only
+         * @return false if the ring is empty
+         */
+        bool pop(T &value)
+        {
+            return pop(&value, 1) == 1;
+        }
+
+        /**
+         * @brief Throw away up to count of the oldest values, consumer only
+         * @return The number of values thrown away
+         */
+        std::size_t discard(const std::size_t count)
+        {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            head_cache_ = head_.load(std::memory_order_acquire);
+            const std::size_t dropped = std::min(count, head_cache_ - tail);
+            tail_.store(tail + dropped, std::memory_order_release);
+            return dropped;
+        }
+
+        /**
+         * @brief Number of values waiting, only exact when asked from the consumer thread
+         */
+        std::size_t size() const
+        {
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::unique_ptr<T[]> values_;
+        std::size_t mask_ = 0;
+        // written by the producer
+        alignas(64) std::atomic<std::size_t> head_{0};
+        std::size_t tail_cache_ = 0;
+        // written by the consumer
+        alignas(64) std::atomic<std::size_t> tail_{0};
+        std::size_t head_cache_ = 0;
+    };
+} // namespace emulator::utils
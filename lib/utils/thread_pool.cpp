@@ -0,0 +1,85 @@
+#include "thread_pool.hpp"
+
+namespace emulator::utils
+{
+    ThreadPool::ThreadPool(std::size_t thread_count)
+    {
+        if (thread_count == 0)
+        {
+            thread_count = std::thread::hardware_concurrency();
+        }
+        // hardware_concurrency is allowed to return 0 when it cannot tell
+        thread_count = (thread_count == 0) ? 1 : thread_count;
+        workers_.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; ++i)
+        {
+            workers_.emplace_back([this]
+                                  { workerLoop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        task_available_.notify_all();
+        for (auto &worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push(std::move(task));
+            ++pending_;
+        }
+        task_available_.notify_one();
+    }
+
+    void ThreadPool::wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        tasks_done_.wait(lock, [this]
+                         { return pending_ == 0; });
+    }
+
+    std::size_t ThreadPool::size() const
+    {
+        return workers_.size();
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                task_available_.wait(lock, [this]
+                                     { return stopping_ || !tasks_.empty(); });
+                // finish off whatever is queued before shutting down
+                if (tasks_.empty())
+                {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --pending_;
+                if (pending_ == 0)
+                {
+                    tasks_done_.notify_all();
+                }
+            }
+        }
+    }
+
+} // namespace emulator::utils
\ No newline at end of file
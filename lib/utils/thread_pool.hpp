@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace emulator::utils
+{
+    // a fixed-size pool of worker threads pulling tasks from a shared queue
+    class ThreadPool
+    {
+    public:
+        /**
+         * @brief Spawn the worker threads
+         * @param thread_count The number of workers, 0 picks one per hardware thread
+         */
+        explicit ThreadPool(std::size_t thread_count = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * @brief Queue a task to be run on one of the workers
+         * @param task The task to run
+         */
+        void submit(std::function<void()> task);
+
+        /**
+         * @brief Block until every submitted task has finished running
+         */
+        void wait();
+
+        /**
+         * @brief Get the number of worker threads
+         */
+        std::size_t size() const;
+
+    private:
+        /**
+         * @brief Pop and run tasks until the pool is destroyed
+         */
+        void workerLoop();
+
+    private:
+        std::vector<std::thread> workers_;
+        std::queue<std::function<void()>> tasks_;
+        std::mutex mutex_;
+        std::condition_variable task_available_;
+        std::condition_variable tasks_done_;
+        // number of tasks queued or currently running
+        std::size_t pending_ = 0;
+        bool stopping_ = false;
+    };
+
+} // namespace emulator::utils
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace emulator::utils
+{
+    // lock-free single producer / single consumer triple buffer
+    // the producer always has a slot to write into and the consumer always sees the newest published one,
+    // neither side ever waits for the other; frames published faster than they are consumed are dropped
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+        TripleBuffer() = default;
+        TripleBuffer(const TripleBuffer &) = delete;
+        TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+        /**
+         * @brief The slot owned by the producer, fill it then call publish
+         */
+        T &write()
+        {
+            return slots_[write_];
+        }
+
+        /**
+         * @brief Hand the written slot over to the consumer and take back the one it left behind
+         */
+        void publish()
+        {
+            const std::uint8_t previous = shared_.exchange(write_ | FRESH, std::memory_order_acq_rel);
+            write_ = previous & INDEX_MASK;
+        }
+
+        /**
+         * @brief Pick up the newest published slot, if there is one the consumer has not seen yet
+         * @return true if read() now returns a new value
+         */
+        bool update()
+        {
+            if ((shared_.load(std::memory_order_relaxed) & FRESH) == 0)
+            {
+                return false;
+            }
+            const std::uint8_t previous = shared_.exchange(read_, std::memory_order_acq_rel);
+            read_ = previous & INDEX_MASK;
+            return true;
+        }
+
+        /**
+         * @brief Check whether the last published slot is still waiting for the consumer, producer side
+         * @details A producer with more frames than the consumer can show may skip publishing while this holds
+         */
+        bool pending() const
+        {
+            return (shared_.load(std::memory_order_relaxed) & FRESH) != 0;
+        }
+
+        /**
+         * @brief The slot owned by the consumer
+         */
+        const T &read() const
+        {
+            return slots_[read_];
+        }
+
+    private:
+        static constexpr std::uint8_t INDEX_MASK = 0x3;
+        static constexpr std::uint8_t FRESH = 0x4;
+
+        std::array<T, 3> slots_{};
+        // index of the slot in the middle, plus FRESH when it was published and not picked up yet
+        // each index only ever belongs to one side, so the slots themselves need no synchronisation
+        alignas(64) std::atomic<std::uint8_t> shared_{1};
+        alignas(64) std::uint8_t write_ = 0;
+        alignas(64) std::uint8_t read_ = 2;
+    };
+
+} // namespace emulator::utils
@@ -0,0 +1,144 @@
+#include "work_stealing_pool.hpp"
+
+namespace emulator::utils
+{
+    namespace
+    {
+        // the pool and worker index of the calling thread, a task may run on any pool
+        thread_local const WorkStealingPool *current_pool = nullptr;
+        thread_local std::size_t current_index = WorkStealingPool::NOT_A_WORKER;
+    } // namespace
+
+    WorkStealingPool::WorkStealingPool(std::size_t thread_count)
+    {
+        if (thread_count == 0)
+        {
+            thread_count = std::thread::hardware_concurrency();
+        }
+        // hardware_concurrency is allowed to return 0 when it cannot tell
+        thread_count = (thread_count == 0) ? 1 : thread_count;
+        queues_.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; ++i)
+        {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+        workers_.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; ++i)
+        {
+            workers_.emplace_back([this, i]
+                                  { workerLoop(i); });
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stopping_ = true;
+        }
+        work_available_.notify_all();
+        for (auto &worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    void WorkStealingPool::submit(std::function<void()> task)
+    {
+        const std::size_t worker = currentWorker();
+        const std::size_t index = (worker != NOT_A_WORKER) ? worker : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        queued_.fetch_add(1, std::memory_order_release);
+        // taking the lock orders the notification after a sleeping worker's last look at queued_
+        {
+            const std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        work_available_.notify_one();
+    }
+
+    void WorkStealingPool::wait()
+    {
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        tasks_done_.wait(lock, [this]
+                         { return pending_.load(std::memory_order_acquire) == 0; });
+    }
+
+    std::size_t WorkStealingPool::size() const
+    {
+        return workers_.size();
+    }
+
+    std::size_t WorkStealingPool::currentWorker() const
+    {
+        return (current_pool == this) ? current_index : NOT_A_WORKER;
+    }
+
+    std::size_t WorkStealingPool::steals() const
+    {
+        return steals_.load(std::memory_order_relaxed);
+    }
+
+    bool WorkStealingPool::take(const std::size_t index, std::function<void()> &task)
+    {
+        {
+            Queue &own = *queues_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        for (std::size_t offset = 1; offset < queues_.size(); ++offset)
+        {
+            Queue &victim = *queues_[(index + offset) % queues_.size()];
+            // a busy victim is skipped rather than waited for, there is likely another one
+            std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+            if (lock.owns_lock() && !victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkStealingPool::workerLoop(const std::size_t index)
+    {
+        current_pool = this;
+        current_index = index;
+        std::function<void()> task;
+        while (true)
+        {
+            if (take(index, task))
+            {
+                task();
+                task = nullptr;
+                if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    const std::lock_guard<std::mutex> lock(sleep_mutex_);
+                    tasks_done_.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            // finish off whatever is queued before shutting down, a task skipped by a failed try_lock is found on the next round
+            work_available_.wait(lock, [this]
+                                 { return stopping_ || queued_.load(std::memory_order_acquire) != 0; });
+            if (stopping_ && queued_.load(std::memory_order_acquire) == 0)
+            {
+                return;
+            }
+        }
+    }
+
+} // namespace emulator::utils
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace emulator::utils
+{
+    // a fixed-size pool of worker threads with a task deque each
+    // a worker runs its own newest task first and, once its deque is empty, steals the oldest task of another worker,
+    // so uneven tasks spread themselves over the pool without every submit and pop going through one shared lock
+    class WorkStealingPool
+    {
+    public:
+        // what currentWorker returns on a thread that is not one of the pool's workers
+        static constexpr std::size_t NOT_A_WORKER = static_cast<std::size_t>(-1);
+
+        /**
+         * @brief Spawn the worker threads
+         * @param thread_count The number of workers, 0 picks one per hardware thread
+         */
+        explicit WorkStealingPool(std::size_t thread_count = 0);
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool &) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        /**
+         * @brief Queue a task, on the calling worker's own deque when called from a task, spread round-robin otherwise
+         * @param task The task to run
+         */
+        void submit(std::function<void()> task);
+
+        /**
+         * @brief Block until every submitted task, and every task those submitted, has finished running
+         */
+        void wait();
+
+        /**
+         * @brief Get the number of worker threads
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief The index of the worker running the calling task, below size(), for per-worker scratch state
+         * @return NOT_A_WORKER when not called from one of this pool's tasks
+         */
+        std::size_t currentWorker() const;
+
+        /**
+         * @brief The number of tasks that ran on another worker than the one they were queued on
+         */
+        std::size_t steals() const;
+
+    private:
+        struct alignas(64) Queue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        /**
+         * @brief Run tasks, own ones first, until the pool is destroyed
+         */
+        void workerLoop(const std::size_t index);
+
+        /**
+         * @brief Take the newest task of the worker's own deque, or else the oldest one of the next worker that has any
+         */
+        bool take(const std::size_t index, std::function<void()> &task);
+
+    private:
+        std::vector<std::unique_ptr<Queue>> queues_;
+        std::vector<std::thread> workers_;
+        // tasks sitting in a deque, and tasks queued or running
+        std::atomic<std::size_t> queued_{0};
+        std::atomic<std::size_t> pending_{0};
+        std::atomic<std::size_t> next_queue_{0};
+        std::atomic<std::size_t> steals_{0};
+        // idle workers and wait() sleep on these
+        std::mutex sleep_mutex_;
+        std::condition_variable work_available_;
+        std::condition_variable tasks_done_;
+        bool stopping_ = false;
+    };
+
+} // namespace emulator::utils
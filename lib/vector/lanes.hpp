@@ -0,0 +1,363 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// masked element-wise kernels over structure-of-arrays lanes
+// a mask byte is 0xFF for a lane taking part and 0 otherwise, lanes outside the mask are never written
+// every array must hold a multiple of WIDTH elements
+namespace emulator::vector::lanes
+{
+  // byte lanes per register, arrays are padded to this
+  static constexpr std::size_t WIDTH = 32;
+
+#if defined(__AVX2__)
+  using Bytes = __m256i; // 32 byte lanes
+  using Words = __m256i; // 16 word lanes
+
+  inline __m256i load(const void *p)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+
+  inline void store(void *p, const __m256i v)
+  {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+
+  inline Words widen(const std::uint8_t *p)
+  {
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+  }
+
+  inline Words widenMask(const std::uint8_t *p)
+  {
+    return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+  }
+#endif
+
+  /**
+   * @brief dst = op(a, b) on the masked byte lanes
+   * @param op Callable on a single lane, and on 32 lanes at once when built with AVX2
+   */
+  template <typename Op>
+  void map8(std::uint8_t *dst, const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *mask, const std::size_t n, const Op op)
+  {
+#if defined(__AVX2__)
+    for (std::size_t i = 0; i < n; i += WIDTH)
+    {
+      const Bytes m = load(mask + i);
+      if (_mm256_testz_si256(m, m))
+      {
+        continue;
+      }
+      const Bytes result = op(load(a + i), load(b + i));
+      store(dst + i, _mm256_blendv_epi8(load(dst + i), result, m));
+    }
+#else
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (mask[i])
+      {
+        dst[i] = op(a[i], b[i]);
+      }
+    }
+#endif
+  }
+
+  /**
+   * @brief dst = op(dst, src) on the masked word lanes, src bytes are zero-extended to 16 bits
+   */
+  template <typename Op>
+  void map16(std::uint16_t *dst, const std::uint8_t *src, const std::uint8_t *mask, const std::size_t n, const Op op)
+  {
+#if defined(__AVX2__)
+    for (std::size_t i = 0; i < n; i += WIDTH / 2)
+    {
+      const Words m = widenMask(mask + i);
+      if (_mm256_testz_si256(m, m))
+      {
+        continue;
+      }
+      const Words current = load(dst + i);
+      store(dst + i, _mm256_blendv_epi8(current, op(current, widen(src + i)), m));
+    }
+#else
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      if (mask[i])
+      {
+        dst[i] = op(dst[i], src[i]);
+      }
+    }
+#endif
+  }
+
+  /**
+   * @brief Select the lanes of pending whose opcode matches, and take them out of pending
+   * @return true if at least one lane matched
+   */
+  inline bool group(std::uint8_t *mask, std::uint8_t *pending, const std::uint8_t *high, const std::uint8_t *low,
+                    const std::uint8_t opcode_high, const std::uint8_t opcode_low, const std::size_t n)
+  {
+    bool any = false;
+#if defined(__AVX2__)
+    const Bytes want_high = _mm256_set1_epi8(static_cast<char>(opcode_high));
+    const Bytes want_low = _mm256_set1_epi8(static_cast<char>(opcode_low));
+    for (std::size_t i = 0; i < n; i += WIDTH)
+    {
+      const Bytes open = load(pending + i);
+      const Bytes match = _mm256_and_si256(open, _mm256_and_si256(_mm256_cmpeq_epi8(load(high + i), want_high),
+                                                                  _mm256_cmpeq_epi8(load(low + i), want_low)));
+      store(mask + i, match);
+      store(pending + i, _mm256_andnot_si256(match, open));
+      any |= !_mm256_testz_si256(match, match);
+    }
+#else
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const bool match = pending[i] && high[i] == opcode_high && low[i] == opcode_low;
+      mask[i] = match ? 0xFF : 0;
+      pending[i] = match ? 0 : pending[i];
+      any |= match;
+    }
+#endif
+    return any;
+  }
+
+  /**
+   * @brief Find the first non-zero byte lane at or after from
+   * @return The lane index, or n if there is none
+   */
+  inline std::size_t findNext(const std::uint8_t *values, std::size_t from, const std::size_t n)
+  {
+#if defined(__AVX2__)
+    // finish the register from is in one lane at a time, then test whole registers
+    for (; from < n && from % WIDTH != 0; ++from)
+    {
+      if (values[from])
+      {
+        return from;
+      }
+    }
+    for (; from < n; from += WIDTH)
+    {
+      const Bytes v = load(values + from);
+      const auto zero = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256())));
+      if (zero != 0xFFFFFFFFu)
+      {
+        return from + __builtin_ctz(~zero);
+      }
+    }
+    return n;
+#else
+    for (; from < n; ++from)
+    {
+      if (values[from])
+      {
+        return from;
+      }
+    }
+    return n;
+#endif
+  }
+
+  /**
+   * @brief Count every non-zero byte lane down by one
+   */
+  inline void decrement(std::uint8_t *values, const std::size_t n)
+  {
+#if defined(__AVX2__)
+    const Bytes one = _mm256_set1_epi8(1);
+    for (std::size_t i = 0; i < n; i += WIDTH)
+    {
+      store(values + i, _mm256_subs_epu8(load(values + i), one));
+    }
+#else
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      values[i] -= (values[i] > 0) ? 1 : 0;
+    }
+#endif
+  }
+
+#if defined(__AVX2__)
+#define CHIP8_LANES_VECTOR(params, body) \
+  __m256i operator() params const { body }
+#else
+#define CHIP8_LANES_VECTOR(params, body)
+#endif
+
+  // byte operations, each both on one lane and on a whole register
+
+  struct SetImmediate
+  {
+    std::uint8_t value;
+    std::uint8_t operator()(std::uint8_t, std::uint8_t) const { return value; }
+    CHIP8_LANES_VECTOR((__m256i, __m256i), return _mm256_set1_epi8(static_cast<char>(value));)
+  };
+
+  struct AddImmediate
+  {
+    std::uint8_t value;
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t) const { return a + value; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i), return _mm256_add_epi8(a, _mm256_set1_epi8(static_cast<char>(value)));)
+  };
+
+  struct Copy
+  {
+    std::uint8_t operator()(std::uint8_t, std::uint8_t b) const { return b; }
+    CHIP8_LANES_VECTOR((__m256i, __m256i b), return b;)
+  };
+
+  struct Or
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t b) const { return a | b; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b), return _mm256_or_si256(a, b);)
+  };
+
+  struct And
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t b) const { return a & b; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b), return _mm256_and_si256(a, b);)
+  };
+
+  struct Xor
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t b) const { return a ^ b; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b), return _mm256_xor_si256(a, b);)
+  };
+
+  struct Add
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t b) const { return a + b; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b), return _mm256_add_epi8(a, b);)
+  };
+
+  struct Subtract
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t b) const { return a - b; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b), return _mm256_sub_epi8(a, b);)
+  };
+
+  struct ReverseSubtract
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t b) const { return b - a; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b), return _mm256_sub_epi8(b, a);)
+  };
+
+  // 1 if a + b does not fit in a byte
+  struct Carry
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t b) const { return (b > (0xFF - a)) ? 1 : 0; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b),
+                       const __m256i sum = _mm256_add_epi8(a, b);
+                       const __m256i no_carry = _mm256_cmpeq_epi8(_mm256_max_epu8(sum, a), sum);
+                       return _mm256_andnot_si256(no_carry, _mm256_set1_epi8(1));)
+  };
+
+  // 1 if a - b does not borrow
+  struct NoBorrow
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t b) const { return (b > a) ? 0 : 1; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b),
+                       return _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(a, b), a), _mm256_set1_epi8(1));)
+  };
+
+  struct LowBit
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t) const { return a & 0x1; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i), return _mm256_and_si256(a, _mm256_set1_epi8(1));)
+  };
+
+  struct HighBit
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t) const { return a >> 7; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i), return _mm256_and_si256(_mm256_srli_epi16(a, 7), _mm256_set1_epi8(1));)
+  };
+
+  struct ShiftRight
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t) const { return a >> 1; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i), return _mm256_and_si256(_mm256_srli_epi16(a, 1), _mm256_set1_epi8(0x7F));)
+  };
+
+  struct ShiftLeft
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t) const { return a << 1; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i), return _mm256_add_epi8(a, a);)
+  };
+
+  // comparisons give 1 when true and 0 when false
+
+  struct EqualImmediate
+  {
+    std::uint8_t value;
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t) const { return (a == value) ? 1 : 0; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i),
+                       return _mm256_and_si256(_mm256_cmpeq_epi8(a, _mm256_set1_epi8(static_cast<char>(value))), _mm256_set1_epi8(1));)
+  };
+
+  struct NotEqualImmediate
+  {
+    std::uint8_t value;
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t) const { return (a != value) ? 1 : 0; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i),
+                       return _mm256_andnot_si256(_mm256_cmpeq_epi8(a, _mm256_set1_epi8(static_cast<char>(value))), _mm256_set1_epi8(1));)
+  };
+
+  struct Equal
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t b) const { return (a == b) ? 1 : 0; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b), return _mm256_and_si256(_mm256_cmpeq_epi8(a, b), _mm256_set1_epi8(1));)
+  };
+
+  struct NotEqual
+  {
+    std::uint8_t operator()(std::uint8_t a, std::uint8_t b) const { return (a != b) ? 1 : 0; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b), return _mm256_andnot_si256(_mm256_cmpeq_epi8(a, b), _mm256_set1_epi8(1));)
+  };
+
+  // word operations for pc and I, the second operand is a zero-extended byte lane
+
+  struct Assign16
+  {
+    std::uint16_t value;
+    std::uint16_t operator()(std::uint16_t, std::uint8_t) const { return value; }
+    CHIP8_LANES_VECTOR((__m256i, __m256i), return _mm256_set1_epi16(static_cast<short>(value));)
+  };
+
+  struct AddImmediate16
+  {
+    std::uint16_t value;
+    std::uint16_t operator()(std::uint16_t a, std::uint8_t) const { return a + value; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i), return _mm256_add_epi16(a, _mm256_set1_epi16(static_cast<short>(value)));)
+  };
+
+  struct Add16
+  {
+    std::uint16_t operator()(std::uint16_t a, std::uint8_t b) const { return a + b; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b), return _mm256_add_epi16(a, b);)
+  };
+
+  // skip the next instruction where the condition byte is 1
+  struct Skip
+  {
+    std::uint16_t operator()(std::uint16_t a, std::uint8_t b) const { return a + b * 2; }
+    CHIP8_LANES_VECTOR((__m256i a, __m256i b), return _mm256_add_epi16(a, _mm256_slli_epi16(b, 1));)
+  };
+
+  // address of the font sprite for a digit
+  struct Font
+  {
+    std::uint16_t operator()(std::uint16_t, std::uint8_t b) const { return b * 5; }
+    CHIP8_LANES_VECTOR((__m256i, __m256i b), return _mm256_mullo_epi16(b, _mm256_set1_epi16(5));)
+  };
+
+#undef CHIP8_LANES_VECTOR
+
+} // namespace emulator::vector::lanes
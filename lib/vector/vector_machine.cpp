@@ -0,0 +1,487 @@
+#include "vector_machine.hpp"
+#include "lanes.hpp"
+
+#include <cstring>
+
+namespace emulator::vector
+{
+  namespace
+  {
+    // lanes run CHIP-8 programs, which only ever see the first 4K of a machine's memory
+    constexpr std::size_t MEMORY_SIZE = interpreter::CHIP8_MEMORY_SIZE;
+
+    // past this many opcode groups in one cycle the lanes are too divergent for kernels to pay off, the rest run one by one
+    constexpr std::size_t MAX_GROUPS = 8;
+
+    // instances share the same pcs most of the time, back to back 4K address spaces would put all of those
+    // fetches into the same cache set, so every address space is shifted by one more cache line than the last
+    constexpr std::size_t MEMORY_STRIDE = MEMORY_SIZE + 64;
+
+    std::size_t padded(const std::size_t count)
+    {
+      return (count + lanes::WIDTH - 1) / lanes::WIDTH * lanes::WIDTH;
+    }
+  } // namespace
+
+  VectorMachine::VectorMachine(const std::size_t instances)
+      : count_(instances), stride_(padded(instances)),
+        V_(16 * stride_), I_(stride_), pc_(stride_), sp_(stride_), stack_(16 * stride_),
+        delay_timer_(stride_), sound_timer_(stride_), random_(stride_), keyboard_(16 * stride_), memory_(instances * MEMORY_STRIDE),
+        screens_(instances), draw_(stride_), opcode_high_(stride_), opcode_low_(stride_), running_(stride_),
+        pending_(stride_), mask_(stride_), condition_(stride_)
+  {
+    interpreter::Snapshot blank{};
+    blank.pc = 0x200;
+    blank.random_state = utils::Random(interpreter::DEFAULT_SEED).state();
+    load(blank);
+  }
+
+  std::size_t VectorMachine::size() const
+  {
+    return count_;
+  }
+
+  void VectorMachine::load(const interpreter::Snapshot &state)
+  {
+    for (std::size_t lane = 0; lane < count_; ++lane)
+    {
+      load(lane, state);
+    }
+  }
+
+  void VectorMachine::load(const std::size_t lane, const interpreter::Snapshot &state)
+  {
+    std::memcpy(memory(lane), state.memory, MEMORY_SIZE);
+    for (std::size_t x = 0; x < 16; ++x)
+    {
+      reg(x)[lane] = state.V[x];
+      stack_[x * stride_ + lane] = state.stack[x];
+      keyboard_[x * stride_ + lane] = 0;
+    }
+    I_[lane] = state.I;
+    pc_[lane] = state.pc;
+    sp_[lane] = static_cast<std::uint8_t>(state.sp);
+    delay_timer_[lane] = state.delay_timer;
+    sound_timer_[lane] = state.sound_timer;
+    random_[lane].restore(state.random_state);
+    screens_[lane] = state.screen;
+    draw_[lane] = 0;
+    running_[lane] = 0xFF;
+  }
+
+  void VectorMachine::saveState(const std::size_t lane, interpreter::Snapshot &state) const
+  {
+    std::memcpy(state.memory, memory_.data() + lane * MEMORY_STRIDE, MEMORY_SIZE);
+    std::memset(state.memory + MEMORY_SIZE, 0, sizeof(state.memory) - MEMORY_SIZE);
+    for (std::size_t x = 0; x < 16; ++x)
+    {
+      state.V[x] = V_[x * stride_ + lane];
+      state.stack[x] = stack_[x * stride_ + lane];
+    }
+    state.I = I_[lane];
+    state.pc = pc_[lane];
+    state.sp = sp_[lane];
+    state.delay_timer = delay_timer_[lane];
+    state.sound_timer = sound_timer_[lane];
+    state.random_state = random_[lane].state();
+    state.screen = screens_[lane];
+    // none of the later machines' state is used, leave it as a freshly started Chip8 has it
+    std::memset(state.flags, 0, sizeof(state.flags));
+    std::memset(state.audio_pattern, 0, sizeof(state.audio_pattern));
+    state.planes = 0x1;
+    state.pitch = 64;
+    state.pattern_loaded = 0;
+    std::memset(state.reserved, 0, sizeof(state.reserved));
+  }
+
+  void VectorMachine::seed(const std::size_t lane, const std::uint64_t seed)
+  {
+    random_[lane].reseed(seed);
+  }
+
+  const std::vector<interpreter::FrameBuffer> &VectorMachine::step(const std::size_t cycles)
+  {
+    const std::size_t n = stride_;
+    for (std::size_t cycle = 0; cycle < cycles; ++cycle)
+    {
+      if (lanes::findNext(running_.data(), 0, n) == n)
+      {
+        break;
+      }
+      // fetch is a gather from every instance's own memory, AVX2 gathers lose to plain loads here
+      for (std::size_t lane = 0; lane < count_; ++lane)
+      {
+        const std::uint8_t *bytes = memory(lane);
+        const std::uint16_t pc = pc_[lane];
+        opcode_high_[lane] = bytes[pc & (MEMORY_SIZE - 1)];
+        opcode_low_[lane] = bytes[(pc + 1) & (MEMORY_SIZE - 1)];
+      }
+      lanes::map16(pc_.data(), running_.data(), running_.data(), n, lanes::AddImmediate16{2});
+      std::memcpy(pending_.data(), running_.data(), n);
+
+      // the first lane still pending leads the next group, every pending lane running the same opcode joins it
+      std::size_t groups = 0;
+      for (std::size_t lead = lanes::findNext(pending_.data(), 0, n); lead < n; lead = lanes::findNext(pending_.data(), lead, n))
+      {
+        const std::uint16_t opcode = opcode_high_[lead] << 8 | opcode_low_[lead];
+        if (groups < MAX_GROUPS)
+        {
+          lanes::group(mask_.data(), pending_.data(), opcode_high_.data(), opcode_low_.data(), opcode_high_[lead], opcode_low_[lead], n);
+          ++groups;
+          if (!executeGroup(opcode))
+          {
+            // no kernel for this opcode, the lanes of the group run it one by one
+            for (std::size_t lane = lead; lane < n; lane = lanes::findNext(mask_.data(), lane + 1, n))
+            {
+              executeLane(lane, opcode);
+            }
+          }
+          continue;
+        }
+        pending_[lead] = 0;
+        executeLane(lead, opcode);
+      }
+    }
+    return screens_;
+  }
+
+  bool VectorMachine::executeGroup(const std::uint16_t opcode)
+  {
+    const std::size_t n = stride_;
+    const std::uint8_t *m = mask_.data();
+    std::uint8_t *vx = reg((opcode & 0x0F00) >> 8);
+    std::uint8_t *vy = reg((opcode & 0x00F0) >> 4);
+    std::uint8_t *vf = reg(0xF);
+    const std::uint8_t kk = opcode & 0x00FF;
+    const std::uint16_t nnn = opcode & 0x0FFF;
+    // the flag is always computed from the operands before either of them is written, as in Chip8::stepSwitch
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+      // 00E0 and 00EE need per-instance state, any other 0nnn is ignored
+      return opcode != 0x00E0 && opcode != 0x00EE;
+    case 0x1000: // JP addr
+      lanes::map16(pc_.data(), m, m, n, lanes::Assign16{nnn});
+      return true;
+    case 0x3000: // SE Vx, byte
+      lanes::map8(condition_.data(), vx, vx, m, n, lanes::EqualImmediate{kk});
+      lanes::map16(pc_.data(), condition_.data(), m, n, lanes::Skip{});
+      return true;
+    case 0x4000: // SNE Vx, byte
+      lanes::map8(condition_.data(), vx, vx, m, n, lanes::NotEqualImmediate{kk});
+      lanes::map16(pc_.data(), condition_.data(), m, n, lanes::Skip{});
+      return true;
+    case 0x5000: // SE Vx, Vy
+      lanes::map8(condition_.data(), vx, vy, m, n, lanes::Equal{});
+      lanes::map16(pc_.data(), condition_.data(), m, n, lanes::Skip{});
+      return true;
+    case 0x6000: // LD Vx, byte
+      lanes::map8(vx, vx, vx, m, n, lanes::SetImmediate{kk});
+      return true;
+    case 0x7000: // ADD Vx, byte
+      lanes::map8(vx, vx, vx, m, n, lanes::AddImmediate{kk});
+      return true;
+    case 0x8000:
+      switch (opcode & 0x000F)
+      {
+      case 0x0000: // LD Vx, Vy
+        lanes::map8(vx, vx, vy, m, n, lanes::Copy{});
+        return true;
+      case 0x0001: // OR Vx, Vy
+        lanes::map8(vx, vx, vy, m, n, lanes::Or{});
+        return true;
+      case 0x0002: // AND Vx, Vy
+        lanes::map8(vx, vx, vy, m, n, lanes::And{});
+        return true;
+      case 0x0003: // XOR Vx, Vy
+        lanes::map8(vx, vx, vy, m, n, lanes::Xor{});
+        return true;
+      case 0x0004: // ADD Vx, Vy
+        lanes::map8(vf, vx, vy, m, n, lanes::Carry{});
+        lanes::map8(vx, vx, vy, m, n, lanes::Add{});
+        return true;
+      case 0x0005: // SUB Vx, Vy
+        lanes::map8(vf, vx, vy, m, n, lanes::NoBorrow{});
+        lanes::map8(vx, vx, vy, m, n, lanes::Subtract{});
+        return true;
+      case 0x0006: // SHR Vx
+        lanes::map8(vf, vx, vx, m, n, lanes::LowBit{});
+        lanes::map8(vx, vx, vx, m, n, lanes::ShiftRight{});
+        return true;
+      case 0x0007: // SUBN Vx, Vy
+        lanes::map8(vf, vy, vx, m, n, lanes::NoBorrow{});
+        lanes::map8(vx, vx, vy, m, n, lanes::ReverseSubtract{});
+        return true;
+      case 0x000E: // SHL Vx
+        lanes::map8(vf, vx, vx, m, n, lanes::HighBit{});
+        lanes::map8(vx, vx, vx, m, n, lanes::ShiftLeft{});
+        return true;
+      default:
+        return false;
+      }
+    case 0x9000: // SNE Vx, Vy
+      lanes::map8(condition_.data(), vx, vy, m, n, lanes::NotEqual{});
+      lanes::map16(pc_.data(), condition_.data(), m, n, lanes::Skip{});
+      return true;
+    case 0xA000: // LD I, addr
+      lanes::map16(I_.data(), m, m, n, lanes::Assign16{nnn});
+      return true;
+    case 0xF000:
+      switch (opcode & 0x00FF)
+      {
+      case 0x0007: // LD Vx, DT
+        lanes::map8(vx, vx, delay_timer_.data(), m, n, lanes::Copy{});
+        return true;
+      case 0x0015: // LD DT, Vx
+        lanes::map8(delay_timer_.data(), vx, vx, m, n, lanes::Copy{});
+        return true;
+      case 0x0018: // LD ST, Vx
+        lanes::map8(sound_timer_.data(), vx, vx, m, n, lanes::Copy{});
+        return true;
+      case 0x001E: // ADD I, Vx
+        lanes::map16(I_.data(), vx, m, n, lanes::Add16{});
+        return true;
+      case 0x0029: // LD F, Vx
+        lanes::map16(I_.data(), vx, m, n, lanes::Font{});
+        return true;
+      default:
+        return false;
+      }
+    default: // calls, random numbers, drawing, keys and memory accesses
+      return false;
+    }
+  }
+
+  void VectorMachine::executeLane(const std::size_t lane, const std::uint16_t opcode)
+  {
+    const std::uint8_t x = (opcode & 0x0F00) >> 8;
+    const std::uint8_t y = (opcode & 0x00F0) >> 4;
+    const std::uint8_t n = opcode & 0x000F;
+    const std::uint8_t kk = opcode & 0x00FF;
+    const std::uint16_t nnn = opcode & 0x0FFF;
+    std::uint8_t &vx = reg(x)[lane];
+    std::uint8_t &vy = reg(y)[lane];
+    std::uint8_t &vf = reg(0xF)[lane];
+    std::uint16_t &pc = pc_[lane];
+    std::uint16_t &I = I_[lane];
+    std::uint8_t &sp = sp_[lane];
+    std::uint8_t *ram = memory(lane);
+    // the stack index is wrapped so a runaway program cannot write outside its own lane
+    const auto stack = [&](const std::uint8_t level) -> std::uint16_t &
+    { return stack_[(level & 0xF) * stride_ + lane]; };
+    const auto key = [&](const std::uint8_t k) -> std::uint8_t &
+    { return keyboard_[(k & 0xF) * stride_ + lane]; };
+    const auto unknown = [&]
+    { running_[lane] = 0; };
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+      if (opcode == 0x00E0) // CLS
+      {
+        screens_[lane].clear();
+        draw_[lane] = 1;
+      }
+      else if (opcode == 0x00EE) // RET
+      {
+        pc = stack(--sp);
+      }
+      break;
+    case 0x1000: // JP addr
+      pc = nnn;
+      break;
+    case 0x2000: // CALL addr
+      stack(sp) = pc;
+      ++sp;
+      pc = nnn;
+      break;
+    case 0x3000: // SE Vx, byte
+      pc += (vx == kk) ? 2 : 0;
+      break;
+    case 0x4000: // SNE Vx, byte
+      pc += (vx != kk) ? 2 : 0;
+      break;
+    case 0x5000: // SE Vx, Vy
+      pc += (vx == vy) ? 2 : 0;
+      break;
+    case 0x6000: // LD Vx, byte
+      vx = kk;
+      break;
+    case 0x7000: // ADD Vx, byte
+      vx += kk;
+      break;
+    case 0x8000:
+      switch (n)
+      {
+      case 0x0: // LD Vx, Vy
+        vx = vy;
+        break;
+      case 0x1: // OR Vx, Vy
+        vx |= vy;
+        break;
+      case 0x2: // AND Vx, Vy
+        vx &= vy;
+        break;
+      case 0x3: // XOR Vx, Vy
+        vx ^= vy;
+        break;
+      case 0x4: // ADD Vx, Vy
+        vf = (vy > (0xFF - vx)) ? 1 : 0;
+        vx += vy;
+        break;
+      case 0x5: // SUB Vx, Vy
+        vf = (vy > vx) ? 0 : 1;
+        vx -= vy;
+        break;
+      case 0x6: // SHR Vx
+        vf = vx & 0x1;
+        vx >>= 1;
+        break;
+      case 0x7: // SUBN Vx, Vy
+        vf = (vx > vy) ? 0 : 1;
+        vx = vy - vx;
+        break;
+      case 0xE: // SHL Vx
+        vf = vx >> 7;
+        vx <<= 1;
+        break;
+      default:
+        unknown();
+      }
+      break;
+    case 0x9000: // SNE Vx, Vy
+      pc += (vx != vy) ? 2 : 0;
+      break;
+    case 0xA000: // LD I, addr
+      I = nnn;
+      break;
+    case 0xB000: // JP V0, addr
+      pc = nnn + reg(0)[lane];
+      break;
+    case 0xC000: // RND Vx, byte
+      vx = random_[lane].nextByte() & kk;
+      break;
+    case 0xD000: // DRW Vx, Vy, nibble
+    {
+      const std::uint8_t x_coord = vx % utils::SCREEN_WIDTH;
+      const std::uint8_t y_coord = vy % utils::SCREEN_HEIGHT;
+      std::uint8_t collision = 0;
+      for (std::size_t i = 0; i < n && y_coord + i < utils::SCREEN_HEIGHT; ++i)
+      {
+        collision |= screens_[lane].drawRow(x_coord, y_coord + i, ram[(I + i) & (MEMORY_SIZE - 1)]) ? 1 : 0;
+      }
+      vf = collision;
+      draw_[lane] = 1;
+      break;
+    }
+    case 0xE000:
+      switch (kk)
+      {
+      case 0x9E: // SKP Vx
+        pc += (key(vx) == 1) ? 2 : 0;
+        break;
+      case 0xA1: // SKNP Vx
+        pc += (key(vx) == 0) ? 2 : 0;
+        break;
+      default:
+        unknown();
+      }
+      break;
+    default: // 0xF000
+      switch (kk)
+      {
+      case 0x07: // LD Vx, DT
+        vx = delay_timer_[lane];
+        break;
+      case 0x0A: // LD Vx, K
+      {
+        std::uint8_t k = 0;
+        while (k < 16 && !key(k))
+        {
+          ++k;
+        }
+        if (k < 16)
+        {
+          vx = k;
+        }
+        else
+        {
+          // repeat the same instruction until a key is down
+          pc -= 2;
+        }
+        break;
+      }
+      case 0x15: // LD DT, Vx
+        delay_timer_[lane] = vx;
+        break;
+      case 0x18: // LD ST, Vx
+        sound_timer_[lane] = vx;
+        break;
+      case 0x1E: // ADD I, Vx
+        I += vx;
+        break;
+      case 0x29: // LD F, Vx
+        I = vx * 5;
+        break;
+      case 0x33: // LD B, Vx
+        ram[I & (MEMORY_SIZE - 1)] = vx / 100;
+        ram[(I + 1) & (MEMORY_SIZE - 1)] = (vx / 10) % 10;
+        ram[(I + 2) & (MEMORY_SIZE - 1)] = vx % 10;
+        break;
+      case 0x55: // LD [I], Vx
+        for (std::size_t i = 0; i <= x; ++i)
+        {
+          ram[(I + i) & (MEMORY_SIZE - 1)] = reg(i)[lane];
+        }
+        break;
+      case 0x65: // LD Vx, [I]
+        for (std::size_t i = 0; i <= x; ++i)
+        {
+          reg(i)[lane] = ram[(I + i) & (MEMORY_SIZE - 1)];
+        }
+        break;
+      default:
+        unknown();
+      }
+      break;
+    }
+  }
+
+  void VectorMachine::tickTimers()
+  {
+    lanes::decrement(delay_timer_.data(), stride_);
+    lanes::decrement(sound_timer_.data(), stride_);
+  }
+
+  void VectorMachine::setKey(const std::size_t lane, const std::uint8_t key, const bool pressed)
+  {
+    keyboard_[(key & 0xF) * stride_ + lane] = pressed ? 1 : 0;
+  }
+
+  const std::vector<interpreter::FrameBuffer> &VectorMachine::frameBuffers() const
+  {
+    return screens_;
+  }
+
+  bool VectorMachine::shouldDraw(const std::size_t lane)
+  {
+    const bool raised = draw_[lane] != 0;
+    draw_[lane] = 0;
+    return raised;
+  }
+
+  bool VectorMachine::terminated(const std::size_t lane) const
+  {
+    return running_[lane] == 0;
+  }
+
+  std::uint8_t *VectorMachine::reg(const std::size_t index)
+  {
+    return V_.data() + index * stride_;
+  }
+
+  std::uint8_t *VectorMachine::memory(const std::size_t lane)
+  {
+    return memory_.data() + lane * MEMORY_STRIDE;
+  }
+
+} // namespace emulator::vector
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "framebuffer.hpp"
+#include "interpreter.hpp"
+#include "random.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace emulator::vector
+{
+  // thousands of independent Chip8 machines stepped in lockstep
+  // registers, pcs, timers, stacks and keys are stored structure-of-arrays (one array per register, one element per instance),
+  // every cycle the instances are grouped by the opcode they are about to run and each group runs as one masked SIMD kernel,
+  // instructions that touch per-instance memory or the screen (or groups past a limit) run one instance at a time
+  // every instance gives exactly the same results as a Chip8 running the same instructions on the CHIP-8 platform,
+  // SUPER-CHIP and XO-CHIP programs are left to Chip8
+  class VectorMachine
+  {
+  public:
+    explicit VectorMachine(const std::size_t instances);
+
+    std::size_t size() const;
+
+    /**
+     * @brief Put every instance into the same state
+     */
+    void load(const interpreter::Snapshot &state);
+
+    /**
+     * @brief Put one instance into a state
+     */
+    void load(const std::size_t instance, const interpreter::Snapshot &state);
+
+    /**
+     * @brief Copy the state of one instance out
+     */
+    void saveState(const std::size_t instance, interpreter::Snapshot &state) const;
+
+    /**
+     * @brief Restart the RND sequence of one instance, see Chip8::seed
+     */
+    void seed(const std::size_t instance, const std::uint64_t seed);
+
+    /**
+     * @brief Run up to the given number of cycles on every running instance
+     * @details Instances stop for good on an unknown opcode, like Chip8 does
+     * @return The screens of all instances, indexed like the instances
+     */
+    const std::vector<interpreter::FrameBuffer> &step(const std::size_t cycles);
+
+    /**
+     * @brief Decrement the delay and sound timers of every instance, call at 60Hz of emulated time
+     */
+    void tickTimers();
+
+    /**
+     * @brief Press or release a key on one instance, see Chip8::setKey
+     */
+    void setKey(const std::size_t instance, const std::uint8_t key, const bool pressed);
+
+    /**
+     * @brief The screens of all instances
+     */
+    const std::vector<interpreter::FrameBuffer> &frameBuffers() const;
+
+    /**
+     * @brief Get and reset the draw flag of one instance
+     */
+    bool shouldDraw(const std::size_t instance);
+
+    /**
+     * @brief Check if an instance hit an unknown opcode
+     */
+    bool terminated(const std::size_t instance) const;
+
+  private:
+    /**
+     * @brief Run one decoded instruction on every lane of mask_ at once
+     * @return false if the instruction has no vector kernel
+     */
+    bool executeGroup(const std::uint16_t opcode);
+
+    /**
+     * @brief Run one instruction on a single instance, mirrors Chip8::stepSwitch after pc was advanced
+     */
+    void executeLane(const std::size_t lane, const std::uint16_t opcode);
+
+    std::uint8_t *reg(const std::size_t index);
+    std::uint8_t *memory(const std::size_t lane);
+
+  private:
+    std::size_t count_;
+    // lane arrays are padded to a whole number of SIMD registers
+    std::size_t stride_;
+
+    std::vector<std::uint8_t> V_; // V_[x * stride_ + lane]
+    std::vector<std::uint16_t> I_;
+    std::vector<std::uint16_t> pc_;
+    std::vector<std::uint8_t> sp_;
+    std::vector<std::uint16_t> stack_; // stack_[level * stride_ + lane]
+    std::vector<std::uint8_t> delay_timer_;
+    std::vector<std::uint8_t> sound_timer_;
+    std::vector<utils::Random> random_;
+    std::vector<std::uint8_t> keyboard_; // keyboard_[key * stride_ + lane]
+    std::vector<std::uint8_t> memory_;   // one whole address space per instance, see MEMORY_STRIDE
+    std::vector<interpreter::FrameBuffer> screens_;
+    std::vector<std::uint8_t> draw_;
+
+    // per cycle scratch: opcode bytes, lanes still running, lanes not yet executed and the current group
+    std::vector<std::uint8_t> opcode_high_;
+    std::vector<std::uint8_t> opcode_low_;
+    std::vector<std::uint8_t> running_;
+    std::vector<std::uint8_t> pending_;
+    std::vector<std::uint8_t> mask_;
+    std::vector<std::uint8_t> condition_;
+  };
+
+} // namespace emulator::vector
@@ -1,74 +1,165 @@
 #include "interpreter.hpp"
 #include "messages.hpp"
 #include "graphics.hpp"
+#include "options.hpp"
+#include "emulation_thread.hpp"
+#include "rewind.hpp"
+#include "audio_output.hpp"
+#include "input_log.hpp"
+#include "shared_frame.hpp"
+#include "frame_capture.hpp"
 
-#include <chrono>
-#include <thread>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <sstream>
 
-void updateTimePoints(std::chrono::system_clock::time_point &time_point_start, std::chrono::system_clock::time_point &time_point_finish);
-
-int main()
+int main(int argc, char **argv)
 {
   // create a messenger to print messages to the user
   emulator::utils::Messenger messenger;
-  const std::string filename = messenger.gamePrompt();
-  // create a chip8 instance and load the game
+  const auto options = emulator::parseOptions(argc, argv, messenger);
+  if (!options)
+  {
+    return 1;
+  }
+  const std::string filename = options->filename.empty() ? messenger.gamePrompt() : options->filename;
+  // create a chip8 instance and load the game, a game played before skips straight past its analysis
   emulator::interpreter::Chip8 chip8(messenger);
-  const auto game_load_result = chip8.loadGame(filename.c_str());
-  if (game_load_result == emulator::utils::Result::Failure)
+  emulator::rom::RomStore roms(options->rom_cache);
+  const auto image = roms.load(filename, messenger);
+  if (!image || image->loadInto(chip8, options->platform) == emulator::utils::Result::Failure)
   {
     messenger.printUnsuccessfulLoadMessage();
     return 1;
   };
-  // create a graphics handler and initialise the graphics library
-  emulator::graphics::Graphics graphics_handler(messenger);
-  const auto graphics_init_result = graphics_handler.initialise();
-  if (graphics_init_result == emulator::utils::Result::Failure)
+  // RND draws from a per machine sequence, seeded afresh every run unless a seed was asked for
+  const std::uint64_t seed = options->seed ? *options->seed : (std::uint64_t{std::random_device{}()} << 32 | std::random_device{}());
+  chip8.seed(seed);
+  // a recorded session is everything chip8_headless --replay needs to play it again
+  std::unique_ptr<emulator::replay::InputLog> recording;
+  if (!options->record.empty())
   {
-    messenger.printUnsuccessfulGraphicsInitMessage();
-    return 1;
+    recording = std::make_unique<emulator::replay::InputLog>();
+    recording->seed = seed;
+    recording->rom_hash = image->hash;
+    recording->rom_path = std::filesystem::absolute(filename).string();
+    recording->cpu_hz = static_cast<std::uint32_t>(options->cpu_hz);
+    recording->platform = chip8.getPlatform();
   }
-  const auto window_op = graphics_handler.getWindow();
-  if (!window_op)
+  // open the window, or take over the terminal, the emulation thread owns chip8 from here on
+  // screens come back through a triple buffer and keys go out through a mailbox
+  emulator::utils::TripleBuffer<emulator::interpreter::FrameBuffer> frames;
+  emulator::utils::KeyMailbox keys;
+  auto display = emulator::graphics::makeDisplay(messenger, options->renderer);
+  if (display->open(keys) == emulator::utils::Result::Failure)
   {
-    messenger.printUnsuccessfulWindowCreationMessage();
     return 1;
   }
-  graphics_handler.setKeyReactFun(chip8, window_op.value());
-  // create time points to maintain 60 Hz
-  std::chrono::system_clock::time_point time_point_start = std::chrono::system_clock::now();
-  std::chrono::system_clock::time_point time_point_finish = std::chrono::system_clock::now();
-  // Loop as long as we have not run of out instructions, user has not closed the window or the escape key has not been pressed
-  while (chip8.shouldTerminate() == emulator::utils::Flag::Lowered || graphics_handler.windowDisrupted(window_op.value()))
+  // every frame is kept for rewinding (hold backspace) unless the history was turned off
+  std::unique_ptr<emulator::rewind::RewindBuffer> history;
+  if (recording && options->rewind_mb > 0)
+  {
+    messenger.printMessage("Rewinding is off while recording");
+  }
+  else if (options->rewind_mb > 0)
+  {
+    history = std::make_unique<emulator::rewind::RewindBuffer>(options->rewind_mb * 1024 * 1024);
+  }
+  // the buzzer plays on its own thread, the game just runs silently if no sink could be opened
+  std::unique_ptr<emulator::audio::AudioOutput> audio;
+  if (options->audio != "off")
+  {
+    if (auto sink = emulator::audio::openSink(options->audio, emulator::audio::DEFAULT_SAMPLE_RATE, messenger))
+    {
+      audio = std::make_unique<emulator::audio::AudioOutput>(std::move(sink));
+      audio->start();
+    }
+  }
+  // other processes can watch the game through shared memory, it just runs unshared if the segment cannot be made
+  std::optional<emulator::share::SharedFrameWriter> shared;
+  if (!options->share.empty())
+  {
+    shared = emulator::share::SharedFrameWriter::create(options->share);
+    if (!shared)
+    {
+      messenger.log<emulator::utils::Level::Warning>("Failed to create the shared memory segment ", options->share);
+    }
+  }
+  // frames are encoded on their own thread, the game just runs uncaptured if the output could not be opened
+  std::unique_ptr<emulator::capture::FrameCapture> capture;
+  if (!options->capture.empty())
+  {
+    if (auto encoder = emulator::capture::openEncoder(options->capture, messenger))
+    {
+      capture = std::make_unique<emulator::capture::FrameCapture>(std::move(encoder));
+      capture->start();
+    }
+  }
+  emulator::scheduler::EmulationThread emulation(chip8, frames, keys, options->cpu_hz, !options->unthrottled, options->turbo,
+                                                 history.get(), audio.get(), recording.get(), shared ? &*shared : nullptr,
+                                                 capture.get());
+  emulation.start([&display]
+                  { display->wake(); });
+  // the title shows the speed while fast forwarding, rounded so it only changes a few times a second
+  long shown_speed = -1;
+  // Loop as long as we have not run of out instructions, user has not closed the display or the escape key has not been pressed
+  while (!emulation.finished() && !display->closed())
   {
-    updateTimePoints(time_point_start, time_point_finish);
-    chip8.emulateCycle();
-    if (chip8.shouldDraw() == emulator::utils::Flag::Raised)
+    const long speed = keys.fastForward() ? std::lround(emulation.speed() * 10) : -1;
+    if (speed != shown_speed)
     {
-      // updating window with new graphics
-      const auto draw_result = graphics_handler.drawOnWindow(chip8, window_op.value());
+      std::ostringstream title;
+      title << emulator::graphics::WINDOW_TITLE;
+      if (speed >= 0)
+      {
+        title << " - fast forward " << speed / 10 << '.' << speed % 10 << 'x';
+      }
+      display->setTitle(title.str());
+      shown_speed = speed;
+    }
+    if (frames.update())
+    {
+      // showing the newest finished screen, a swap blocked on vsync only holds up this thread
+      const auto draw_result = display->present(frames.read());
       if (draw_result == emulator::utils::Result::Failure)
       {
         messenger.printUnsuccessfulDrawMessage();
         return 1;
       }
     }
+    // sleep until the next frame or input, the timeout only guards against a missed wake up
+    display->waitEvents(0.1);
+  }
+  emulation.stop();
+  // close the window, or give the terminal back, before the reports below are printed
+  display.reset();
+  if (capture)
+  {
+    capture->stop();
+    messenger.printMessage("Captured ", capture->encodedFrames(), " frames to ", options->capture);
+    if (capture->droppedFrames() > 0)
+    {
+      messenger.log<emulator::utils::Level::Warning>("The encoder fell behind, ", capture->droppedFrames(), " frames were dropped");
+    }
+  }
+  if (recording)
+  {
+    if (recording->save(options->record) == emulator::utils::Result::Failure)
+    {
+      messenger.log<emulator::utils::Level::Error>("Failed to write the recording to ", options->record);
+    }
+    else
+    {
+      messenger.printMessage("Recorded ", recording->frames, " frames to ", options->record);
+    }
+  }
+  if (options->stats)
+  {
+    messenger.printMessage(emulation.stats().report(), emulation.inputLatency().report("input latency"));
   }
   messenger.printSuccessfulTerminationMessage();
   return 0;
 }
-
-// sleep the main thread to maintain 60 Hz
-void updateTimePoints(std::chrono::system_clock::time_point &time_point_start, std::chrono::system_clock::time_point &time_point_finish)
-{
-  // Maintain designated frequency of 60 Hz (roughly 16.6 ms per frame)
-  time_point_start = std::chrono::system_clock::now();
-  std::chrono::duration<double, std::milli> work_time = time_point_start - time_point_finish;
-  if (work_time.count() < 16.0) // leaving a little time for these calculations to be done
-  {
-    std::chrono::duration<double, std::milli> delta_ms(16.0 - work_time.count());
-    const auto delta_ms_duration = std::chrono::duration_cast<std::chrono::milliseconds>(delta_ms);
-    std::this_thread::sleep_for(std::chrono::milliseconds(delta_ms_duration.count()));
-  }
-  time_point_finish = std::chrono::system_clock::now();
-}
\ No newline at end of file
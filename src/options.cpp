@@ -0,0 +1,170 @@
+#include "options.hpp"
+
+#include "parse.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace emulator
+{
+    namespace
+    {
+        void printUsage(utils::Messenger &messenger)
+        {
+            messenger.printMessage("Usage: chip8_emulator [options] [file]\n",
+                                   "  --renderer R  texture, immediate or terminal (default texture)\n",
+                                   "  --cpu-hz N    instructions per second (default ", scheduler::DEFAULT_CPU_HZ, ")\n",
+                                   "  --unthrottled run as fast as possible instead of at 60 frames per second\n",
+                                   "  --turbo N     speed multiple while fast forwarding with tab, 0 is uncapped (default 0)\n",
+                                   "  --rewind-mb N megabytes of rewind history, 0 turns rewinding off (default 8)\n",
+                                   "  --stats       print frame time, jitter and input latency histograms on exit\n",
+                                   "  --audio A     alsa[:DEVICE], wav:FILE, null or off (default alsa)\n",
+                                   "  --rom-cache D directory analysed ROMs are kept in, or off (default ~/.cache/chip8_emu)\n",
+                                   "  --seed N      seed of the random number instruction (default a fresh one every run)\n",
+                                   "  --record F    record the session to F for chip8_headless --replay\n",
+                                   "  --platform P  chip8, schip or xochip (default picked from the instructions the ROM uses)\n",
+                                   "  --share NAME  publish every frame to the shared memory segment NAME (such as /chip8) for outside viewers\n",
+                                   "  --capture C   record frames as png:DIRECTORY snapshots or a c8v:FILE stream for chip8_capture_convert");
+        }
+    } // namespace
+
+    std::optional<Options> parseOptions(int argc, char **argv, utils::Messenger &messenger)
+    {
+        Options options;
+        for (int i = 1; i < argc; ++i)
+        {
+            const char *arg = argv[i];
+            const char *value = (i + 1 < argc) ? argv[i + 1] : "";
+            if (std::strcmp(arg, "--renderer") == 0)
+            {
+                if (std::strcmp(value, "texture") == 0)
+                {
+                    options.renderer = graphics::Renderer::Texture;
+                }
+                else if (std::strcmp(value, "immediate") == 0)
+                {
+                    options.renderer = graphics::Renderer::Immediate;
+                }
+                else if (std::strcmp(value, "terminal") == 0)
+                {
+                    options.renderer = graphics::Renderer::Terminal;
+                }
+                else
+                {
+                    printUsage(messenger);
+                    return std::nullopt;
+                }
+                ++i;
+            }
+            else if (std::strcmp(arg, "--cpu-hz") == 0)
+            {
+                const auto cpu_hz = utils::parseCount(value);
+                if (!cpu_hz)
+                {
+                    printUsage(messenger);
+                    return std::nullopt;
+                }
+                options.cpu_hz = *cpu_hz;
+                ++i;
+            }
+            else if (std::strcmp(arg, "--turbo") == 0)
+            {
+                const auto turbo = utils::parseNumber(value);
+                if (!turbo)
+                {
+                    printUsage(messenger);
+                    return std::nullopt;
+                }
+                options.turbo = *turbo;
+                ++i;
+            }
+            else if (std::strcmp(arg, "--rewind-mb") == 0)
+            {
+                const auto rewind_mb = utils::parseNumber(value);
+                if (!rewind_mb)
+                {
+                    printUsage(messenger);
+                    return std::nullopt;
+                }
+                options.rewind_mb = *rewind_mb;
+                ++i;
+            }
+            else if (std::strcmp(arg, "--audio") == 0 && value[0] != '\0')
+            {
+                options.audio = value;
+                ++i;
+            }
+            else if (std::strcmp(arg, "--seed") == 0)
+            {
+                const auto seed = utils::parseNumber(value);
+                if (!seed)
+                {
+                    printUsage(messenger);
+                    return std::nullopt;
+                }
+                options.seed = *seed;
+                ++i;
+            }
+            else if (std::strcmp(arg, "--record") == 0 && value[0] != '\0')
+            {
+                options.record = value;
+                ++i;
+            }
+            else if (std::strcmp(arg, "--share") == 0 && value[0] == '/' && value[1] != '\0')
+            {
+                options.share = value;
+                ++i;
+            }
+            else if (std::strcmp(arg, "--capture") == 0 && value[0] != '\0')
+            {
+                options.capture = value;
+                ++i;
+            }
+            else if (std::strcmp(arg, "--platform") == 0)
+            {
+                if (std::strcmp(value, "chip8") == 0)
+                {
+                    options.platform = utils::Platform::Chip8;
+                }
+                else if (std::strcmp(value, "schip") == 0)
+                {
+                    options.platform = utils::Platform::SuperChip;
+                }
+                else if (std::strcmp(value, "xochip") == 0)
+                {
+                    options.platform = utils::Platform::XoChip;
+                }
+                else
+                {
+                    printUsage(messenger);
+                    return std::nullopt;
+                }
+                ++i;
+            }
+            else if (std::strcmp(arg, "--rom-cache") == 0 && value[0] != '\0')
+            {
+                options.rom_cache = (std::strcmp(value, "off") == 0) ? std::filesystem::path() : std::filesystem::path(value);
+                ++i;
+            }
+            else if (std::strcmp(arg, "--unthrottled") == 0)
+            {
+                options.unthrottled = true;
+            }
+            else if (std::strcmp(arg, "--stats") == 0)
+            {
+                options.stats = true;
+            }
+            else if (arg[0] == '-' || !options.filename.empty())
+            {
+                printUsage(messenger);
+                return std::nullopt;
+            }
+            else
+            {
+                options.filename = arg;
+            }
+        }
+        return options;
+    }
+
+} // namespace emulator
\ No newline at end of file
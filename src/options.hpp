@@ -0,0 +1,53 @@
+#pragma once
+
+#include "graphics.hpp"
+#include "messages.hpp"
+#include "rom_store.hpp"
+#include "scheduler.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace emulator
+{
+    // settings picked on the command line
+    struct Options
+    {
+        // game to load, prompted for when left empty
+        std::string filename;
+        graphics::Renderer renderer = graphics::Renderer::Texture;
+        // instructions executed per second of emulated time
+        std::size_t cpu_hz = scheduler::DEFAULT_CPU_HZ;
+        // run emulation as fast as possible instead of pacing it to 60 Hz
+        bool unthrottled = false;
+        // speed multiple while fast forwarding (tab), 0 runs uncapped
+        std::size_t turbo = 0;
+        // megabytes of rewind history, 0 turns rewinding off
+        std::size_t rewind_mb = 8;
+        // print the frame time, jitter and input latency histograms on exit
+        bool stats = false;
+        // where the buzzer goes: alsa[:DEVICE], wav:FILE, null or off
+        std::string audio = "alsa";
+        // where analysed ROMs are kept between runs, empty turns the cache off
+        std::filesystem::path rom_cache = rom::RomStore::defaultCacheDirectory();
+        // seed of the RND sequence, a fresh one every run when not given
+        std::optional<std::uint64_t> seed;
+        // write the keys pressed and periodic screen hashes here for chip8_headless --replay, empty records nothing
+        std::string record;
+        // the machine to emulate, the one the ROM's instructions call for when not given
+        std::optional<utils::Platform> platform;
+        // shm_open name every frame is published under for outside viewers and recorders, empty publishes nothing
+        std::string share;
+        // where frames are captured: png:DIRECTORY or c8v:FILE, empty captures nothing
+        std::string capture;
+    };
+
+    /**
+     * @brief Parse the command line arguments of the emulator
+     * @return The parsed options, or nothing if the arguments are invalid (a usage message is printed)
+     */
+    std::optional<Options> parseOptions(int argc, char **argv, utils::Messenger &messenger);
+
+} // namespace emulator
\ No newline at end of file
@@ -0,0 +1,368 @@
+#include "synthetic_roms.hpp"
+
+#include "interpreter.hpp"
+#include "messages.hpp"
+#include "parse.hpp"
+#include "rewind.hpp"
+#include "scheduler.hpp"
+#include "triple_buffer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  struct Options
+  {
+    std::size_t repetitions = 9;          // measured runs per benchmark, after one warm-up run
+    std::size_t instructions = 2'000'000; // instructions per run of the interpreter benchmarks
+    std::string filter;                   // only run benchmarks whose name contains this
+    std::string json;                     // write the results as JSON here, "-" for stdout
+  };
+
+  // one timed run of a benchmark: how many operations it did and how long it took
+  struct Sample
+  {
+    std::size_t operations;
+    double seconds;
+  };
+
+  struct Result
+  {
+    std::string name;
+    std::string engine; // empty for benchmarks that do not run instructions
+    std::string unit;   // what one operation is
+    std::size_t operations = 0;
+    // nanoseconds per operation over all measured runs
+    double median = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double ops_per_second = 0.0;
+    double frames_per_second = 0.0;
+  };
+
+  void printUsage(emulator::utils::Messenger &messenger)
+  {
+    messenger.printMessage("Usage: chip8_bench [options]\n",
+                           "  --reps N          measured runs per benchmark (default 9)\n",
+                           "  --instructions N  instructions per run (default 2000000)\n",
+                           "  --filter TEXT     only run benchmarks whose name contains TEXT\n",
+                           "  --json FILE       also write the results as JSON, - for stdout");
+  }
+
+  std::optional<Options> parseOptions(int argc, char **argv, emulator::utils::Messenger &messenger)
+  {
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+      const char *arg = argv[i];
+      const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+      if (value && std::strcmp(arg, "--reps") == 0 && emulator::utils::parseCount(value))
+      {
+        options.repetitions = *emulator::utils::parseCount(value);
+      }
+      else if (value && std::strcmp(arg, "--instructions") == 0 && emulator::utils::parseCount(value))
+      {
+        options.instructions = *emulator::utils::parseCount(value);
+      }
+      else if (value && std::strcmp(arg, "--filter") == 0)
+      {
+        options.filter = value;
+      }
+      else if (value && std::strcmp(arg, "--json") == 0)
+      {
+        options.json = value;
+      }
+      else
+      {
+        messenger.printMessage("Invalid argument ", arg);
+        return std::nullopt;
+      }
+      ++i;
+    }
+    return options;
+  }
+
+  /**
+   * @brief Run a benchmark once to warm caches and code up, then the given number of timed times
+   * @param body One run, returns how many operations it did
+   */
+  std::vector<Sample> measure(const std::size_t repetitions, const std::function<std::size_t()> &body)
+  {
+    body();
+    std::vector<Sample> samples;
+    samples.reserve(repetitions);
+    for (std::size_t i = 0; i < repetitions; ++i)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      const std::size_t operations = body();
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      samples.push_back({operations, elapsed.count()});
+    }
+    return samples;
+  }
+
+  /**
+   * @brief Reduce the samples to per-operation statistics, the median is what rates are derived from
+   * @param ops_per_frame Operations making up one 60 Hz frame, 0 if frames make no sense for the benchmark
+   */
+  Result summarise(Result result, const std::vector<Sample> &samples, const double ops_per_frame)
+  {
+    std::vector<double> ns;
+    for (const Sample &sample : samples)
+    {
+      ns.push_back(sample.seconds * 1e9 / std::max<std::size_t>(sample.operations, 1));
+      result.operations += sample.operations;
+    }
+    std::sort(ns.begin(), ns.end());
+    const std::size_t middle = ns.size() / 2;
+    result.median = (ns.size() % 2 == 1) ? ns[middle] : (ns[middle - 1] + ns[middle]) / 2.0;
+    result.min = ns.front();
+    result.max = ns.back();
+    for (const double value : ns)
+    {
+      result.mean += value / ns.size();
+    }
+    for (const double value : ns)
+    {
+      result.stddev += (value - result.mean) * (value - result.mean) / ns.size();
+    }
+    result.stddev = std::sqrt(result.stddev);
+    result.ops_per_second = (result.median > 0.0) ? 1e9 / result.median : 0.0;
+    result.frames_per_second = (ops_per_frame > 0.0) ? result.ops_per_second / ops_per_frame : 0.0;
+    return result;
+  }
+
+  const char *engineName(const emulator::utils::Engine engine)
+  {
+    switch (engine)
+    {
+    case emulator::utils::Engine::Switch:
+      return "switch";
+    case emulator::utils::Engine::Cached:
+      return "cached";
+    default:
+      return "jit";
+    }
+  }
+
+  std::filesystem::path writeRom(const bench::SyntheticRom &rom)
+  {
+    const auto path = std::filesystem::temp_directory_path() / ("chip8_bench_" + rom.name + ".ch8");
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(rom.bytes.data()), static_cast<std::streamsize>(rom.bytes.size()));
+    return path;
+  }
+
+  // instructions the scheduler runs in one frame at the default clock
+  constexpr double INSTRUCTIONS_PER_FRAME =
+      static_cast<double>(emulator::scheduler::DEFAULT_CPU_HZ) / emulator::scheduler::FRAME_RATE;
+
+  Result benchInterpreter(const bench::SyntheticRom &rom, const std::filesystem::path &path, const emulator::utils::Engine engine,
+                          const Options &options, emulator::utils::Messenger &messenger)
+  {
+    emulator::interpreter::Chip8 chip8(messenger);
+    chip8.setEngine(engine);
+    chip8.loadGame(path.string().c_str());
+    // the ROMs loop forever, so every run continues where the last one stopped
+    const auto samples = measure(options.repetitions, [&]
+                                 { return chip8.run(options.instructions); });
+    Result result;
+    result.name = rom.name;
+    result.engine = engineName(chip8.getEngine());
+    result.unit = "instruction";
+    return summarise(result, samples, INSTRUCTIONS_PER_FRAME);
+  }
+
+  Result benchLoadGame(const std::filesystem::path &path, const Options &options, emulator::utils::Messenger &messenger)
+  {
+    constexpr std::size_t LOADS = 2000;
+    emulator::interpreter::Chip8 chip8(messenger);
+    const auto samples = measure(options.repetitions, [&]
+                                 {
+                                   for (std::size_t i = 0; i < LOADS; ++i)
+                                   {
+                                     chip8.loadGame(path.string().c_str());
+                                   }
+                                   return LOADS; });
+    Result result;
+    result.name = "load_game";
+    result.unit = "load";
+    return summarise(result, samples, 0.0);
+  }
+
+  // what the emulator does after every frame while rewinding is on: a frame of a ROM drawing sprites, then a capture
+  Result benchRewindCapture(const std::filesystem::path &path, const emulator::utils::Platform platform, const std::string &name,
+                            const Options &options, emulator::utils::Messenger &messenger)
+  {
+    constexpr std::size_t FRAMES = 2000;
+    emulator::interpreter::Chip8 chip8(messenger);
+    chip8.loadGame(path.string().c_str());
+    chip8.setPlatform(platform);
+    emulator::rewind::RewindBuffer history;
+    const auto samples = measure(options.repetitions, [&]
+                                 {
+                                   for (std::size_t i = 0; i < FRAMES; ++i)
+                                   {
+                                     chip8.run(static_cast<std::size_t>(INSTRUCTIONS_PER_FRAME));
+                                     history.capture(chip8);
+                                   }
+                                   return FRAMES; });
+    Result result;
+    result.name = name;
+    result.unit = "frame";
+    return summarise(result, samples, 1.0);
+  }
+
+  // what the window thread does with every frame: hand it over through the triple buffer and expand it into texture bytes
+  Result benchFramePresent(const Options &options)
+  {
+    constexpr std::size_t FRAMES = 100'000;
+    emulator::utils::TripleBuffer<emulator::interpreter::FrameBuffer> frames;
+    std::array<std::uint8_t, emulator::interpreter::FrameBuffer::HIRES_WIDTH * emulator::interpreter::FrameBuffer::HIRES_HEIGHT> pixels{};
+    emulator::interpreter::FrameBuffer screen;
+    const auto samples = measure(options.repetitions, [&]
+                                 {
+                                   for (std::size_t i = 0; i < FRAMES; ++i)
+                                   {
+                                     screen.drawRow(static_cast<int>(i % 57), static_cast<int>(i % 32), static_cast<std::uint8_t>(i));
+                                     frames.write() = screen;
+                                     frames.publish();
+                                     if (frames.update())
+                                     {
+                                       frames.read().expand(pixels.data());
+                                     }
+                                   }
+                                   return FRAMES; });
+    Result result;
+    result.name = "frame_present";
+    result.unit = "frame";
+    result = summarise(result, samples, 1.0);
+    // keep the work observable so none of it is optimised away
+    volatile std::uint8_t sink = pixels[0];
+    (void)sink;
+    return result;
+  }
+
+  std::string formatResult(const Result &result)
+  {
+    std::ostringstream line;
+    line << std::left << std::setw(16) << result.name << std::setw(8) << result.engine << std::right << std::fixed
+         << std::setprecision(2) << std::setw(12) << result.median << std::setw(10)
+         << ((result.median > 0.0) ? 100.0 * result.stddev / result.median : 0.0) << "%" << std::setprecision(0)
+         << std::setw(16) << result.ops_per_second << std::setw(14) << result.frames_per_second << "  ns/" << result.unit;
+    return line.str();
+  }
+
+  std::string toJson(const std::vector<Result> &results, const Options &options)
+  {
+    std::ostringstream json;
+    json << std::setprecision(6) << "{\n  \"repetitions\": " << options.repetitions
+         << ",\n  \"instructions_per_run\": " << options.instructions << ",\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+      const Result &r = results[i];
+      json << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << r.name << "\", \"engine\": \"" << r.engine << "\", \"unit\": \""
+           << r.unit << "\", \"operations\": " << r.operations << ", \"ns_per_op\": {\"median\": " << r.median
+           << ", \"mean\": " << r.mean << ", \"stddev\": " << r.stddev << ", \"min\": " << r.min << ", \"max\": " << r.max
+           << "}, \"ops_per_sec\": " << r.ops_per_second << ", \"frames_per_sec\": " << r.frames_per_second << "}";
+    }
+    json << "\n  ]\n}\n";
+    return json.str();
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  emulator::utils::Messenger messenger;
+  const auto options = parseOptions(argc, argv, messenger);
+  if (!options)
+  {
+    printUsage(messenger);
+    return 1;
+  }
+  const auto selected = [&](const std::string &name)
+  { return name.find(options->filter) != std::string::npos; };
+
+  // the machines under test only get to report errors, loadGame's progress messages would be measured too
+  emulator::utils::Messenger quiet(std::cout, emulator::utils::Level::Error);
+  std::vector<Result> results;
+  const auto roms = bench::syntheticRoms();
+  std::vector<std::filesystem::path> paths;
+  for (const auto &rom : roms)
+  {
+    paths.push_back(writeRom(rom));
+  }
+  for (std::size_t i = 0; i < roms.size(); ++i)
+  {
+    if (!selected(roms[i].name))
+    {
+      continue;
+    }
+    for (const auto engine : {emulator::utils::Engine::Switch, emulator::utils::Engine::Cached, emulator::utils::Engine::Jit})
+    {
+      results.push_back(benchInterpreter(roms[i], paths[i], engine, *options, quiet));
+    }
+  }
+  if (selected("load_game"))
+  {
+    results.push_back(benchLoadGame(paths.front(), *options, quiet));
+  }
+  // the second ROM draws sprites, so every frame changes the screen
+  if (selected("rewind"))
+  {
+    results.push_back(benchRewindCapture(paths[1], emulator::utils::Platform::Chip8, "rewind", *options, quiet));
+  }
+  if (selected("rewind_xo"))
+  {
+    results.push_back(benchRewindCapture(paths[1], emulator::utils::Platform::XoChip, "rewind_xo", *options, quiet));
+  }
+  if (selected("frame_present"))
+  {
+    results.push_back(benchFramePresent(*options));
+  }
+  for (const auto &path : paths)
+  {
+    std::filesystem::remove(path);
+  }
+
+  std::ostringstream header;
+  header << std::left << std::setw(16) << "benchmark" << std::setw(8) << "engine" << std::right << std::setw(12) << "ns/op"
+         << std::setw(11) << "stddev" << std::setw(16) << "ops/s" << std::setw(14) << "frames/s";
+  messenger.printMessage(header.str());
+  for (const Result &result : results)
+  {
+    messenger.printMessage(formatResult(result));
+  }
+  if (options->json == "-")
+  {
+    messenger.flush();
+    std::cout << toJson(results, *options);
+  }
+  else if (!options->json.empty())
+  {
+    std::ofstream file(options->json);
+    file << toJson(results, *options);
+    if (!file)
+    {
+      messenger.printMessage("Failed to write ", options->json);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,147 @@
+#include "synthetic_roms.hpp"
+
+namespace bench
+{
+  namespace
+  {
+    constexpr std::uint16_t START = 0x200;
+
+    // assembles opcodes one after the other, addresses are absolute
+    class Assembler
+    {
+    public:
+      std::uint16_t here() const
+      {
+        return static_cast<std::uint16_t>(START + bytes_.size());
+      }
+
+      Assembler &op(const std::uint16_t opcode)
+      {
+        bytes_.push_back(static_cast<std::uint8_t>(opcode >> 8));
+        bytes_.push_back(static_cast<std::uint8_t>(opcode & 0xFF));
+        return *this;
+      }
+
+      // pad with zeroes up to an absolute address
+      Assembler &org(const std::uint16_t address)
+      {
+        bytes_.resize(address - START, 0);
+        return *this;
+      }
+
+      Assembler &data(const std::vector<std::uint8_t> &bytes)
+      {
+        bytes_.insert(bytes_.end(), bytes.begin(), bytes.end());
+        return *this;
+      }
+
+      std::vector<std::uint8_t> bytes() const
+      {
+        return bytes_;
+      }
+
+    private:
+      std::vector<std::uint8_t> bytes_;
+    };
+
+    std::vector<std::uint8_t> aluLoop()
+    {
+      Assembler a;
+      for (std::uint16_t x = 0; x < 8; ++x)
+      {
+        a.op(0x6000 | x << 8 | (x * 37 + 11)); // LD Vx, byte
+      }
+      const std::uint16_t loop = a.here();
+      a.op(0x8014)  // ADD V0, V1
+          .op(0x8125) // SUB V1, V2
+          .op(0x8231) // OR V2, V3
+          .op(0x8342) // AND V3, V4
+          .op(0x8453) // XOR V4, V5
+          .op(0x8566) // SHR V5
+          .op(0x867E) // SHL V6
+          .op(0x8707) // SUBN V7, V0
+          .op(0x7013) // ADD V0, 0x13
+          .op(0x8170) // LD V1, V7
+          .op(0x1000 | loop);
+      return a.bytes();
+    }
+
+    std::vector<std::uint8_t> spriteLoop()
+    {
+      Assembler a;
+      a.op(0xA300) // LD I, sprite
+          .op(0x6000)
+          .op(0x6100);
+      const std::uint16_t loop = a.here();
+      a.op(0xD01F)  // DRW V0, V1, 15
+          .op(0x7009) // ADD V0, 9
+          .op(0xD018) // DRW V0, V1, 8
+          .op(0x7105) // ADD V1, 5
+          .op(0xD015) // DRW V0, V1, 5
+          .op(0x1000 | loop);
+      a.org(0x300).data({0xFF, 0x81, 0xBD, 0xA5, 0xA5, 0xBD, 0x81, 0xFF, 0x3C, 0x42, 0x99, 0xA5, 0x99, 0x42, 0x3C});
+      return a.bytes();
+    }
+
+    std::vector<std::uint8_t> blockMoveLoop()
+    {
+      Assembler a;
+      a.op(0xA400); // LD I, buffer
+      const std::uint16_t loop = a.here();
+      a.op(0xFF55)  // LD [I], VF
+          .op(0xFF65) // LD VF, [I]
+          .op(0xF755) // LD [I], V7
+          .op(0xF765) // LD V7, [I]
+          .op(0x7001) // ADD V0, 1
+          .op(0x1000 | loop);
+      return a.bytes();
+    }
+
+    std::vector<std::uint8_t> bcdLoop()
+    {
+      Assembler a;
+      a.op(0xA400) // LD I, buffer
+          .op(0x60FE)
+          .op(0x6163);
+      const std::uint16_t loop = a.here();
+      a.op(0xF033)  // LD B, V0
+          .op(0xF133) // LD B, V1
+          .op(0x7007) // ADD V0, 7
+          .op(0x7103) // ADD V1, 3
+          .op(0x1000 | loop);
+      return a.bytes();
+    }
+
+    std::vector<std::uint8_t> callChain()
+    {
+      // main loop calls the first of eight nested subroutines, each calls the next before returning
+      constexpr std::uint16_t FIRST = 0x300;
+      constexpr int DEPTH = 8;
+      Assembler a;
+      const std::uint16_t loop = a.here();
+      a.op(0x2000 | FIRST).op(0x1000 | loop);
+      a.org(FIRST);
+      for (int level = 0; level < DEPTH; ++level)
+      {
+        if (level + 1 < DEPTH)
+        {
+          a.op(0x2000 | (a.here() + 6)); // CALL next level
+        }
+        a.op(0x7001).op(0x00EE); // ADD V0, 1 / RET
+      }
+      return a.bytes();
+    }
+  } // namespace
+
+  std::vector<SyntheticRom> syntheticRoms()
+  {
+    return {
+        {"alu", "8xy arithmetic and logic, 6xkk and 7xkk in a tight loop", aluLoop()},
+        {"sprite", "Dxyn sprite blits of 15, 8 and 5 rows", spriteLoop()},
+        {"block_move", "Fx55 and Fx65 register block stores and loads", blockMoveLoop()},
+        {"bcd", "Fx33 BCD conversions", bcdLoop()},
+        {"call_chain", "2nnn and 00EE through eight nested subroutines", callChain()},
+    };
+  }
+
+} // namespace bench
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+  // a ROM built in memory, loaded at 0x200 and looping forever so any instruction budget can be run on it
+  struct SyntheticRom
+  {
+    std::string name;
+    std::string description;
+    std::vector<std::uint8_t> bytes;
+  };
+
+  /**
+   * @brief Every synthetic ROM, each one stressing a single kind of instruction
+   */
+  std::vector<SyntheticRom> syntheticRoms();
+
+} // namespace bench
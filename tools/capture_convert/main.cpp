@@ -0,0 +1,76 @@
+#include "delta_stream.hpp"
+#include "frame_encoder.hpp"
+#include "messages.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+namespace
+{
+  void printUsage(emulator::utils::Messenger &messenger)
+  {
+    messenger.printMessage("Usage: chip8_capture_convert [--every-frame] capture.c8v directory\n",
+                           "  --every-frame  write a PNG for every frame, repeating unchanged screens, instead of one per captured frame");
+  }
+
+  bool writeFrame(const std::filesystem::path &directory, const emulator::interpreter::FrameBuffer &screen, const std::uint64_t frame)
+  {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%08llu.png", static_cast<unsigned long long>(frame));
+    return emulator::capture::writePng(directory / name, screen) == emulator::utils::Result::Success;
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  emulator::utils::Messenger messenger;
+  bool every_frame = false;
+  int first = 1;
+  if (first < argc && std::strcmp(argv[first], "--every-frame") == 0)
+  {
+    every_frame = true;
+    ++first;
+  }
+  if (argc - first != 2)
+  {
+    printUsage(messenger);
+    return 1;
+  }
+  auto reader = emulator::capture::DeltaStreamReader::open(argv[first]);
+  if (!reader)
+  {
+    messenger.log<emulator::utils::Level::Error>(argv[first], " is not a capture");
+    return 1;
+  }
+  const std::filesystem::path directory = argv[first + 1];
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+
+  emulator::interpreter::FrameBuffer screen;
+  emulator::interpreter::FrameBuffer previous;
+  std::uint64_t frame = 0;
+  std::uint64_t last = 0;
+  std::uint64_t written = 0;
+  bool started = false;
+  while (reader->next(screen, frame))
+  {
+    // frames that were not captured showed the screen of the one before
+    for (std::uint64_t repeat = last + 1; every_frame && started && repeat < frame; ++repeat)
+    {
+      written += writeFrame(directory, previous, repeat) ? 1 : 0;
+    }
+    written += writeFrame(directory, screen, frame) ? 1 : 0;
+    previous = screen;
+    last = frame;
+    started = true;
+  }
+  if (reader->damaged())
+  {
+    messenger.log<emulator::utils::Level::Warning>("The capture is damaged after frame ", last, ", the rest is skipped");
+  }
+  messenger.printMessage("Wrote ", written, " frames to ", directory.string());
+  return 0;
+}
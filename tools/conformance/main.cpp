@@ -0,0 +1,308 @@
+#include "interpreter.hpp"
+#include "messages.hpp"
+#include "parse.hpp"
+#include "rom_store.hpp"
+#include "vector_machine.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  struct Options
+  {
+    std::size_t frames = 1200;  // 20 seconds of emulated time at 60 Hz
+    std::size_t ipf = 10;       // instructions per frame
+    std::filesystem::path rom_cache = emulator::rom::RomStore::defaultCacheDirectory();
+    std::vector<std::string> roms;
+  };
+
+  // how a ROM ended on one engine
+  struct Outcome
+  {
+    std::size_t instructions = 0;
+    std::uint64_t hash = 0;
+    std::unique_ptr<emulator::interpreter::Snapshot> state = std::make_unique<emulator::interpreter::Snapshot>();
+  };
+
+  // CHIP-8 ROMs also run on this many lanes of a VectorMachine, deliberately not a whole number of SIMD registers
+  constexpr std::size_t VECTOR_LANES = 37;
+
+  constexpr emulator::utils::Engine ENGINES[] = {emulator::utils::Engine::Switch, emulator::utils::Engine::Cached, emulator::utils::Engine::Jit};
+
+  const char *engineName(const emulator::utils::Engine engine)
+  {
+    switch (engine)
+    {
+    case emulator::utils::Engine::Switch:
+      return "switch";
+    case emulator::utils::Engine::Cached:
+      return "cached";
+    default:
+      return "jit";
+    }
+  }
+
+  void printUsage(emulator::utils::Messenger &messenger)
+  {
+    messenger.printMessage("Usage: chip8_conformance [options] rom|directory [rom|directory...]\n",
+                           "  --frames N     frames to emulate per ROM (default 1200)\n",
+                           "  --ipf N        instructions per frame (default 10)\n",
+                           "  --rom-cache D  directory analysed ROMs are kept in, or off (default ~/.cache/chip8_emu)");
+  }
+
+  // every .ch8 file of a directory in name order, or the file itself
+  void addRoms(const std::filesystem::path &path, std::vector<std::string> &roms)
+  {
+    if (!std::filesystem::is_directory(path))
+    {
+      roms.push_back(path.string());
+      return;
+    }
+    std::vector<std::string> found;
+    for (const auto &entry : std::filesystem::directory_iterator(path))
+    {
+      if (entry.is_regular_file() && entry.path().extension() == ".ch8")
+      {
+        found.push_back(entry.path().string());
+      }
+    }
+    std::sort(found.begin(), found.end());
+    roms.insert(roms.end(), found.begin(), found.end());
+  }
+
+  std::optional<Options> parseOptions(int argc, char **argv, emulator::utils::Messenger &messenger)
+  {
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+      const char *arg = argv[i];
+      std::size_t *target = nullptr;
+      if (std::strcmp(arg, "--frames") == 0)
+      {
+        target = &options.frames;
+      }
+      else if (std::strcmp(arg, "--ipf") == 0)
+      {
+        target = &options.ipf;
+      }
+      else if (std::strcmp(arg, "--rom-cache") == 0 && i + 1 < argc)
+      {
+        const char *directory = argv[++i];
+        options.rom_cache = (std::strcmp(directory, "off") == 0) ? std::filesystem::path() : std::filesystem::path(directory);
+        continue;
+      }
+      else if (std::strcmp(arg, "--help") == 0 || arg[0] == '-')
+      {
+        return std::nullopt;
+      }
+      else
+      {
+        addRoms(arg, options.roms);
+        continue;
+      }
+      const auto value = (i + 1 < argc) ? emulator::utils::parseCount(argv[++i]) : std::nullopt;
+      if (!value)
+      {
+        messenger.printMessage("Missing or invalid value for ", arg);
+        return std::nullopt;
+      }
+      *target = *value;
+    }
+    if (options.roms.empty())
+    {
+      return std::nullopt;
+    }
+    return options;
+  }
+
+  // the keys held down during a frame, the same on every engine so key-driven branches are exercised too
+  bool keyDown(const std::size_t frame, const std::uint8_t key)
+  {
+    return (frame / 8) % 16 == key;
+  }
+
+  // the first part of two machine states that differs, nothing if they are the same
+  std::optional<std::string> compareStates(const emulator::interpreter::Snapshot &a, const emulator::interpreter::Snapshot &b)
+  {
+    if (std::memcmp(&a.screen, &b.screen, sizeof(a.screen)) != 0)
+    {
+      return std::string("screen");
+    }
+    if (a.pc != b.pc || a.I != b.I || a.sp != b.sp || std::memcmp(a.V, b.V, sizeof(a.V)) != 0 ||
+        std::memcmp(a.stack, b.stack, sizeof(a.stack)) != 0 || a.delay_timer != b.delay_timer ||
+        a.sound_timer != b.sound_timer || a.random_state != b.random_state)
+    {
+      return std::string("registers");
+    }
+    if (std::memcmp(a.memory, b.memory, sizeof(a.memory)) != 0)
+    {
+      return std::string("memory");
+    }
+    if (std::memcmp(&a, &b, sizeof(a)) != 0)
+    {
+      return std::string("flags or audio");
+    }
+    return std::nullopt;
+  }
+
+  std::optional<Outcome> runRom(const emulator::rom::RomImage &image, const emulator::utils::Engine engine, const Options &options,
+                                emulator::utils::Messenger &messenger)
+  {
+    emulator::interpreter::Chip8 chip8(messenger);
+    chip8.setEngine(engine);
+    if (image.loadInto(chip8) == emulator::utils::Result::Failure)
+    {
+      return std::nullopt;
+    }
+    Outcome outcome;
+    for (std::size_t frame = 0; frame < options.frames && chip8.shouldTerminate() == emulator::utils::Flag::Lowered; ++frame)
+    {
+      for (std::uint8_t key = 0; key < 16; ++key)
+      {
+        chip8.setKey(key, keyDown(frame, key));
+      }
+      outcome.instructions += chip8.run(options.ipf);
+      chip8.tickTimers();
+    }
+    outcome.hash = chip8.hashGraphicsBuffer();
+    chip8.saveState(*outcome.state);
+    return outcome;
+  }
+
+  // the first part of the machine two runs disagree on, nothing if they ended the same
+  std::optional<std::string> compare(const Outcome &expected, const Outcome &actual)
+  {
+    if (expected.instructions != actual.instructions)
+    {
+      return "executed " + std::to_string(actual.instructions) + " instructions instead of " + std::to_string(expected.instructions);
+    }
+    if (expected.hash != actual.hash)
+    {
+      return std::string("screen");
+    }
+    return compareStates(*expected.state, *actual.state);
+  }
+
+  // run a CHIP-8 ROM on every lane of a VectorMachine, each lane with its own seed and keys, and on one Chip8 per lane,
+  // the first lane that ends differently from its Chip8 and how, nothing if every lane matched
+  std::optional<std::string> compareVector(const emulator::rom::RomImage &image, const Options &options, emulator::utils::Messenger &messenger)
+  {
+    std::vector<std::unique_ptr<emulator::interpreter::Chip8>> machines;
+    emulator::vector::VectorMachine vector(VECTOR_LANES);
+    auto state = std::make_unique<emulator::interpreter::Snapshot>();
+    for (std::size_t lane = 0; lane < VECTOR_LANES; ++lane)
+    {
+      auto chip8 = std::make_unique<emulator::interpreter::Chip8>(messenger);
+      chip8->setEngine(emulator::utils::Engine::Switch);
+      if (image.loadInto(*chip8) == emulator::utils::Result::Failure)
+      {
+        return std::string("failed to load");
+      }
+      chip8->seed(emulator::interpreter::DEFAULT_SEED + lane);
+      chip8->saveState(*state);
+      vector.load(lane, *state);
+      machines.push_back(std::move(chip8));
+    }
+    // a lane stops for good on an unknown opcode while its timers keep running, so every frame is run on both sides
+    for (std::size_t frame = 0; frame < options.frames; ++frame)
+    {
+      for (std::size_t lane = 0; lane < VECTOR_LANES; ++lane)
+      {
+        for (std::uint8_t key = 0; key < 16; ++key)
+        {
+          const bool down = keyDown(frame + lane * 5, key);
+          machines[lane]->setKey(key, down);
+          vector.setKey(lane, key, down);
+        }
+        machines[lane]->run(options.ipf);
+        machines[lane]->tickTimers();
+      }
+      vector.step(options.ipf);
+      vector.tickTimers();
+    }
+    auto lane_state = std::make_unique<emulator::interpreter::Snapshot>();
+    for (std::size_t lane = 0; lane < VECTOR_LANES; ++lane)
+    {
+      machines[lane]->saveState(*state);
+      vector.saveState(lane, *lane_state);
+      const bool terminated = machines[lane]->shouldTerminate() == emulator::utils::Flag::Raised;
+      if (terminated != vector.terminated(lane))
+      {
+        return "lane " + std::to_string(lane) + (terminated ? " kept running" : " stopped");
+      }
+      if (const auto difference = compareStates(*state, *lane_state))
+      {
+        return "lane " + std::to_string(lane) + " " + *difference;
+      }
+    }
+    return std::nullopt;
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  emulator::utils::Messenger messenger;
+  const auto options = parseOptions(argc, argv, messenger);
+  if (!options)
+  {
+    printUsage(messenger);
+    return 1;
+  }
+
+  emulator::rom::RomStore roms(options->rom_cache);
+  std::size_t failures = 0;
+  for (const std::string &rom : options->roms)
+  {
+    std::ostringstream line;
+    line << std::left << std::setw(24) << std::filesystem::path(rom).filename().string() << std::right;
+    const auto image = roms.load(rom, messenger);
+    std::vector<Outcome> outcomes;
+    for (const auto engine : ENGINES)
+    {
+      auto outcome = image ? runRom(*image, engine, *options, messenger) : std::nullopt;
+      if (!outcome)
+      {
+        break;
+      }
+      outcomes.push_back(std::move(*outcome));
+    }
+    if (outcomes.size() != std::size(ENGINES))
+    {
+      ++failures;
+      messenger.printMessage(line.str(), "  failed to load");
+      continue;
+    }
+    // the switch engine is the reference every other engine has to match
+    std::string mismatches;
+    for (std::size_t i = 1; i < outcomes.size(); ++i)
+    {
+      if (const auto difference = compare(outcomes[0], outcomes[i]))
+      {
+        mismatches += std::string(mismatches.empty() ? "" : ", ") + engineName(ENGINES[i]) + " differs: " + *difference;
+      }
+    }
+    if (image->analysis.platform == emulator::utils::Platform::Chip8)
+    {
+      if (const auto difference = compareVector(*image, *options, messenger))
+      {
+        mismatches += std::string(mismatches.empty() ? "" : ", ") + "vector differs: " + *difference;
+      }
+    }
+    failures += mismatches.empty() ? 0 : 1;
+    line << std::setw(12) << outcomes[0].instructions << "  " << std::hex << std::setw(16) << std::setfill('0')
+         << outcomes[0].hash << "  " << (mismatches.empty() ? "ok" : mismatches);
+    messenger.printMessage(line.str());
+  }
+  messenger.printMessage(options->roms.size() - failures, " of ", options->roms.size(), " ROM(s) ran the same on every engine and, for CHIP-8 ROMs, on the vector machine");
+  return (failures == 0) ? 0 : 1;
+}
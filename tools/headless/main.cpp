@@ -0,0 +1,346 @@
+#include "input_log.hpp"
+#include "interpreter.hpp"
+#include "messages.hpp"
+#include "parse.hpp"
+#include "replayer.hpp"
+#include "rom_store.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+  struct Options
+  {
+    std::size_t frames = 600;     // 10 seconds of emulated time at 60 Hz
+    std::size_t ipf = 10;         // instructions per frame
+    std::size_t cycles = 0;       // hard cap on instructions per ROM, 0 means frames * ipf
+    std::size_t threads = 0;      // 0 picks one per hardware thread
+    emulator::utils::Engine engine = emulator::utils::Engine::Cached;
+    std::string profile;          // write every ROM's profile here as JSON, needs a CHIP8_PROFILE build
+    std::filesystem::path rom_cache = emulator::rom::RomStore::defaultCacheDirectory();
+    bool replay = false;          // the files are input logs recorded with chip8_emulator --record, not ROMs
+    std::vector<std::string> roms;
+  };
+
+  struct RomReport
+  {
+    emulator::utils::Result load_result = emulator::utils::Result::Failure;
+    std::size_t instructions = 0;
+    std::size_t frames = 0;
+    std::size_t draws = 0;
+    double seconds = 0.0;
+    std::uint64_t hash = 0;
+    bool terminated = false;
+    std::string profile_text;
+    std::string profile_json;
+  };
+
+  void printUsage(emulator::utils::Messenger &messenger)
+  {
+    messenger.printMessage("Usage: chip8_headless [options] rom [rom...]\n",
+                           "       chip8_headless [--engine E] [--threads N] --replay log [log...]\n",
+                           "  --frames N   frames to emulate per ROM (default 600)\n",
+                           "  --ipf N      instructions per frame (default 10)\n",
+                           "  --cycles N   cap on instructions per ROM (default frames * ipf)\n",
+                           "  --threads N  worker threads (default one per hardware thread)\n",
+                           "  --engine E   switch, cached or jit (default cached)\n",
+                           "  --profile F  print a profile of every ROM and write them to F as JSON (CHIP8_PROFILE builds only)\n",
+                           "  --rom-cache D  directory analysed ROMs are kept in, or off (default ~/.cache/chip8_emu)\n",
+                           "  --replay     play recorded sessions back and check their screen hashes");
+  }
+
+  std::optional<Options> parseOptions(int argc, char **argv, emulator::utils::Messenger &messenger)
+  {
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+      const char *arg = argv[i];
+      std::size_t *target = nullptr;
+      if (std::strcmp(arg, "--frames") == 0)
+      {
+        target = &options.frames;
+      }
+      else if (std::strcmp(arg, "--ipf") == 0)
+      {
+        target = &options.ipf;
+      }
+      else if (std::strcmp(arg, "--cycles") == 0)
+      {
+        target = &options.cycles;
+      }
+      else if (std::strcmp(arg, "--threads") == 0)
+      {
+        target = &options.threads;
+      }
+      else if (std::strcmp(arg, "--engine") == 0 && i + 1 < argc)
+      {
+        const char *name = argv[++i];
+        if (std::strcmp(name, "switch") == 0)
+        {
+          options.engine = emulator::utils::Engine::Switch;
+        }
+        else if (std::strcmp(name, "cached") == 0)
+        {
+          options.engine = emulator::utils::Engine::Cached;
+        }
+        else if (std::strcmp(name, "jit") == 0)
+        {
+          options.engine = emulator::utils::Engine::Jit;
+        }
+        else
+        {
+          messenger.printMessage("Unknown engine ", name);
+          return std::nullopt;
+        }
+        continue;
+      }
+      else if (std::strcmp(arg, "--profile") == 0 && i + 1 < argc)
+      {
+        if (!emulator::interpreter::PROFILING_ENABLED)
+        {
+          messenger.printMessage("--profile needs a build configured with -DCHIP8_PROFILE=ON");
+          return std::nullopt;
+        }
+        options.profile = argv[++i];
+        continue;
+      }
+      else if (std::strcmp(arg, "--rom-cache") == 0 && i + 1 < argc)
+      {
+        const char *directory = argv[++i];
+        options.rom_cache = (std::strcmp(directory, "off") == 0) ? std::filesystem::path() : std::filesystem::path(directory);
+        continue;
+      }
+      else if (std::strcmp(arg, "--replay") == 0)
+      {
+        options.replay = true;
+        continue;
+      }
+      else if (std::strcmp(arg, "--help") == 0 || arg[0] == '-')
+      {
+        return std::nullopt;
+      }
+      else
+      {
+        options.roms.emplace_back(arg);
+        continue;
+      }
+      const auto value = (i + 1 < argc) ? emulator::utils::parseCount(argv[++i]) : std::nullopt;
+      if (!value)
+      {
+        messenger.printMessage("Missing or invalid value for ", arg);
+        return std::nullopt;
+      }
+      *target = *value;
+    }
+    if (options.roms.empty())
+    {
+      return std::nullopt;
+    }
+    return options;
+  }
+
+  RomReport runRom(const std::string &rom, const Options &options, emulator::rom::RomStore &roms,
+                   emulator::utils::Messenger &messenger)
+  {
+    RomReport report;
+    emulator::interpreter::Chip8 chip8(messenger);
+    chip8.setEngine(options.engine);
+    const auto image = roms.load(rom, messenger);
+    report.load_result = image ? image->loadInto(chip8) : emulator::utils::Result::Failure;
+    if (report.load_result == emulator::utils::Result::Failure)
+    {
+      return report;
+    }
+    const std::size_t budget = (options.cycles == 0) ? options.frames * options.ipf : options.cycles;
+    const auto start = std::chrono::steady_clock::now();
+    while (report.frames < options.frames && report.instructions < budget)
+    {
+      const std::size_t cycles = std::min(options.ipf, budget - report.instructions);
+      report.instructions += chip8.run(cycles);
+      chip8.tickTimers();
+      ++report.frames;
+      if (chip8.shouldDraw() == emulator::utils::Flag::Raised)
+      {
+        ++report.draws;
+      }
+      if (chip8.shouldTerminate() == emulator::utils::Flag::Raised)
+      {
+        report.terminated = true;
+        break;
+      }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    report.seconds = elapsed.count();
+    report.hash = chip8.hashGraphicsBuffer();
+    if (const auto *profiler = chip8.profiler(); profiler && !options.profile.empty())
+    {
+      report.profile_text = profiler->report();
+      report.profile_json = profiler->toJson();
+    }
+    return report;
+  }
+
+  // plays one recorded session back, returns the line to print and whether it reproduced
+  std::pair<std::string, bool> replayLog(const std::string &path, const Options &options, emulator::rom::RomStore &roms,
+                                         emulator::utils::Messenger &messenger)
+  {
+    std::ostringstream line;
+    line << std::left << std::setw(32) << path << std::right << "  ";
+    const auto log = emulator::replay::InputLog::load(path);
+    if (!log)
+    {
+      line << "not an input log";
+      return {line.str(), false};
+    }
+    emulator::interpreter::Chip8 chip8(messenger);
+    chip8.setEngine(options.engine);
+    const auto image = roms.load(log->rom_path, messenger);
+    if (!image || image->loadInto(chip8, log->platform) == emulator::utils::Result::Failure)
+    {
+      line << "failed to load " << log->rom_path;
+      return {line.str(), false};
+    }
+    if (image->hash != log->rom_hash)
+    {
+      line << log->rom_path << " is not the ROM that was recorded";
+      return {line.str(), false};
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto report = emulator::scheduler::replay(chip8, *log);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    line << std::setw(8) << report.frames << " frames " << std::setw(4) << report.checkpoints << "/" << log->checkpoints.size()
+         << " checkpoints " << std::fixed << std::setprecision(3) << elapsed.count() << " s  ";
+    if (report.mismatch)
+    {
+      line << "diverged by frame " << report.mismatch->frame << ": expected " << std::hex << std::setfill('0')
+           << std::setw(16) << report.mismatch->hash << ", got " << std::setw(16) << report.actual;
+      return {line.str(), false};
+    }
+    if (report.frames != log->frames)
+    {
+      line << "ended early";
+      return {line.str(), false};
+    }
+    line << "ok";
+    return {line.str(), true};
+  }
+
+  std::string formatReport(const std::string &rom, const RomReport &report)
+  {
+    std::ostringstream line;
+    line << std::left << std::setw(32) << rom << std::right;
+    if (report.load_result == emulator::utils::Result::Failure)
+    {
+      line << "  failed to load";
+      return line.str();
+    }
+    const double ips = (report.seconds > 0.0) ? report.instructions / report.seconds : 0.0;
+    line << std::setw(12) << report.instructions
+         << std::setw(8) << report.frames
+         << std::setw(8) << report.draws
+         << std::setw(16) << std::fixed << std::setprecision(0) << ips
+         << "  " << std::hex << std::setw(16) << std::setfill('0') << report.hash
+         << (report.terminated ? "  (terminated)" : "");
+    return line.str();
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  emulator::utils::Messenger messenger;
+  const auto options = parseOptions(argc, argv, messenger);
+  if (!options)
+  {
+    printUsage(messenger);
+    return 1;
+  }
+
+  // shared by every worker, a ROM listed twice is only read and analysed once
+  emulator::rom::RomStore roms(options->rom_cache);
+  if (options->replay)
+  {
+    std::vector<std::pair<std::string, bool>> replays(options->roms.size());
+    {
+      emulator::utils::ThreadPool pool(options->threads);
+      for (std::size_t i = 0; i < options->roms.size(); ++i)
+      {
+        pool.submit([&, i]
+                    { replays[i] = replayLog(options->roms[i], *options, roms, messenger); });
+      }
+      pool.wait();
+    }
+    std::size_t failures = 0;
+    for (const auto &[line, reproduced] : replays)
+    {
+      failures += reproduced ? 0 : 1;
+      messenger.printMessage(line);
+    }
+    return (failures == 0) ? 0 : 1;
+  }
+
+  // every ROM gets its own Chip8 and its own report slot, so workers never share state
+  std::vector<RomReport> reports(options->roms.size());
+  const auto start = std::chrono::steady_clock::now();
+  {
+    emulator::utils::ThreadPool pool(options->threads);
+    for (std::size_t i = 0; i < options->roms.size(); ++i)
+    {
+      pool.submit([&, i]
+                  { reports[i] = runRom(options->roms[i], *options, roms, messenger); });
+    }
+    pool.wait();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::ostringstream header;
+  header << std::left << std::setw(32) << "rom" << std::right
+         << std::setw(12) << "instructions"
+         << std::setw(8) << "frames"
+         << std::setw(8) << "draws"
+         << std::setw(16) << "instr/s"
+         << "  " << std::setw(16) << "screen hash";
+  messenger.printMessage(header.str());
+  std::size_t failures = 0;
+  for (std::size_t i = 0; i < reports.size(); ++i)
+  {
+    failures += (reports[i].load_result == emulator::utils::Result::Failure) ? 1 : 0;
+    messenger.printMessage(formatReport(options->roms[i], reports[i]));
+  }
+  messenger.printMessage("Ran ", reports.size(), " ROM(s) in ", elapsed.count(), " s");
+
+  if (!options->profile.empty())
+  {
+    std::ofstream json(options->profile);
+    json << "{\"roms\": [";
+    bool first = true;
+    for (std::size_t i = 0; i < reports.size(); ++i)
+    {
+      if (reports[i].profile_json.empty())
+      {
+        continue;
+      }
+      messenger.printMessage("\nProfile of ", options->roms[i], ":\n", reports[i].profile_text);
+      json << (first ? "\n  " : ",\n  ") << "{\"rom\": \"" << options->roms[i] << "\", \"profile\": " << reports[i].profile_json << "}";
+      first = false;
+    }
+    json << "\n]}\n";
+    if (!json)
+    {
+      messenger.printMessage("Failed to write ", options->profile);
+      return 1;
+    }
+  }
+  return (failures == 0) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "aot_runner.hpp"
+
+#include "interpreter.hpp"
+#include "messages.hpp"
+#include "parse.hpp"
+#include "scheduler.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+
+namespace emulator::recompile
+{
+  namespace
+  {
+    struct Options
+    {
+      std::size_t frames = 600;   // 10 seconds of emulated time at 60 Hz
+      std::size_t runs = 1;
+      std::size_t cpu_hz = scheduler::DEFAULT_CPU_HZ;
+      std::size_t seed = interpreter::DEFAULT_SEED;
+      utils::Engine engine = utils::Engine::Cached;
+      bool check = false;
+    };
+
+    struct Totals
+    {
+      std::uint64_t instructions = 0;
+      std::uint64_t frames = 0;
+      std::uint64_t hash = 0; // of the screen the last run ended with
+      double seconds = 0.0;
+    };
+
+    void printUsage(const interpreter::AotProgram &program, utils::Messenger &messenger)
+    {
+      messenger.printMessage("Usage: ", program.name, " [options]\n",
+                             "  --frames N   frames to emulate per run (default 600)\n",
+                             "  --runs N     times to run the ROM from the start (default 1)\n",
+                             "  --cpu-hz N   instructions per second (default 700)\n",
+                             "  --seed N     seed of the RND instruction (default 200)\n",
+                             "  --engine E   switch, cached or jit for what the blocks leave to the interpreter (default cached)\n",
+                             "  --check      run the same frames on the interpreter alone and compare");
+    }
+
+    std::optional<Options> parseOptions(int argc, char **argv, utils::Messenger &messenger)
+    {
+      Options options;
+      for (int i = 1; i < argc; ++i)
+      {
+        const char *arg = argv[i];
+        std::size_t *target = nullptr;
+        // every value is a count except the seed, which may be 0 and is often written in hexadecimal
+        bool count = true;
+        if (std::strcmp(arg, "--frames") == 0)
+        {
+          target = &options.frames;
+        }
+        else if (std::strcmp(arg, "--runs") == 0)
+        {
+          target = &options.runs;
+        }
+        else if (std::strcmp(arg, "--cpu-hz") == 0)
+        {
+          target = &options.cpu_hz;
+        }
+        else if (std::strcmp(arg, "--seed") == 0)
+        {
+          target = &options.seed;
+          count = false;
+        }
+        else if (std::strcmp(arg, "--engine") == 0 && i + 1 < argc)
+        {
+          const char *name = argv[++i];
+          if (std::strcmp(name, "switch") == 0)
+          {
+            options.engine = utils::Engine::Switch;
+          }
+          else if (std::strcmp(name, "cached") == 0)
+          {
+            options.engine = utils::Engine::Cached;
+          }
+          else if (std::strcmp(name, "jit") == 0)
+          {
+            options.engine = utils::Engine::Jit;
+          }
+          else
+          {
+            messenger.printMessage("Unknown engine ", name);
+            return std::nullopt;
+          }
+          continue;
+        }
+        else if (std::strcmp(arg, "--check") == 0)
+        {
+          options.check = true;
+          continue;
+        }
+        else
+        {
+          return std::nullopt;
+        }
+        const char *text = (i + 1 < argc) ? argv[++i] : "";
+        const auto value = count ? utils::parseCount(text, 0) : utils::parseNumber(text, 0);
+        if (!value)
+        {
+          messenger.printMessage("Missing or invalid value for ", arg);
+          return std::nullopt;
+        }
+        *target = *value;
+      }
+      return options;
+    }
+
+    // run the ROM from the start runs times, on the recompiled blocks or, without a program, on the engine alone
+    std::optional<Totals> run(const interpreter::AotProgram &program, const interpreter::AotProgram *blocks, const Options &options, utils::Messenger &messenger)
+    {
+      interpreter::Chip8 chip8(messenger);
+      chip8.setEngine(options.engine);
+      chip8.setPlatform(program.platform);
+      if (chip8.loadRom(program.rom, program.rom_size) == utils::Result::Failure)
+      {
+        return std::nullopt;
+      }
+      chip8.seed(options.seed);
+      chip8.setProgram(blocks);
+      // every run starts over from here, loading a fork only puts back what the previous run changed
+      interpreter::MachineState start{};
+      chip8.fork(start);
+
+      Totals totals;
+      const auto begin = std::chrono::steady_clock::now();
+      for (std::size_t run = 0; run < options.runs; ++run)
+      {
+        chip8.loadState(start);
+        scheduler::Scheduler scheduler(options.cpu_hz);
+        while (scheduler.frame() < options.frames && chip8.shouldTerminate() == utils::Flag::Lowered)
+        {
+          totals.instructions += scheduler.runFrame(chip8);
+        }
+        totals.frames += scheduler.frame();
+      }
+      totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+      totals.hash = chip8.hashGraphicsBuffer();
+      return totals;
+    }
+
+    std::string describe(const Totals &totals)
+    {
+      std::ostringstream text;
+      text << totals.instructions << " instructions, " << totals.frames << " frames in " << std::fixed << std::setprecision(3) << totals.seconds << " s ("
+           << std::setprecision(1) << totals.instructions / totals.seconds / 1e6 << " M instructions/s, " << std::setprecision(0) << totals.frames / totals.seconds
+           << " frames/s), screen " << std::hex << totals.hash;
+      return text.str();
+    }
+  } // namespace
+
+  int runProgram(const interpreter::AotProgram &program, int argc, char **argv)
+  {
+    utils::Messenger messenger;
+    const auto options = parseOptions(argc, argv, messenger);
+    if (!options)
+    {
+      printUsage(program, messenger);
+      return 1;
+    }
+    const auto recompiled = run(program, &program, *options, messenger);
+    if (!recompiled)
+    {
+      return 1;
+    }
+    messenger.printMessage(program.name, " recompiled: ", describe(*recompiled));
+    if (!options->check)
+    {
+      return 0;
+    }
+    const auto interpreted = run(program, nullptr, *options, messenger);
+    if (!interpreted)
+    {
+      return 1;
+    }
+    messenger.printMessage(program.name, " interpreted: ", describe(*interpreted));
+    if (interpreted->hash != recompiled->hash || interpreted->instructions != recompiled->instructions)
+    {
+      messenger.log<utils::Level::Error>("The recompiled program does not match the interpreter");
+      return 1;
+    }
+    std::ostringstream speedup;
+    speedup << std::fixed << std::setprecision(2) << interpreted->seconds / recompiled->seconds;
+    messenger.printMessage("Same screen and instruction count, ", speedup.str(), "x the interpreter's speed");
+    return 0;
+  }
+
+} // namespace emulator::recompile
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "aot.hpp"
+
+namespace emulator::recompile
+{
+  /**
+   * @brief The main() of an executable built from a recompiled ROM: run it headless and report its speed and screen
+   * @details Takes --frames N, --runs N (start over from the loaded ROM that many times), --cpu-hz N, --seed N,
+   * --engine E (what runs the instructions the blocks leave out) and --check, which runs the same frames on the
+   * interpreter alone and fails unless both end with the same screen and instruction count
+   * @param program The recompiled ROM
+   * @return The exit code
+   */
+  int runProgram(const interpreter::AotProgram &program, int argc, char **argv);
+
+} // namespace emulator::recompile
@@ -0,0 +1,139 @@
+#include "messages.hpp"
+#include "recompiler.hpp"
+#include "rom_store.hpp"
+
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace
+{
+  struct Options
+  {
+    emulator::rom::RecompileOptions recompile;
+    std::filesystem::path rom_cache = emulator::rom::RomStore::defaultCacheDirectory();
+    std::string rom;
+    std::string output;
+    bool named = false;           // --name was given
+  };
+
+  void printUsage(emulator::utils::Messenger &messenger)
+  {
+    messenger.printMessage("Usage: chip8_recompile [options] rom output.cpp\n",
+                           "  --name N        C++ name of the program (default chip8_aot_ and the ROM's file name)\n",
+                           "  --platform P    chip8, schip or xochip (default the one the analysis finds)\n",
+                           "  --main          add a main() running the ROM headless, link with chip8_aot_runner\n",
+                           "  --rom-cache D   directory analysed ROMs are kept in, or off (default ~/.cache/chip8_emu)");
+  }
+
+  // the ROM's file name turned into a C++ identifier
+  std::string defaultName(const std::string &rom)
+  {
+    std::string name = "chip8_aot_" + std::filesystem::path(rom).stem().string();
+    for (char &c : name)
+    {
+      if (!std::isalnum(static_cast<unsigned char>(c)))
+      {
+        c = '_';
+      }
+    }
+    return name;
+  }
+
+  std::optional<Options> parseOptions(int argc, char **argv, emulator::utils::Messenger &messenger)
+  {
+    Options options;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+      const char *arg = argv[i];
+      if (std::strcmp(arg, "--name") == 0 && i + 1 < argc)
+      {
+        options.recompile.name = argv[++i];
+        options.named = true;
+      }
+      else if (std::strcmp(arg, "--platform") == 0 && i + 1 < argc)
+      {
+        const char *name = argv[++i];
+        if (std::strcmp(name, "chip8") == 0)
+        {
+          options.recompile.platform = emulator::utils::Platform::Chip8;
+        }
+        else if (std::strcmp(name, "schip") == 0)
+        {
+          options.recompile.platform = emulator::utils::Platform::SuperChip;
+        }
+        else if (std::strcmp(name, "xochip") == 0)
+        {
+          options.recompile.platform = emulator::utils::Platform::XoChip;
+        }
+        else
+        {
+          messenger.printMessage("Unknown platform ", name);
+          return std::nullopt;
+        }
+      }
+      else if (std::strcmp(arg, "--main") == 0)
+      {
+        options.recompile.main = true;
+      }
+      else if (std::strcmp(arg, "--rom-cache") == 0 && i + 1 < argc)
+      {
+        const char *directory = argv[++i];
+        options.rom_cache = (std::strcmp(directory, "off") == 0) ? std::filesystem::path() : std::filesystem::path(directory);
+      }
+      else if (std::strcmp(arg, "--help") == 0 || arg[0] == '-')
+      {
+        return std::nullopt;
+      }
+      else
+      {
+        files.emplace_back(arg);
+      }
+    }
+    if (files.size() != 2)
+    {
+      return std::nullopt;
+    }
+    options.rom = files[0];
+    options.output = files[1];
+    options.recompile.source_name = std::filesystem::path(options.rom).filename().string();
+    if (!options.named)
+    {
+      options.recompile.name = defaultName(options.rom);
+    }
+    return options;
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  emulator::utils::Messenger messenger;
+  const auto options = parseOptions(argc, argv, messenger);
+  if (!options)
+  {
+    printUsage(messenger);
+    return 1;
+  }
+  emulator::rom::RomStore roms(options->rom_cache);
+  const auto image = roms.load(options->rom, messenger);
+  if (!image)
+  {
+    return 1;
+  }
+  const emulator::rom::RecompiledRom recompiled = emulator::rom::recompile(*image, options->recompile);
+  std::ofstream out(options->output, std::ios::binary | std::ios::trunc);
+  out << recompiled.source;
+  if (!out.flush())
+  {
+    messenger.log<emulator::utils::Level::Error>("Failed to write ", options->output);
+    return 1;
+  }
+  messenger.printMessage("Wrote ", options->recompile.name, " to ", options->output, ": ", recompiled.blocks, " blocks, ",
+                         recompiled.translated, " instructions translated, ", recompiled.interpreted, " left to the interpreter");
+  return 0;
+}
@@ -0,0 +1,223 @@
+#include "input_log.hpp"
+#include "messages.hpp"
+#include "parse.hpp"
+#include "rom_store.hpp"
+#include "search.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <string>
+
+namespace
+{
+  struct Options
+  {
+    emulator::search::SearchOptions search;
+    std::size_t score_address = 0;
+    std::size_t score_bytes = 1;
+    bool has_score = false;
+    std::filesystem::path rom_cache = emulator::rom::RomStore::defaultCacheDirectory();
+    std::string record;           // write the best sequence here as an input log
+    std::string rom;
+  };
+
+  void printUsage(emulator::utils::Messenger &messenger)
+  {
+    messenger.printMessage("Usage: chip8_solve --score ADDR [options] rom\n",
+                           "  --score ADDR     memory address of the number to maximise, decimal or 0x hex\n",
+                           "  --score-bytes N  size of that number in bytes, big-endian (default 1)\n",
+                           "  --beam W         beam search keeping W states per step (the default, W = 64)\n",
+                           "  --mcts N         Monte Carlo tree search with N playouts instead\n",
+                           "  --horizon N      steps to look ahead (default 60)\n",
+                           "  --hold N         frames every step holds its keys for (default 4)\n",
+                           "  --cpu-hz N       instructions per second (default 700)\n",
+                           "  --threads N      worker threads (default one per hardware thread)\n",
+                           "  --engine E       switch, cached or jit (default cached)\n",
+                           "  --seed N         seed of the RND instruction (default 200)\n",
+                           "  --rom-cache D    directory analysed ROMs are kept in, or off (default ~/.cache/chip8_emu)\n",
+                           "  --record F       save the best sequence as an input log for --replay");
+  }
+
+  std::optional<Options> parseOptions(int argc, char **argv, emulator::utils::Messenger &messenger)
+  {
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+      const char *arg = argv[i];
+      std::size_t *target = nullptr;
+      if (std::strcmp(arg, "--score") == 0)
+      {
+        target = &options.score_address;
+        options.has_score = true;
+      }
+      else if (std::strcmp(arg, "--score-bytes") == 0)
+      {
+        target = &options.score_bytes;
+      }
+      else if (std::strcmp(arg, "--beam") == 0)
+      {
+        target = &options.search.beam_width;
+        options.search.strategy = emulator::search::Strategy::Beam;
+      }
+      else if (std::strcmp(arg, "--mcts") == 0)
+      {
+        target = &options.search.playouts;
+        options.search.strategy = emulator::search::Strategy::Mcts;
+      }
+      else if (std::strcmp(arg, "--horizon") == 0)
+      {
+        target = &options.search.horizon;
+      }
+      else if (std::strcmp(arg, "--hold") == 0)
+      {
+        target = &options.search.frames_per_step;
+      }
+      else if (std::strcmp(arg, "--cpu-hz") == 0)
+      {
+        target = &options.search.cpu_hz;
+      }
+      else if (std::strcmp(arg, "--threads") == 0)
+      {
+        target = &options.search.threads;
+      }
+      else if (std::strcmp(arg, "--seed") == 0 && i + 1 < argc)
+      {
+        const auto seed = emulator::utils::parseNumber(argv[++i], 0);
+        if (!seed)
+        {
+          messenger.printMessage("Invalid seed ", argv[i]);
+          return std::nullopt;
+        }
+        options.search.seed = *seed;
+        continue;
+      }
+      else if (std::strcmp(arg, "--engine") == 0 && i + 1 < argc)
+      {
+        const char *name = argv[++i];
+        if (std::strcmp(name, "switch") == 0)
+        {
+          options.search.engine = emulator::utils::Engine::Switch;
+        }
+        else if (std::strcmp(name, "cached") == 0)
+        {
+          options.search.engine = emulator::utils::Engine::Cached;
+        }
+        else if (std::strcmp(name, "jit") == 0)
+        {
+          options.search.engine = emulator::utils::Engine::Jit;
+        }
+        else
+        {
+          messenger.printMessage("Unknown engine ", name);
+          return std::nullopt;
+        }
+        continue;
+      }
+      else if (std::strcmp(arg, "--rom-cache") == 0 && i + 1 < argc)
+      {
+        const char *directory = argv[++i];
+        options.rom_cache = (std::strcmp(directory, "off") == 0) ? std::filesystem::path() : std::filesystem::path(directory);
+        continue;
+      }
+      else if (std::strcmp(arg, "--record") == 0 && i + 1 < argc)
+      {
+        options.record = argv[++i];
+        continue;
+      }
+      else if (std::strcmp(arg, "--help") == 0 || arg[0] == '-' || !options.rom.empty())
+      {
+        return std::nullopt;
+      }
+      else
+      {
+        options.rom = arg;
+        continue;
+      }
+      const auto value = (i + 1 < argc) ? emulator::utils::parseNumber(argv[++i], 0) : std::nullopt;
+      if (!value)
+      {
+        messenger.printMessage("Missing or invalid value for ", arg);
+        return std::nullopt;
+      }
+      *target = *value;
+    }
+    if (options.rom.empty() || !options.has_score || options.search.frames_per_step == 0 || options.search.cpu_hz == 0)
+    {
+      return std::nullopt;
+    }
+    return options;
+  }
+
+  // the keys of every step, as the hex digits of the keys held or - for none
+  std::string describeInputs(const std::vector<emulator::search::KeyMask> &inputs)
+  {
+    std::ostringstream text;
+    for (const emulator::search::KeyMask keys : inputs)
+    {
+      text << ' ';
+      if (keys == 0)
+      {
+        text << '-';
+      }
+      for (int key = 0; key < 16; ++key)
+      {
+        if (keys >> key & 1)
+        {
+          text << std::hex << std::uppercase << key;
+        }
+      }
+    }
+    return text.str();
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  emulator::utils::Messenger messenger;
+  const auto options = parseOptions(argc, argv, messenger);
+  if (!options)
+  {
+    printUsage(messenger);
+    return 1;
+  }
+  emulator::rom::RomStore roms(options->rom_cache);
+  const auto image = roms.load(options->rom, messenger);
+  if (!image)
+  {
+    return 1;
+  }
+  const auto score = emulator::search::scoreAt(options->score_address, options->score_bytes);
+  const auto result = emulator::search::search(*image, score, options->search, messenger);
+  if (!result)
+  {
+    messenger.log<emulator::utils::Level::Error>("Failed to load ", options->rom);
+    return 1;
+  }
+
+  std::ostringstream speed;
+  speed << std::fixed << std::setprecision(2) << result->frames / result->seconds / 1e6;
+  messenger.printMessage("Best score ", result->score, " after ", result->inputs.size(), " steps of ", options->search.frames_per_step, " frames\n",
+                         "Keys:", describeInputs(result->inputs), "\n",
+                         "Emulated ", result->frames, " frames in ", result->seconds, " s (", speed.str(), " M frames/s, ", result->steals, " steals)");
+
+  if (!options->record.empty())
+  {
+    auto log = emulator::search::recordSession(*image, result->inputs, options->search, messenger);
+    if (!log)
+    {
+      return 1;
+    }
+    log->rom_path = std::filesystem::absolute(options->rom).string();
+    if (log->save(options->record) == emulator::utils::Result::Failure)
+    {
+      messenger.log<emulator::utils::Level::Error>("Failed to write ", options->record);
+      return 1;
+    }
+    messenger.printMessage("Recorded the sequence to ", options->record);
+  }
+  return 0;
+}